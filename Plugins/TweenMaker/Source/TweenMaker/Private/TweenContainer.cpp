@@ -1,6 +1,7 @@
 // Copyright 2018 Francesco Desogus. All Rights Reserved.
 
 #include "TweenContainer.h"
+#include "TweenMaker.h"
 #include "TweenFactory/Standard/TweenVectorStandardFactory.h"
 #include "TweenFactory/Standard/TweenVector2DStandardFactory.h"
 #include "TweenFactory/Standard/TweenRotatorStandardFactory.h"
@@ -75,6 +76,7 @@ void UTweenContainer::AddSequenceTween(UBaseTween* pNewTween, int32 pSequenceId)
     }
 
     // Adding the Tween at the given sequence id
+    LLM_SCOPE_BYTAG(TweenMaker_Containers);
     mSequences.Insert(FParallelTween(pNewTween), pSequenceId);
 }
 
@@ -96,6 +98,7 @@ void UTweenContainer::AddParallelTween(UBaseTween* pNewTween, int32 pSequenceId)
         }
 
         // Adding the parallel Tween
+        LLM_SCOPE_BYTAG(TweenMaker_Containers);
         mSequences[pSequenceId].ParallelTweens.Add(pNewTween);
     }
     else
@@ -7,6 +7,7 @@
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Components/Widget.h"
 #include "TweenContainer.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenFloatLatentFactory::UTweenFloatLatentFactory(const FObjectInitializer& ObjectInitializer)
@@ -1268,6 +1269,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForAppendTweenFlo
                                                                                    UTweenFloat*& OutTween,
                                                                                    FName pParameterName)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1320,6 +1322,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForJoinTweenFloat
                                                                                  UTweenFloat*& OutTween,
                                                                                  FName pParameterName)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1377,6 +1380,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForAppendTweenRot
                                                                                                bool pTweenWhileGameIsPaused,
                                                                                                UTweenFloat*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1439,6 +1443,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForJoinTweenRotat
                                                                                              bool pTweenWhileGameIsPaused,
                                                                                              UTweenFloat*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1499,6 +1504,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForAppendTweenFol
                                                                                           bool pTweenWhileGameIsPaused,
                                                                                           UTweenFloat*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1559,6 +1565,7 @@ UTweenFloatLatentFactory* UTweenFloatLatentFactory::CreateProxyForJoinTweenFollo
                                                                                         bool pTweenWhileGameIsPaused,
                                                                                         UTweenFloat*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenFloatLatentFactory* proxy = NewObject<UTweenFloatLatentFactory>();
 
     if (pTweenContainer != nullptr)
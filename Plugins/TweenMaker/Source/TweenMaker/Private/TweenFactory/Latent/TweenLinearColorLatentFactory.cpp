@@ -5,6 +5,7 @@
 #include "Tweens/TweenRotator.h"
 #include "TweenContainer.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenLinearColorLatentFactory::UTweenLinearColorLatentFactory(const FObjectInitializer& ObjectInitializer)
@@ -234,6 +235,7 @@ UTweenLinearColorLatentFactory* UTweenLinearColorLatentFactory::CreateProxyForAp
                                                                                                         bool pTweenWhileGameIsPaused,
                                                                                                         UTweenLinearColor*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenLinearColorLatentFactory* proxy = NewObject<UTweenLinearColorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -287,6 +289,7 @@ UTweenLinearColorLatentFactory* UTweenLinearColorLatentFactory::CreateProxyForJo
                                                                                                       bool pTweenWhileGameIsPaused,
                                                                                                       UTweenLinearColor*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenLinearColorLatentFactory* proxy = NewObject<UTweenLinearColorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -5,6 +5,7 @@
 #include "GameFramework/Actor.h"
 #include "Tweens/TweenRotator.h"
 #include "TweenContainer.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenRotatorLatentFactory::UTweenRotatorLatentFactory(const FObjectInitializer& ObjectInitializer)
@@ -516,6 +517,7 @@ UTweenRotatorLatentFactory* UTweenRotatorLatentFactory::CreateProxyForAppendTwee
                                                                                          bool pTweenWhileGameIsPaused,
                                                                                          UTweenRotator*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenRotatorLatentFactory* proxy = NewObject<UTweenRotatorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -576,6 +578,7 @@ UTweenRotatorLatentFactory* UTweenRotatorLatentFactory::CreateProxyForJoinTweenR
                                                                                        bool pTweenWhileGameIsPaused,
                                                                                        UTweenRotator*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenRotatorLatentFactory* proxy = NewObject<UTweenRotatorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -5,6 +5,7 @@
 #include "Components/Widget.h"
 #include "Tweens/TweenVector2D.h"
 #include "TweenContainer.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenVector2DLatentFactory::UTweenVector2DLatentFactory(const FObjectInitializer& ObjectInitializer)
@@ -591,6 +592,7 @@ UTweenVector2DLatentFactory* UTweenVector2DLatentFactory::CreateProxyForAppendTw
                                                                                             bool pTweenWhileGameIsPaused,
                                                                                             UTweenVector2D*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenVector2DLatentFactory* proxy = NewObject<UTweenVector2DLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -641,6 +643,7 @@ UTweenVector2DLatentFactory* UTweenVector2DLatentFactory::CreateProxyForJoinTwee
                                                                                           bool pTweenWhileGameIsPaused,
                                                                                           UTweenVector2D*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenVector2DLatentFactory* proxy = NewObject<UTweenVector2DLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -5,6 +5,7 @@
 #include "GameFramework/Actor.h"
 #include "Tweens/TweenRotator.h"
 #include "TweenContainer.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenVectorLatentFactory::UTweenVectorLatentFactory(const FObjectInitializer& ObjectInitializer)
@@ -1012,6 +1013,7 @@ UTweenVectorLatentFactory* UTweenVectorLatentFactory::CreateProxyForAppendTweenV
                                                                                       bool pTweenWhileGameIsPaused,
                                                                                       UTweenVector*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenVectorLatentFactory* proxy = NewObject<UTweenVectorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -1068,6 +1070,7 @@ UTweenVectorLatentFactory* UTweenVectorLatentFactory::CreateProxyForJoinTweenVec
                                                                                     bool pTweenWhileGameIsPaused,
                                                                                     UTweenVector*& OutTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Factories);
     UTweenVectorLatentFactory* proxy = NewObject<UTweenVectorLatentFactory>();
 
     if (pTweenContainer != nullptr)
@@ -2,6 +2,12 @@
 
 #include "TweenMaker.h"
 
+LLM_DEFINE_TAG(TweenMaker);
+LLM_DEFINE_TAG(TweenMaker_Containers, TEXT("Containers"), TEXT("TweenMaker"));
+LLM_DEFINE_TAG(TweenMaker_Tweens, TEXT("Tweens"), TEXT("TweenMaker"));
+LLM_DEFINE_TAG(TweenMaker_Delegates, TEXT("Delegates"), TEXT("TweenMaker"));
+LLM_DEFINE_TAG(TweenMaker_Factories, TEXT("Factories"), TEXT("TweenMaker"));
+
 #define LOCTEXT_NAMESPACE "FTweenMakerModule"
 
 void FTweenMakerModule::StartupModule()
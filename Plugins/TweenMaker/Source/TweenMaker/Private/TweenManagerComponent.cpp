@@ -12,6 +12,7 @@
 #include "Utils/TweenEnums.h"
 #include "TweenContainer.h"
 #include "Kismet/GameplayStatics.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenManagerComponent::UTweenManagerComponent()
@@ -228,6 +229,7 @@ bool UTweenManagerComponent::FindTweenByName(FName pTweenName,
 // public ----------------------------------------------------------------------
 UTweenContainer* UTweenManagerComponent::CreateTweenContainer(int32 pNumLoops, ETweenLoopType pLoopType, float pTimeScale)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Containers);
     UTweenContainer* newTweenContainer = NewObject<UTweenContainer>(this);
     newTweenContainer->Init(this, pNumLoops, pLoopType, pTimeScale);
 
@@ -271,6 +273,7 @@ UTweenVector* UTweenManagerComponent::AppendTweenVector(UTweenContainer* pTweenC
                                                         UTweenVectorLatentFactory* pLatentProxy)
 {
     // Creating the Tween and saving the reference
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenVector* newTween = NewObject<UTweenVector>(this);
     
     SaveTweenReference(pTarget, pTweenType, newTween);
@@ -303,6 +306,7 @@ UTweenVector* UTweenManagerComponent::JoinTweenVector(UTweenContainer* pTweenCon
                                                       bool pTweenWhileGameIsPaused,
                                                       UTweenVectorLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenVector* newTween = NewObject<UTweenVector>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -331,6 +335,7 @@ UTweenVector2D* UTweenManagerComponent::AppendTweenVector2D(UTweenContainer* pTw
                                                             bool pTweenWhileGameIsPaused,
                                                             UTweenVector2DLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenVector2D* newTween = NewObject<UTweenVector2D>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -357,6 +362,7 @@ UTweenVector2D* UTweenManagerComponent::JoinTweenVector2D(UTweenContainer* pTwee
                                                           bool pTweenWhileGameIsPaused,
                                                           UTweenVector2DLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenVector2D* newTween = NewObject<UTweenVector2D>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -390,6 +396,7 @@ UTweenRotator* UTweenManagerComponent::AppendTweenRotator(UTweenContainer* pTwee
                                                           bool pTweenWhileGameIsPaused,
                                                           UTweenRotatorLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenRotator* newTween = NewObject<UTweenRotator>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -421,6 +428,7 @@ UTweenRotator* UTweenManagerComponent::JoinTweenRotator(UTweenContainer* pTweenC
                                                         bool pTweenWhileGameIsPaused,
                                                         UTweenRotatorLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenRotator* newTween = NewObject<UTweenRotator>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -448,6 +456,7 @@ UTweenLinearColor* UTweenManagerComponent::AppendTweenLinearColor(UTweenContaine
                                                                   bool pTweenWhileGameIsPaused,
                                                                   UTweenLinearColorLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenLinearColor* newTween = NewObject<UTweenLinearColor>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -476,6 +485,7 @@ UTweenLinearColor* UTweenManagerComponent::JoinTweenLinearColor(UTweenContainer*
                                                                 bool pTweenWhileGameIsPaused,
                                                                 UTweenLinearColorLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenLinearColor* newTween = NewObject<UTweenLinearColor>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -505,6 +515,7 @@ UTweenFloat* UTweenManagerComponent::AppendTweenFloat(UTweenContainer* pTweenCon
                                                       UTweenFloatLatentFactory* pLatentProxy,
                                                       FName pParameterName)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -533,6 +544,7 @@ UTweenFloat* UTweenManagerComponent::JoinTweenFloat(UTweenContainer* pTweenConta
                                                     UTweenFloatLatentFactory* pLatentProxy,
                                                     FName pParameterName)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -567,6 +579,7 @@ UTweenFloat* UTweenManagerComponent::AppendTweenRotateAroundFloat(UTweenContaine
                                                                   bool pTweenWhileGameIsPaused,
                                                                   UTweenFloatLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -599,6 +612,7 @@ UTweenFloat* UTweenManagerComponent::JoinTweenRotateAroundFloat(UTweenContainer*
                                                                 bool pTweenWhileGameIsPaused,
                                                                 UTweenFloatLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -631,6 +645,7 @@ UTweenFloat* UTweenManagerComponent::AppendTweenFollowSplineFloat(UTweenContaine
                                                                   bool pTweenWhileGameIsPaused,
                                                                   UTweenFloatLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -661,6 +676,7 @@ UTweenFloat* UTweenManagerComponent::JoinTweenFollowSplineFloat(UTweenContainer*
                                                                 bool pTweenWhileGameIsPaused,
                                                                 UTweenFloatLatentFactory* pLatentProxy)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Tweens);
     UTweenFloat* newTween = NewObject<UTweenFloat>(this);
     SaveTweenReference(pTarget, pTweenType, newTween);
 
@@ -688,6 +704,7 @@ void UTweenManagerComponent::DestroyTweenContainer(UTweenContainer* pTweenContai
 
 void UTweenManagerComponent::SaveTweenReference(UObject* pTweenTarget, ETweenGenericType pTweenType, UBaseTween* pTween)
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Delegates);
     mTweensByObjectMap.Add(TPair<TWeakObjectPtr<UObject>, ETweenGenericType>(pTweenTarget, pTweenType), pTween);
 
     pTween->OnNameChanged.AddDynamic(this, &UTweenManagerComponent::UpdateNameMap);
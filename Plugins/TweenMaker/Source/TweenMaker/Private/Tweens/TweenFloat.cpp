@@ -10,6 +10,7 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "Components/SplineComponent.h"
 #include "Components/Widget.h"
+#include "TweenMaker.h"
 
 namespace 
 {
@@ -681,6 +682,8 @@ void UTweenFloat::CheckSplinePointReached(const FVector& WorldPosition)
 // private ---------------------------------------------------------------------
 void UTweenFloat::BindDelegates()
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Delegates);
+
     if (!bHasBoundedFunctions && mTargetObject.IsValid())
     {
         bool foundCorrectType = false;
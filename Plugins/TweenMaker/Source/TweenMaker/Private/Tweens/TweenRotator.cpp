@@ -7,6 +7,7 @@
 #include "Components/PrimitiveComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Utils/EaseEquations.h"
+#include "TweenMaker.h"
 
 namespace
 {
@@ -461,6 +462,8 @@ void UTweenRotator::UpdateForSceneComponent(USceneComponent* pTarget)
 // private ---------------------------------------------------------------------
 void UTweenRotator::BindDelegates()
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Delegates);
+
     // Proceed only if no functions were bounded yet
     if (!bHasBoundedFunctions && mTargetObject.IsValid())
     {
@@ -7,6 +7,7 @@
 #include "Components/PrimitiveComponent.h"
 #include "Utils/EaseEquations.h"
 #include "Curves/CurveFloat.h"
+#include "TweenMaker.h"
 
 // public ----------------------------------------------------------------------
 UTweenVector::UTweenVector(const FObjectInitializer& ObjectInitializer)
@@ -565,6 +566,8 @@ void UTweenVector::UpdateForSceneComponent(USceneComponent* pTarget)
 // private ---------------------------------------------------------------------
 void UTweenVector::BindDelegates()
 {
+    LLM_SCOPE_BYTAG(TweenMaker_Delegates);
+
     if (!bHasBoundedFunctions && mTargetObject.IsValid())
     {
         bool foundCorrectType = false;
@@ -4,6 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// Low level memory tracker tags, listed under TweenMaker/ when running with -llm
+LLM_DECLARE_TAG_API(TweenMaker, TWEENMAKER_API);
+LLM_DECLARE_TAG_API(TweenMaker_Containers, TWEENMAKER_API);
+LLM_DECLARE_TAG_API(TweenMaker_Tweens, TWEENMAKER_API);
+LLM_DECLARE_TAG_API(TweenMaker_Delegates, TWEENMAKER_API);
+LLM_DECLARE_TAG_API(TweenMaker_Factories, TWEENMAKER_API);
 
 class FTweenMakerModule : public IModuleInterface
 {
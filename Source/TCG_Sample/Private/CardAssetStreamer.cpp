@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CardAssetStreamer.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarCardAssetBudgetMB(
+	TEXT("tcg.CardAssets.BudgetMB"),
+	64,
+	TEXT("Memory budget for streamed card art and meshes, in MB"));
+
+static FAutoConsoleCommandWithWorld CardAssetReportCommand(
+	TEXT("tcg.CardAssets.Report"),
+	TEXT("Logs load times and resident memory of streamed card assets"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (UCardAssetStreamer* Streamer = GameInstance ? 
+			GameInstance->GetSubsystem<UCardAssetStreamer>() : nullptr)
+		{
+			Streamer->ReportStats();
+		}
+	}));
+
+void UCardAssetStreamer::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FAssetEntry>& Pair : Entries)
+	{
+		if (Pair.Value.Handle.IsValid())
+		{
+			Pair.Value.Handle->CancelHandle();
+		}
+	}
+	Entries.Empty();
+
+	Super::Deinitialize();
+}
+
+int32 UCardAssetStreamer::GetZonePriority(const ECardZone Zone)
+{
+	switch (Zone)
+	{
+	case ECardZone::Hand:
+	case ECardZone::DeckTop:
+	case ECardZone::Board:
+		return FStreamableManager::AsyncLoadHighPriority;
+	case ECardZone::OpponentRevealed:
+	case ECardZone::Graveyard:
+		return FStreamableManager::DefaultAsyncLoadPriority;
+	default:
+		return INDEX_NONE;
+	}
+}
+
+void UCardAssetStreamer::RequestCardAssets(const FCardData& InCardData, 
+	const ECardZone Zone)
+{
+	const int32 Priority = GetZonePriority(Zone);
+	if (Priority != INDEX_NONE)
+	{
+		RequestCardAssetsWithPriority(InCardData, Priority);
+	}
+}
+
+void UCardAssetStreamer::PrewarmCardAssets(const FCardData& InCardData)
+{
+	RequestCardAssetsWithPriority(InCardData, 
+		FStreamableManager::DefaultAsyncLoadPriority - 1);
+}
+
+void UCardAssetStreamer::RequestCardAssetsWithPriority(const FCardData& InCardData, 
+	const int32 Priority)
+{
+	if (!InCardData.CardArt.IsNull())
+	{
+		RequestAsset(InCardData.CardArt.ToSoftObjectPath(), Priority);
+	}
+	if (!InCardData.CardMesh.IsNull())
+	{
+		RequestAsset(InCardData.CardMesh.ToSoftObjectPath(), Priority);
+	}
+}
+
+void UCardAssetStreamer::ReleaseCardAssets(const FCardData& InCardData)
+{
+	for (const FSoftObjectPath& Path : 
+		{ InCardData.CardArt.ToSoftObjectPath(), InCardData.CardMesh.ToSoftObjectPath() })
+	{
+		if (FAssetEntry* Entry = Entries.Find(Path))
+		{
+			Entry->LastUse = 0;
+		}
+	}
+}
+
+void UCardAssetStreamer::RequestAsset(const FSoftObjectPath& Path, const int32 Priority)
+{
+	if (FAssetEntry* Existing = Entries.Find(Path))
+	{
+		Existing->LastUse = ++UseCounter;
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (PendingLoads == 0 && LoadedNum == 0)
+	{
+		FirstRequestTime = Now;
+	}
+
+	FAssetEntry& Entry = Entries.Add(Path);
+	Entry.LastUse = ++UseCounter;
+	Entry.RequestTime = Now;
+	PendingLoads++;
+
+	// already loaded assets may complete inside this call
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager()
+		.RequestAsyncLoad(Path, FStreamableDelegate::CreateUObject(
+			this, &UCardAssetStreamer::OnAssetLoaded, Path), Priority);
+
+	if (FAssetEntry* Requested = Entries.Find(Path))
+	{
+		Requested->Handle = Handle;
+	}
+}
+
+void UCardAssetStreamer::OnAssetLoaded(FSoftObjectPath Path)
+{
+	FAssetEntry* Entry = Entries.Find(Path);
+	if (!Entry || Entry->bLoaded)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	Entry->bLoaded = true;
+	Entry->LoadSeconds = Now - Entry->RequestTime;
+	PendingLoads--;
+
+	if (UObject* Asset = Path.ResolveObject())
+	{
+		Entry->SizeBytes = Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+		ResidentBytes += Entry->SizeBytes;
+	}
+
+	LoadedNum++;
+	TotalLoadSeconds += Entry->LoadSeconds;
+	MaxLoadSeconds = FMath::Max(MaxLoadSeconds, Entry->LoadSeconds);
+	LastLoadTime = Now;
+
+	EnforceBudget();
+
+	if (PendingLoads == 0)
+	{
+		OnAllLoadsComplete.Broadcast();
+	}
+}
+
+void UCardAssetStreamer::EnforceBudget()
+{
+	const int64 BudgetBytes = 
+		static_cast<int64>(CVarCardAssetBudgetMB.GetValueOnGameThread()) * 1024 * 1024;
+
+	while (ResidentBytes > BudgetBytes)
+	{
+		// least recently used loaded asset, the one just requested is kept
+		FSoftObjectPath Oldest;
+		uint64 OldestUse = MAX_uint64;
+		for (const TPair<FSoftObjectPath, FAssetEntry>& Pair : Entries)
+		{
+			if (Pair.Value.bLoaded && Pair.Value.LastUse < OldestUse 
+				&& Pair.Value.LastUse != UseCounter)
+			{
+				OldestUse = Pair.Value.LastUse;
+				Oldest = Pair.Key;
+			}
+		}
+
+		FAssetEntry Evicted;
+		if (!Entries.RemoveAndCopyValue(Oldest, Evicted))
+		{
+			break;
+		}
+
+		if (Evicted.Handle.IsValid())
+		{
+			Evicted.Handle->ReleaseHandle();
+		}
+		ResidentBytes -= Evicted.SizeBytes;
+		EvictedNum++;
+	}
+}
+
+void UCardAssetStreamer::ReportStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT(
+		"Card assets: %d loaded, %d pending, %d evicted, resident %.2f MB / %d MB"),
+		LoadedNum, PendingLoads, EvictedNum, 
+		ResidentBytes / (1024.0 * 1024.0), CVarCardAssetBudgetMB.GetValueOnGameThread());
+
+	if (LoadedNum > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT(
+			"Card asset load: total %.1f ms, avg %.2f ms, max %.2f ms per asset"),
+			(LastLoadTime - FirstRequestTime) * 1000.0,
+			TotalLoadSeconds * 1000.0 / LoadedNum, MaxLoadSeconds * 1000.0);
+	}
+}
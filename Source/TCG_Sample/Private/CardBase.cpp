@@ -3,6 +3,11 @@
 
 #include "CardBase.h"
 
+#if TCG_WITH_COSMETICS
+#include "TweenContainer.h"
+#include "TweenManagerComponent.h"
+#endif
+
 
 // Sets default values
 ACardBase::ACardBase()
@@ -30,3 +35,44 @@ void ACardBase::Tick(float DeltaTime)
 
 }
 
+
+void ACardBase::InitializeCard(const FCardData& InCardData)
+{
+	CardData = InCardData;
+	bPooled = false;
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	OnCardInitialized();
+}
+
+void ACardBase::ResetCard()
+{
+	CardData = FCardData();
+	CardHandle = FTCG_CardHandle();
+	bPooled = true;
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	OnCardReset();
+}
+
+void ACardBase::MoveCardTo(const FVector& Location, const FRotator& Rotation, 
+	const float Duration)
+{
+#if TCG_WITH_COSMETICS
+	if (Duration > 0.0f && GetNetMode() != NM_DedicatedServer)
+	{
+		if (UTweenContainer* Container = UTweenManagerComponent::CreateTweenContainerStatic())
+		{
+			Container->AppendTweenMoveActorTo(this, Location, Duration, ETweenEaseType::EaseOutQuad);
+			Container->JoinTweenRotateActorTo(this, Rotation, Duration, ETweenEaseType::EaseOutQuad);
+			return;
+		}
+	}
+#endif
+
+	SetActorLocationAndRotation(Location, Rotation);
+}
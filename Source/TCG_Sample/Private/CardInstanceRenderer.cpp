@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CardInstanceRenderer.h"
+#include "CardBase.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+// Sets default values
+ACardInstanceRenderer::ACardInstanceRenderer()
+{
+	// flushes the instance table once per frame instead of on every change
+	PrimaryActorTick.bCanEverTick = true;
+
+	CardInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(
+		TEXT("CardInstances"));
+	CardInstances->SetNumCustomDataFloats(FCardInstanceTable::NumCustomData);
+	CardInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = CardInstances;
+}
+
+// Called when the game starts or when spawned
+void ACardInstanceRenderer::BeginPlay()
+{
+	Super::BeginPlay();
+	
+}
+
+void ACardInstanceRenderer::EndPlay(EEndPlayReason::Type EndPlayReason)
+{
+	InstanceTable.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void ACardInstanceRenderer::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushInstances();
+}
+
+void ACardInstanceRenderer::RegisterCard(ACardBase* Card, const int32 ArtIndex)
+{
+	if (!Card)
+	{
+		return;
+	}
+
+	InstanceTable.Add(Card, Card->GetActorTransform(), ArtIndex);
+	Card->SetActorHiddenInGame(Card != HoveredCard);
+	InstanceTable.SetHidden(Card, Card == HoveredCard);
+}
+
+void ACardInstanceRenderer::UnregisterCard(ACardBase* Card)
+{
+	if (InstanceTable.Remove(Card))
+	{
+		Card->SetActorHiddenInGame(false);
+	}
+	if (Card == HoveredCard)
+	{
+		HoveredCard = nullptr;
+	}
+}
+
+void ACardInstanceRenderer::SetCardTransform(ACardBase* Card, const FTransform& Transform)
+{
+	InstanceTable.SetTransform(Card, Transform);
+	if (Card == HoveredCard)
+	{
+		Card->SetActorTransform(Transform);
+	}
+}
+
+void ACardInstanceRenderer::SetCardHighlighted(ACardBase* Card, const bool bHighlighted)
+{
+	InstanceTable.SetHighlighted(Card, bHighlighted);
+}
+
+void ACardInstanceRenderer::SetHoveredCard(ACardBase* Card)
+{
+	if (Card == HoveredCard)
+	{
+		return;
+	}
+
+	if (HoveredCard && InstanceTable.Find(HoveredCard) != INDEX_NONE)
+	{
+		HoveredCard->SetActorHiddenInGame(true);
+		InstanceTable.SetHidden(HoveredCard, false);
+	}
+
+	HoveredCard = Card;
+
+	if (HoveredCard && InstanceTable.Find(HoveredCard) != INDEX_NONE)
+	{
+		const int32 Index = InstanceTable.Find(HoveredCard);
+		HoveredCard->SetActorTransform(InstanceTable.Get(Index).Transform);
+		HoveredCard->SetActorHiddenInGame(false);
+		InstanceTable.SetHidden(HoveredCard, true);
+	}
+}
+
+void ACardInstanceRenderer::FlushInstances()
+{
+	const int32 Num = InstanceTable.Num();
+	const int32 RenderedNum = InstanceTable.GetRenderedNum();
+
+	if (Num == RenderedNum && InstanceTable.GetDirtyInstances().Num() == 0)
+	{
+		InstanceTable.MarkFlushed();
+		return;
+	}
+
+	// removing from the tail keeps the other instance indices in place
+	for (int32 Index = RenderedNum - 1; Index >= Num; Index--)
+	{
+		CardInstances->RemoveInstance(Index);
+	}
+	for (int32 Index = RenderedNum; Index < Num; Index++)
+	{
+		CardInstances->AddInstance(InstanceTable.Get(Index).GetRenderTransform(), true);
+	}
+
+	for (const int32 Index : InstanceTable.GetDirtyInstances())
+	{
+		if (Index >= Num)
+		{
+			continue;
+		}
+
+		const FCardInstanceTable::FInstance& Instance = InstanceTable.Get(Index);
+		CardInstances->UpdateInstanceTransform(Index, Instance.GetRenderTransform(), 
+			true, false, true);
+		CardInstances->SetCustomData(Index, 
+			MakeArrayView(Instance.CustomData, FCardInstanceTable::NumCustomData), false);
+	}
+
+	CardInstances->MarkRenderStateDirty();
+	InstanceTable.MarkFlushed();
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CardInstanceTable.h"
+#include "TCG_MemoryTags.h"
+
+FTransform FCardInstanceTable::FInstance::GetRenderTransform() const
+{
+	if (!bHidden)
+	{
+		return Transform;
+	}
+
+	FTransform Hidden = Transform;
+	Hidden.SetScale3D(FVector::ZeroVector);
+	return Hidden;
+}
+
+int32 FCardInstanceTable::Add(const ACardBase* Card, const FTransform& Transform, 
+	const int32 ArtIndex)
+{
+	LLM_SCOPE_BYTAG(TCG_Cards);
+
+	if (const int32* Existing = CardToInstance.Find(Card))
+	{
+		return *Existing;
+	}
+
+	FInstance Instance;
+	Instance.Card = Card;
+	Instance.Transform = Transform;
+	Instance.CustomData[0] = static_cast<float>(ArtIndex);
+
+	const int32 Index = Instances.Add(Instance);
+	CardToInstance.Add(Card, Index);
+	MarkDirty(Index);
+	return Index;
+}
+
+bool FCardInstanceTable::Remove(const ACardBase* Card)
+{
+	int32 Index = INDEX_NONE;
+	if (!CardToInstance.RemoveAndCopyValue(Card, Index))
+	{
+		return false;
+	}
+
+	const int32 LastIndex = Instances.Num() - 1;
+	Instances.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	DirtyInstances.Remove(LastIndex);
+
+	if (Index != LastIndex)
+	{
+		CardToInstance[Instances[Index].Card] = Index;
+		MarkDirty(Index);
+	}
+	return true;
+}
+
+void FCardInstanceTable::Empty()
+{
+	Instances.Reset();
+	CardToInstance.Reset();
+	DirtyInstances.Reset();
+}
+
+void FCardInstanceTable::SetTransform(const ACardBase* Card, const FTransform& Transform)
+{
+	const int32 Index = Find(Card);
+	if (Index != INDEX_NONE)
+	{
+		Instances[Index].Transform = Transform;
+		MarkDirty(Index);
+	}
+}
+
+void FCardInstanceTable::SetHighlighted(const ACardBase* Card, const bool bHighlighted)
+{
+	const int32 Index = Find(Card);
+	const float Value = bHighlighted ? 1.f : 0.f;
+	if (Index != INDEX_NONE && Instances[Index].CustomData[1] != Value)
+	{
+		Instances[Index].CustomData[1] = Value;
+		MarkDirty(Index);
+	}
+}
+
+void FCardInstanceTable::SetHidden(const ACardBase* Card, const bool bHidden)
+{
+	const int32 Index = Find(Card);
+	if (Index != INDEX_NONE && Instances[Index].bHidden != bHidden)
+	{
+		Instances[Index].bHidden = bHidden;
+		MarkDirty(Index);
+	}
+}
+
+int32 FCardInstanceTable::Find(const ACardBase* Card) const
+{
+	const int32* Index = CardToInstance.Find(Card);
+	return Index ? *Index : INDEX_NONE;
+}
+
+void FCardInstanceTable::MarkFlushed()
+{
+	UpdatesLastFlush = DirtyInstances.Num() + FMath::Abs(RenderedNum - Instances.Num());
+	RenderedNum = Instances.Num();
+	DirtyInstances.Reset();
+}
+
+void FCardInstanceTable::MarkDirty(const int32 Index)
+{
+	DirtyInstances.Add(Index);
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CardPoolSubsystem.h"
+#include "TCG_MemoryTags.h"
+#include "CardBase.h"
+#include "Engine/World.h"
+
+void UCardPoolSubsystem::Deinitialize()
+{
+	UE_LOG(LogTemp, Log, TEXT("Card pool hits: %d, misses: %d, spawns: %d"),
+		Stats.Hits, Stats.Misses, Stats.Spawns);
+
+	Buckets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCardPoolSubsystem::Prewarm(TSubclassOf<ACardBase> CardClass, const int32 Count)
+{
+	LLM_SCOPE_BYTAG(TCG_Cards);
+
+	if (!CardClass)
+	{
+		return;
+	}
+
+	FCardPoolBucket& Bucket = Buckets.FindOrAdd(CardClass);
+	Bucket.FreeCards.Reserve(Count);
+
+	while (Bucket.FreeCards.Num() < Count)
+	{
+		ACardBase* Card = SpawnPooledCard(CardClass, FTransform::Identity);
+		if (!Card)
+		{
+			break;
+		}
+		Card->ResetCard();
+		Bucket.FreeCards.Add(Card);
+	}
+}
+
+ACardBase* UCardPoolSubsystem::Acquire(TSubclassOf<ACardBase> CardClass, 
+	const FCardData& InCardData, const FTransform& SpawnTransform)
+{
+	LLM_SCOPE_BYTAG(TCG_Cards);
+
+	if (!CardClass)
+	{
+		return nullptr;
+	}
+
+	ACardBase* Card = nullptr;
+	if (FCardPoolBucket* Bucket = Buckets.Find(CardClass))
+	{
+		// cards can still be destroyed from outside, e.g. by a level unload
+		while (!Card && Bucket->FreeCards.Num() > 0)
+		{
+			ACardBase* Candidate = Bucket->FreeCards.Pop(false);
+			if (IsValid(Candidate))
+			{
+				Card = Candidate;
+			}
+		}
+	}
+
+	if (Card)
+	{
+		Stats.Hits++;
+		Card->SetActorTransform(SpawnTransform);
+	}
+	else
+	{
+		Stats.Misses++;
+		Card = SpawnPooledCard(CardClass, SpawnTransform);
+		if (!Card)
+		{
+			return nullptr;
+		}
+	}
+
+	Card->InitializeCard(InCardData);
+	return Card;
+}
+
+void UCardPoolSubsystem::Release(ACardBase* Card)
+{
+	if (!IsValid(Card) || Card->IsPooled())
+	{
+		return;
+	}
+
+	Stats.Releases++;
+	Card->ResetCard();
+	Buckets.FindOrAdd(Card->GetClass()).FreeCards.Add(Card);
+}
+
+int32 UCardPoolSubsystem::GetFreeCardNum(TSubclassOf<ACardBase> CardClass) const
+{
+	const FCardPoolBucket* Bucket = Buckets.Find(CardClass);
+	return Bucket ? Bucket->FreeCards.Num() : 0;
+}
+
+ACardBase* UCardPoolSubsystem::SpawnPooledCard(TSubclassOf<ACardBase> CardClass, 
+	const FTransform& SpawnTransform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = 
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ACardBase* Card = GetWorld()->SpawnActor<ACardBase>(CardClass, SpawnTransform, 
+		SpawnParams);
+	if (Card)
+	{
+		Stats.Spawns++;
+	}
+	return Card;
+}
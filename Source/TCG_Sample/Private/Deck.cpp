@@ -2,37 +2,120 @@
 
 
 #include "Deck.h"
+#include "TCG_MemoryTags.h"
+#include "CardAssetStreamer.h"
+#include "CardBase.h"
 #include "CardInterface.h"
+#include "CardPoolSubsystem.h"
+#include "EngineUtils.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "TCG_CardDatabase.h"
+#include "TCG_GameInstance.h"
+#include "TCG_GameState.h"
+#include "TCG_MatchStats.h"
+#include "TCG_PlayerState.h"
+#include "TCG_TraceLog.h"
 
 // Sets default values
 ADeck::ADeck()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = false;
-
+	bReplicates = true;
 }
 
 // Called when the game starts or when spawned
 void ADeck::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(TCG_Decks);
+
 	Super::BeginPlay();
 
+	AcquirePooledCards();
+	RegisterCardZones();
+
 	if (HasAuthority())
 	{
+		ShuffleSeed = FMath::Rand();
+		DeckStream.Initialize(ShuffleSeed);
 		SetDeckOwner();
 	}
 }
 
 void ADeck::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
+	if (UTCG_GameInstance* GameInstance = GetGameInstance<UTCG_GameInstance>())
+	{
+		GameInstance->OnPreloadComplete.RemoveDynamic(this, &ADeck::OnCardDatabaseReady);
+	}
+	ReleasePooledCards();
+
 	Super::EndPlay(EndPlayReason);
 }
 
+void ADeck::AcquirePooledCards()
+{
+	UCardPoolSubsystem* CardPool = GetWorld()->GetSubsystem<UCardPoolSubsystem>();
+	if (!PooledCardClass || PooledCards.Num() == 0 || !CardPool)
+	{
+		return;
+	}
+
+	// cards aren't replicated, every peer builds its own copy of the deck.
+	// only this deck's share, other decks of the class prewarm their own
+	CardPool->Prewarm(PooledCardClass, PooledCards.Num());
+
+	AcquiredCards.Reserve(PooledCards.Num());
+	for (const FCardData& PooledCardData : PooledCards)
+	{
+		if (ACardBase* Card = CardPool->Acquire(PooledCardClass, PooledCardData, 
+			GetActorTransform()))
+		{
+			AcquiredCards.Add(Card);
+			Decklist.Add(Card);
+		}
+	}
+}
+
+void ADeck::ReleasePooledCards()
+{
+	UCardPoolSubsystem* CardPool = GetWorld()->GetSubsystem<UCardPoolSubsystem>();
+	if (!CardPool)
+	{
+		return;
+	}
+
+	// wherever they are now, hand and board included
+	for (ACardBase* Card : AcquiredCards)
+	{
+		Decklist.RemoveSingle(Card);
+		CardPool->Release(Card);
+	}
+	AcquiredCards.Reset();
+}
+
 void ADeck::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ADeck, DeckOwner);
+	DOREPLIFETIME(ADeck, VoidDrawCount);
+	DOREPLIFETIME_CONDITION(ADeck, ShuffleSeed, COND_InitialOnly);
+}
+
+void ADeck::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// lockstep peers count void draws themselves, and the seed would 
+	// let the opponent replay this deck's order
+	const ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	const bool bLockstep = GameState && GameState->IsLockstep();
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ADeck, VoidDrawCount, !bLockstep);
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ADeck, ShuffleSeed, !bLockstep);
 }
 
 // Called every frame
@@ -48,33 +131,97 @@ void ADeck::SetDeckOwner_Implementation()
 
 void ADeck::OnVoidDrawCount()
 {
-	UE_LOG(LogTemp, Log, TEXT("Current Void Draws: %d"), VoidDrawCount);
+	TCG_SCOPE_HOTSPOT(OnVoidDrawCount);
+
+	TCG_TRACE(VoidDrawCount, "Current Void Draws: {0}", VoidDrawCount);
+	HashVoidDrawCount();
+}
+
+void ADeck::HashVoidDrawCount()
+{
+	if (ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		GameState->GetStateHash().Update(OwnerIndex, ETCG_HashKey::VoidDrawCount, 0,
+			HashedVoidDrawCount, VoidDrawCount);
+		HashedVoidDrawCount = VoidDrawCount;
+	}
+}
+
+void ADeck::OnRep_ShuffleSeed()
+{
+	TCG_SCOPE_HOTSPOT(OnRep_ShuffleSeed);
+
+	DeckStream.Initialize(ShuffleSeed);
+}
+
+void ADeck::SetShuffleSeed(const int32 Seed)
+{
+	ShuffleSeed = Seed;
+	OnRep_ShuffleSeed();
 }
 
 void ADeck::Shuffle()
 {
+	TCG_SCOPE_HOTSPOT(Shuffle);
+
 	if (Decklist.Num() > 0)
 	{
 		int32 LastIndex = Decklist.Num() - 1;
 		for (int32 i = 0; i <= LastIndex; i++)
 		{
-			int32 Index = FMath::RandRange(i, LastIndex);
+			int32 Index = DeckStream.RandRange(i, LastIndex);
 			if (i != Index)
 			{
 				Decklist.Swap(i, Index);
 			}
 		}
 	}
+
+	// the whole order, mirrored returns never advance the owner's stream
+	if (HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		FTCG_DeckMutation Mutation;
+		Mutation.Type = ETCG_DeckMutation::Shuffle;
+		Mutation.Order.Reserve(Decklist.Num());
+		for (const ACardBase* Card : Decklist)
+		{
+			Mutation.Order.Add(Card ? Card->CardHandle : FTCG_CardHandle());
+		}
+		MirrorToOwner(Mutation);
+	}
+}
+
+ACardBase* ADeck::Draw()
+{
+	ACardBase* DrewCard = PopTopCard();
+	if (DrewCard)
+	{
+		FTCG_DeckMutation Mutation;
+		Mutation.Type = ETCG_DeckMutation::Draw;
+		Mutation.Card = DrewCard->CardHandle;
+		MirrorToOwner(Mutation);
+	}
+	return DrewCard;
 }
 
-void ADeck::Draw()
+ACardBase* ADeck::DrawRequested()
 {
+	return PopTopCard();
+}
+
+ACardBase* ADeck::PopTopCard()
+{
+	TCG_SCOPE_HOTSPOT(Draw);
+
+	ACardBase* DrewCard = nullptr;
 
 	if (Decklist.Num() > 0)
 	{
-		ACardBase* DrewCard = Decklist.Pop(true);
+		DrewCard = Decklist.Pop(true);
+		MoveCardZone(DrewCard, ECardZone::Hand);
+		StreamCardAssets(DrewCard);
 
-		if (DeckOwner->Implements<UCardInterface>())
+		if (DeckOwner && DeckOwner->Implements<UCardInterface>())
 		{
 			ICardInterface::Execute_OnDrawValidCard(DeckOwner, DrewCard);
 		}
@@ -82,6 +229,7 @@ void ADeck::Draw()
 	else
 	{
 		VoidDrawCount++;
+		HashVoidDrawCount();
 		TArray<AActor*> Temp;
 		UGameplayStatics::GetAllActorsWithInterface(GWorld,
 			UCardInterface::StaticClass(), Temp);
@@ -91,18 +239,332 @@ void ADeck::Draw()
 			ICardInterface::Execute_OnDrawVoidCard(Element, VoidDrawCount);
 		}
 	}
+
+	return DrewCard;
+}
+
+ACardBase* ADeck::PredictDraw()
+{
+	// void draws are left to the replicated VoidDrawCount
+	if (Decklist.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	ACardBase* PredictedCard = Decklist.Pop(true);
+	MoveCardZone(PredictedCard, ECardZone::Hand);
+	StreamCardAssets(PredictedCard);
+
+	if (DeckOwner && DeckOwner->Implements<UCardInterface>())
+	{
+		ICardInterface::Execute_OnDrawValidCard(DeckOwner, PredictedCard);
+	}
+	return PredictedCard;
+}
+
+void ADeck::ReconcileDraw(ACardBase* PredictedCard, ACardBase* DrewCard,
+	TArray<ACardBase*>& LaterPredictedCards)
+{
+	if (PredictedCard == DrewCard)
+	{
+		return;
+	}
+
+	// put the library back as it was before this draw, the later
+	// predictions were popped after it so they go back first
+	TArray<ACardBase*> PredictedCards;
+	for (int32 Index = LaterPredictedCards.Num() - 1; Index >= 0; Index--)
+	{
+		if (LaterPredictedCards[Index])
+		{
+			Decklist.Push(LaterPredictedCards[Index]);
+			PredictedCards.Add(LaterPredictedCards[Index]);
+		}
+	}
+	if (PredictedCard)
+	{
+		Decklist.Push(PredictedCard);
+		PredictedCards.Add(PredictedCard);
+	}
+
+	// then the server's draw and the later draws again on top of it
+	TArray<ACardBase*> DrawnCards;
+	if (DrewCard)
+	{
+		Decklist.RemoveSingle(DrewCard);
+		DrawnCards.Add(DrewCard);
+	}
+	const TArray<ACardBase*> PreviousLaterCards = LaterPredictedCards;
+	for (ACardBase*& LaterCard : LaterPredictedCards)
+	{
+		LaterCard = Decklist.Num() > 0 ? Decklist.Pop(true) : nullptr;
+		if (LaterCard)
+		{
+			DrawnCards.Add(LaterCard);
+		}
+	}
+
+	// only cards that changed hands move zones
+	for (ACardBase* Card : PredictedCards)
+	{
+		if (!DrawnCards.Contains(Card))
+		{
+			MoveCardZone(Card, ECardZone::Library);
+		}
+	}
+	for (ACardBase* Card : DrawnCards)
+	{
+		if (!PredictedCards.Contains(Card))
+		{
+			MoveCardZone(Card, ECardZone::Hand);
+			StreamCardAssets(Card);
+		}
+	}
+
+	if (DeckOwner && DeckOwner->Implements<UCardInterface>())
+	{
+		ICardInterface::Execute_OnDrawRejected(DeckOwner, PredictedCard, DrewCard);
+		for (int32 Index = 0; Index < LaterPredictedCards.Num(); Index++)
+		{
+			if (LaterPredictedCards[Index] != PreviousLaterCards[Index])
+			{
+				ICardInterface::Execute_OnDrawRejected(DeckOwner, 
+					PreviousLaterCards[Index], LaterPredictedCards[Index]);
+			}
+		}
+	}
+}
+
+void ADeck::StreamCardAssets(ACardBase* DrewCard)
+{
+	if (!bStreamCardAssets || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UCardAssetStreamer* Streamer = GameInstance ? 
+		GameInstance->GetSubsystem<UCardAssetStreamer>() : nullptr;
+	if (!Streamer)
+	{
+		return;
+	}
+
+	if (DrewCard)
+	{
+		Streamer->RequestCardAssets(DrewCard->GetCardData(), ECardZone::Hand);
+	}
+	if (Decklist.Num() > 0 && Decklist.Last())
+	{
+		Streamer->RequestCardAssets(Decklist.Last()->GetCardData(), ECardZone::DeckTop);
+	}
 }
 
 void ADeck::ReturnCard(ACardBase* ReturnedCard)
 {
-	int32 InsertIndex = FMath::RandRange(0, Decklist.Num());
+	LLM_SCOPE_BYTAG(TCG_Decks);
+	TCG_SCOPE_HOTSPOT(ReturnCard);
+
+	if (ReturnedCard && bStreamCardAssets && GetNetMode() != NM_DedicatedServer)
+	{
+		if (UCardAssetStreamer* Streamer = GetGameInstance() ?
+			GetGameInstance()->GetSubsystem<UCardAssetStreamer>() : nullptr)
+		{
+			Streamer->ReleaseCardAssets(ReturnedCard->GetCardData());
+		}
+	}
+
+	int32 InsertIndex = DeckStream.RandRange(0, Decklist.Num());
 	Decklist.Insert(ReturnedCard, InsertIndex);
+	MoveCardZone(ReturnedCard, ECardZone::Library);
+
+	if (ReturnedCard)
+	{
+		FTCG_DeckMutation Mutation;
+		Mutation.Type = ETCG_DeckMutation::Return;
+		Mutation.Card = ReturnedCard->CardHandle;
+		Mutation.Index = InsertIndex;
+		MirrorToOwner(Mutation);
+	}
+}
+
+void ADeck::MirrorToOwner(const FTCG_DeckMutation& Mutation) const
+{
+	// a deck that doesn't replicate has no copy on the owner
+	if (!HasAuthority() || !GetIsReplicated() || GetNetMode() == NM_Standalone)
+	{
+		return;
+	}
+
+	// lockstep peers replay the commands themselves
+	const ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	if (!GameState || GameState->IsLockstep())
+	{
+		return;
+	}
+
+	for (APlayerState* PlayerState : GameState->PlayerArray)
+	{
+		ATCG_PlayerState* Owner = Cast<ATCG_PlayerState>(PlayerState);
+		if (!Owner || Owner->GetPlayerIndex() != OwnerIndex)
+		{
+			continue;
+		}
+
+		// a listen server host already has the server's deck
+		const APlayerController* Controller = Cast<APlayerController>(Owner->GetOwner());
+		if (Controller && !Controller->IsLocalController())
+		{
+			Owner->Client_MirrorDeck(const_cast<ADeck*>(this), Mutation);
+		}
+		return;
+	}
+}
+
+void ADeck::ApplyMirroredMutation(const FTCG_DeckMutation& Mutation)
+{
+	switch (Mutation.Type)
+	{
+	case ETCG_DeckMutation::Draw:
+	{
+		// a card the local prediction already drew is left to its reconcile
+		ACardBase* DrewCard = FindCard(Mutation.Card);
+		if (!DrewCard)
+		{
+			break;
+		}
+
+		Decklist.RemoveSingle(DrewCard);
+		MoveCardZone(DrewCard, ECardZone::Hand);
+		StreamCardAssets(DrewCard);
+		if (DeckOwner && DeckOwner->Implements<UCardInterface>())
+		{
+			ICardInterface::Execute_OnDrawValidCard(DeckOwner, DrewCard);
+		}
+		break;
+	}
+	case ETCG_DeckMutation::Return:
+	{
+		ACardBase* Found = FindOwnedCard(Mutation.Card);
+		if (!Found || Decklist.Contains(Found))
+		{
+			break;
+		}
+
+		// pending predicted draws are missing from the local top
+		Decklist.Insert(Found, FMath::Clamp(Mutation.Index, 0, Decklist.Num()));
+		MoveCardZone(Found, ECardZone::Library);
+		break;
+	}
+	case ETCG_DeckMutation::Shuffle:
+	{
+		TArray<ACardBase*> Ordered;
+		Ordered.Reserve(Decklist.Num());
+		for (const FTCG_CardHandle& Handle : Mutation.Order)
+		{
+			if (ACardBase* Card = FindCard(Handle))
+			{
+				Ordered.Add(Card);
+			}
+		}
+		// anything the server didn't list stays on top, as it was last drawn
+		for (ACardBase* Card : Decklist)
+		{
+			if (!Ordered.Contains(Card))
+			{
+				Ordered.Add(Card);
+			}
+		}
+		Decklist = MoveTemp(Ordered);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void ADeck::RegisterCardZones()
+{
+	ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	UTCG_GameInstance* GameInstance = GetGameInstance<UTCG_GameInstance>();
+	const FTCG_CardDatabase* CardDatabase = GameInstance ? 
+		GameInstance->GetCardDatabase() : nullptr;
+	if (GameInstance && !CardDatabase && 
+		GameInstance->GetPreloadPhase() != ETCG_PreloadPhase::Failed)
+	{
+		GameInstance->OnPreloadComplete.AddUniqueDynamic(this, &ADeck::OnCardDatabaseReady);
+		return;
+	}
+	if (!GameState || !CardDatabase || bCardZonesRegistered)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Deck cards aren't registered to the zone index"));
+		return;
+	}
+
+	// a second deck in the slot would get handles in another order on each peer
+	for (TActorIterator<ADeck> It(GetWorld()); It; ++It)
+	{
+		if (*It != this && It->bCardZonesRegistered && It->OwnerIndex == OwnerIndex)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Decks %s and %s both have OwnerIndex %d"),
+				*GetName(), *It->GetName(), OwnerIndex);
+			return;
+		}
+	}
+
+	bCardZonesRegistered = true;
+	OwnedCards = Decklist;
+	for (ACardBase* Card : Decklist)
+	{
+		const FTCG_CardEntry* Entry = Card ? 
+			CardDatabase->Find(Card->GetCardData().CardId) : nullptr;
+		if (Entry)
+		{
+			Card->CardHandle = GameState->RegisterCard(*Entry, OwnerIndex, ECardZone::Library);
+			if (Entry->CardType == ECardType::Minion)
+			{
+				GameState->GetStatLayers().SetBaseStats(Card->CardHandle, 
+					Entry->Attack, Entry->HitPoint);
+			}
+		}
+	}
+}
+
+void ADeck::OnCardDatabaseReady(bool bSuccess)
+{
+	if (UTCG_GameInstance* GameInstance = GetGameInstance<UTCG_GameInstance>())
+	{
+		GameInstance->OnPreloadComplete.RemoveDynamic(this, &ADeck::OnCardDatabaseReady);
+	}
+
+	if (bSuccess)
+	{
+		RegisterCardZones();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Deck cards aren't registered, card database failed"));
+	}
+}
+
+void ADeck::MoveCardZone(ACardBase* Card, const ECardZone Zone)
+{
+	ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	if (Card && GameState)
+	{
+		GameState->MoveCardZone(Card->CardHandle, Zone);
+	}
 }
 
 void ADeck::Redraw_Single(ACardBase* ReturnedCard)
+{
+	Mulligan(ReturnedCard);
+}
+
+ACardBase* ADeck::Mulligan(ACardBase* ReturnedCard)
 {
 	ReturnCard(ReturnedCard);
-	Draw();
+	return Draw();
 }
 
 TArray<ACardBase*> ADeck::Redraw_Multiple(TArray<ACardBase*> ReturnedCards)
@@ -110,8 +572,68 @@ TArray<ACardBase*> ADeck::Redraw_Multiple(TArray<ACardBase*> ReturnedCards)
 	return TArray<ACardBase*>();
 }
 
+ACardBase* ADeck::FindCard(const FTCG_CardHandle Handle) const
+{
+	if (!Handle.IsValid())
+	{
+		return nullptr;
+	}
+
+	ACardBase* const* Found = Decklist.FindByPredicate([Handle](const ACardBase* Card)
+		{
+			return Card && Card->CardHandle == Handle;
+		});
+	return Found ? *Found : nullptr;
+}
+
+ACardBase* ADeck::FindOwnedCard(const FTCG_CardHandle Handle) const
+{
+	if (!Handle.IsValid())
+	{
+		return nullptr;
+	}
+
+	ACardBase* const* Found = OwnedCards.FindByPredicate([Handle](const ACardBase* Card)
+		{
+			return Card && Card->CardHandle == Handle;
+		});
+	return Found ? *Found : nullptr;
+}
+
+void ADeck::DrawHidden()
+{
+	// the local order is unknown, so no card actor leaves the deck
+	if (GetRemainingCardNum() > 0)
+	{
+		HiddenDrawCount++;
+		return;
+	}
+
+	VoidDrawCount++;
+	OnVoidDrawCount();
+}
+
+void ADeck::RevealHiddenCard(const int32 CardId, const ECardZone Zone)
+{
+	const int32 Index = Decklist.IndexOfByPredicate([CardId](const ACardBase* Card)
+		{
+			return Card && Card->GetCardData().CardId == CardId;
+		});
+	if (Index == INDEX_NONE || HiddenDrawCount == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Revealed card %d isn't hidden in this deck"), CardId);
+		return;
+	}
+
+	ACardBase* Revealed = Decklist[Index];
+	Decklist.RemoveAt(Index);
+	HiddenDrawCount--;
+	MoveCardZone(Revealed, Zone);
+	StreamCardAssets(nullptr);
+}
+
 int32 ADeck::GetRemainingCardNum()
 {
-	return this->Decklist.Num();
+	return this->Decklist.Num() - HiddenDrawCount;
 }
 
@@ -2,6 +2,13 @@
 
 
 #include "Hand.h"
+#include "TCG_MemoryTags.h"
+#include "CardBase.h"
+#include "TCG_CardDatabase.h"
+#include "TCG_GameInstance.h"
+#include "TCG_GameState.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
 
 
 // Sets default values
@@ -16,10 +23,32 @@ void AHand::BeginPlay()
 {
 	Super::BeginPlay();
 	
+	if (AGameStateBase* GameState = GetWorld()->GetGameState())
+	{
+		BindGameState(GameState);
+	}
+	else
+	{
+		GameStateSetHandle = GetWorld()->GameStateSetEvent.AddUObject(this, 
+			&AHand::BindGameState);
+	}
+
+	EnsureCardDatabase();
+	for (ACardBase* Card : CardsInHand)
+	{
+		MoveGenerator.AddHandCard(Card);
+	}
 }
 
 void AHand::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
+	GetWorld()->GameStateSetEvent.Remove(GameStateSetHandle);
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->OnGamePhaseChanged.RemoveDynamic(this, &AHand::OnGamePhaseChanged);
+		TCG_GameState->OnCardZoneChanged.Remove(CardZoneChangedHandle);
+	}
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -30,3 +59,169 @@ void AHand::Tick(float DeltaTime)
 
 }
 
+
+void AHand::BindGameState(AGameStateBase* GameState)
+{
+	GetWorld()->GameStateSetEvent.Remove(GameStateSetHandle);
+	GameStateSetHandle.Reset();
+
+	if (ATCG_GameState* TCG_GameState = Cast<ATCG_GameState>(GameState))
+	{
+		TCG_GameState->OnGamePhaseChanged.AddUniqueDynamic(this, &AHand::OnGamePhaseChanged);
+		OnGamePhaseChanged(TCG_GameState->GetGamePhase());
+
+		CardZoneChangedHandle = TCG_GameState->OnCardZoneChanged.AddUObject(this, 
+			&AHand::OnCardZoneChanged);
+		RefreshBoardTargets(*TCG_GameState);
+	}
+}
+
+void AHand::OnCardZoneChanged(const FTCG_CardHandle Handle, const ECardZone PreviousZone, 
+	const ECardZone Zone)
+{
+	ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	if (!GameState)
+	{
+		return;
+	}
+
+	const bool bEntersHand = Zone == ECardZone::Hand;
+	if (bEntersHand != (PreviousZone == ECardZone::Hand) &&
+		GameState->GetZoneIndex().GetOwner(Handle) == OwnerIndex)
+	{
+		if (ACardBase* Card = GameState->FindCard(Handle))
+		{
+			bEntersHand ? AddCard(Card) : RemoveCard(Card);
+		}
+	}
+
+	if (Zone == ECardZone::Board || PreviousZone == ECardZone::Board)
+	{
+		RefreshBoardTargets(*GameState);
+	}
+}
+
+void AHand::RefreshBoardTargets(const ATCG_GameState& GameState)
+{
+	TArray<AActor*> Targets;
+	GameState.GetZoneIndex().GetZoneBits(ECardZone::Board).ForEachSetBit(
+		[&GameState, &Targets](const int32 Index)
+		{
+			FTCG_CardHandle Handle;
+			Handle.Index = Index;
+			if (ACardBase* Card = GameState.FindCard(Handle))
+			{
+				Targets.Add(Card);
+			}
+		});
+	SetBoardTargets(Targets);
+}
+
+void AHand::OnGamePhaseChanged(EGamePhase ChangedPhase)
+{
+	MoveGenerator.SetPhase(ChangedPhase);
+	bPlayableCardsDirty = true;
+}
+
+bool AHand::EnsureCardDatabase()
+{
+	// the database may finish preloading after the hand begins play
+	UTCG_GameInstance* GameInstance = GetGameInstance<UTCG_GameInstance>();
+	const FTCG_CardDatabase* CardDatabase = GameInstance ? 
+		GameInstance->GetCardDatabase() : nullptr;
+
+	if (MoveGenerator.SetCardDatabase(CardDatabase))
+	{
+		bPlayableCardsDirty = true;
+	}
+	return CardDatabase != nullptr;
+}
+
+void AHand::AddCard(ACardBase* Card)
+{
+	LLM_SCOPE_BYTAG(TCG_Hands);
+
+	if (!Card)
+	{
+		return;
+	}
+
+	EnsureCardDatabase();
+	CardsInHand.AddUnique(Card);
+	MoveGenerator.AddHandCard(Card);
+	bPlayableCardsDirty = true;
+}
+
+void AHand::RemoveCard(ACardBase* Card)
+{
+	CardsInHand.Remove(Card);
+	MoveGenerator.RemoveHandCard(Card);
+	bPlayableCardsDirty = true;
+}
+
+void AHand::SetUntappedLands(const TArray<ACardBase*>& Lands)
+{
+	LLM_SCOPE_BYTAG(TCG_Hands);
+
+	if (!EnsureCardDatabase())
+	{
+		return;
+	}
+
+	const FTCG_CardDatabase* CardDatabase = 
+		GetGameInstance<UTCG_GameInstance>()->GetCardDatabase();
+
+	TArray<FTCG_ManaSource> Sources;
+	for (int32 Index = 0; Index < Lands.Num(); Index++)
+	{
+		const FTCG_CardEntry* Entry = Lands[Index] ? 
+			CardDatabase->Find(Lands[Index]->GetCardData().CardId) : nullptr;
+		if (Entry && Entry->CardType == ECardType::Mana)
+		{
+			FTCG_ManaSource& Source = Sources.AddDefaulted_GetRef();
+			Source.SourceId = Index;
+			Source.ColorMask = FTCG_ManaSource::ToMask(Entry->ManaType);
+		}
+	}
+	MoveGenerator.SetManaSources(Sources);
+	bPlayableCardsDirty = true;
+}
+
+void AHand::SetBoardTargets(const TArray<AActor*>& Targets)
+{
+	LLM_SCOPE_BYTAG(TCG_Hands);
+
+	MoveGenerator.SetTargets(Targets);
+}
+
+void AHand::SetLandPlayed(const bool bLandPlayed)
+{
+	MoveGenerator.SetLandPlayed(bLandPlayed);
+	bPlayableCardsDirty = true;
+}
+
+bool AHand::IsCardPlayable(ACardBase* Card) const
+{
+	return MoveGenerator.IsPlayable(Card);
+}
+
+const TArray<ACardBase*>& AHand::GetPlayableCards() const
+{
+	if (!bPlayableCardsDirty)
+	{
+		return PlayableCards;
+	}
+
+	LLM_SCOPE_BYTAG(TCG_Hands);
+
+	PlayableCards.Reset();
+	for (ACardBase* Card : CardsInHand)
+	{
+		if (MoveGenerator.IsPlayable(Card))
+		{
+			PlayableCards.Add(Card);
+		}
+	}
+	bPlayableCardsDirty = false;
+	return PlayableCards;
+}
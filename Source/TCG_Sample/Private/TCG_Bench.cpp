@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_Bench.h"
+#include "CardBase.h"
+#include "Deck.h"
+#include "TCG_ManaSolver.h"
+#include "TCG_MemoryTags.h"
+#include "Algo/AnyOf.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<float> CVarBenchMinTime(
+	TEXT("tcg.Bench.MinTime"),
+	0.2f,
+	TEXT("Seconds each benchmark case repeats its batches"));
+
+static FAutoConsoleCommandWithWorldAndArgs BenchCommand(
+	TEXT("tcg.Bench"),
+	TEXT("Benchmarks deck, hand and mana operations and writes json, e.g. tcg.Bench Shuffle [path.json]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+	{
+		FString Filter;
+		FString Path;
+		for (const FString& Arg : Args)
+		{
+			(Arg.EndsWith(TEXT(".json")) ? Path : Filter) = Arg;
+		}
+		FTCG_Bench::ExportJson(FTCG_Bench::Run(World, Filter), Path);
+	}));
+
+namespace
+{
+	const int32 DeckSizes[] = { 40, 60, 100, 1000, 10000 };
+	const int32 HandSizes[] = { 1, 5, 10, 20 };
+	// distinct card actors, bigger decks repeat them
+	constexpr int32 MaxCardActors = 512;
+	constexpr int32 DeckOpsPerBatch = 256;
+	constexpr int32 HandsPerBatch = 16;
+
+	// times Batch after each Setup until the minimum time has passed
+	template <typename SetupType, typename BatchType>
+	FTCG_Bench::FResult Measure(const FString& Name, TArray<TPair<FString, FString>> Params,
+		const int32 OpsPerBatch, SetupType Setup, BatchType Batch)
+	{
+		FTCG_Bench::FResult Result;
+		Result.Name = Name;
+		Result.Params = MoveTemp(Params);
+
+		TArray<double> BatchNs;
+		int64 GrownBytes = 0;
+		bool bTracked = true;
+		const double EndTime = FPlatformTime::Seconds() + CVarBenchMinTime.GetValueOnGameThread();
+		do
+		{
+			Setup();
+			const int64 BytesBefore = FTCG_MemoryTags::GetTotalBytes();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Batch();
+			const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+			const int64 BytesAfter = FTCG_MemoryTags::GetTotalBytes();
+
+			BatchNs.Add(FPlatformTime::ToMilliseconds64(Cycles) * 1000000.0 / OpsPerBatch);
+			Result.Ops += OpsPerBatch;
+			bTracked &= BytesBefore >= 0;
+			GrownBytes += BytesAfter - BytesBefore;
+		}
+		while (FPlatformTime::Seconds() < EndTime);
+
+		BatchNs.Sort();
+		Result.MinNsPerOp = BatchNs[0];
+		Result.MedianNsPerOp = BatchNs[BatchNs.Num() / 2];
+		Result.TaggedBytesPerOp = bTracked ? static_cast<double>(GrownBytes) / Result.Ops : -1.0;
+		return Result;
+	}
+
+	bool PassesFilter(const FString& Name, const FString& Filter)
+	{
+		return Filter.IsEmpty() || Name.Contains(Filter);
+	}
+
+	FManaCost MakeCost(const int32 Fire, const int32 Water)
+	{
+		FManaCost Cost;
+		if (Fire > 0)
+		{
+			Cost.Cost.Add(EManaType::Fire, Fire);
+		}
+		if (Water > 0)
+		{
+			Cost.Cost.Add(EManaType::Water, Water);
+		}
+		return Cost;
+	}
+
+	// cost options of the Index'th card in a hand of the given shape
+	TArray<FManaCost> MakeCardCosts(const FString& Shape, const int32 Index)
+	{
+		if (Shape == TEXT("Mono"))
+		{
+			return { MakeCost(1 + Index % 4, 0) };
+		}
+		if (Shape == TEXT("Split"))
+		{
+			return { MakeCost(1 + Index % 2, 1 + Index % 3) };
+		}
+		if (Shape == TEXT("Heavy"))
+		{
+			return { MakeCost(6, 4 + Index % 3) };
+		}
+		return { MakeCost(3, 0), MakeCost(1, 2) };
+	}
+
+	// mono lands of both colors and a few duals, heavy hands get twice as many
+	TArray<FTCG_ManaSource> MakeLands(const FString& Shape)
+	{
+		const int32 Scale = Shape == TEXT("Heavy") ? 2 : 1;
+		const uint8 Fire = FTCG_ManaSource::ToMask(EManaType::Fire);
+		const uint8 Water = FTCG_ManaSource::ToMask(EManaType::Water);
+
+		TArray<FTCG_ManaSource> Lands;
+		for (int32 Index = 0; Index < 10 * Scale; Index++)
+		{
+			FTCG_ManaSource& Land = Lands.AddDefaulted_GetRef();
+			Land.SourceId = Index;
+			Land.ColorMask = Index % 5 < 2 ? Fire : Index % 5 < 4 ? Water : (Fire | Water);
+		}
+		return Lands;
+	}
+}
+
+TArray<FTCG_Bench::FResult> FTCG_Bench::Run(UWorld* World, const FString& Filter)
+{
+	TArray<FResult> Results;
+	RunDeckCases(World, Filter, Results);
+	RunManaCases(Filter, Results);
+
+	for (const FResult& Result : Results)
+	{
+		FString Params;
+		for (const TPair<FString, FString>& Param : Result.Params)
+		{
+			Params += FString::Printf(TEXT(" %s=%s"), *Param.Key, *Param.Value);
+		}
+		UE_LOG(LogTemp, Log, TEXT("%s%s: %.1f ns/op min, %.1f ns/op median, %lld ops"),
+			*Result.Name, *Params, Result.MinNsPerOp, Result.MedianNsPerOp, Result.Ops);
+	}
+	return Results;
+}
+
+void FTCG_Bench::RunDeckCases(UWorld* World, const FString& Filter, TArray<FResult>& OutResults)
+{
+	static const TCHAR* DeckCases[] = { TEXT("Shuffle"), TEXT("Draw"), TEXT("ReturnCard"), TEXT("Mulligan") };
+	if (!World || !Algo::AnyOf(DeckCases, [&Filter](const TCHAR* Name) { return PassesFilter(Name, Filter); }))
+	{
+		return;
+	}
+
+	// a transient deck of plain cards, outside the zone index and the match.
+	// it doesn't stream, the cards' default data has no assets to load
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags = RF_Transient;
+	ADeck* Deck = World->SpawnActor<ADeck>(ADeck::StaticClass(), SpawnParams);
+	if (!Deck)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Benchmark deck not spawned"));
+		return;
+	}
+	Deck->SetReplicates(false);
+	Deck->SetStreamCardAssets(false);
+	Deck->SetShuffleSeed(0x7C6);
+
+	TArray<ACardBase*> Cards;
+	for (int32 Index = 0; Index < MaxCardActors; Index++)
+	{
+		ACardBase* Card = World->SpawnActor<ACardBase>(ACardBase::StaticClass(), SpawnParams);
+		if (Card)
+		{
+			Card->SetReplicates(false);
+			Cards.Add(Card);
+		}
+	}
+	if (Cards.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Benchmark cards not spawned"));
+		Deck->Destroy();
+		return;
+	}
+
+	for (const int32 DeckSize : DeckSizes)
+	{
+		TArray<ACardBase*> Template;
+		Template.Reserve(DeckSize);
+		for (int32 Index = 0; Index < DeckSize; Index++)
+		{
+			Template.Add(Cards[Index % Cards.Num()]);
+		}
+		TArray<TPair<FString, FString>> Params = { { TEXT("deck"), FString::FromInt(DeckSize) } };
+		auto ResetDeck = [Deck, &Template]() { Deck->SetDecklist(Template); };
+
+		if (PassesFilter(TEXT("Shuffle"), Filter))
+		{
+			const int32 Shuffles = FMath::Max(1, 4000 / DeckSize);
+			OutResults.Add(Measure(TEXT("Shuffle"), Params, Shuffles, ResetDeck, [Deck, Shuffles]()
+				{
+					for (int32 Index = 0; Index < Shuffles; Index++)
+					{
+						Deck->Shuffle();
+					}
+				}));
+		}
+
+		// never draws into an empty deck, that path searches every actor
+		const int32 Draws = FMath::Min(DeckSize, DeckOpsPerBatch);
+		if (PassesFilter(TEXT("Draw"), Filter))
+		{
+			OutResults.Add(Measure(TEXT("Draw"), Params, Draws, ResetDeck, [Deck, Draws]()
+				{
+					for (int32 Index = 0; Index < Draws; Index++)
+					{
+						Deck->Draw();
+					}
+				}));
+		}
+
+		if (PassesFilter(TEXT("ReturnCard"), Filter))
+		{
+			OutResults.Add(Measure(TEXT("ReturnCard"), Params, DeckOpsPerBatch, ResetDeck, [Deck, &Cards]()
+				{
+					for (int32 Index = 0; Index < DeckOpsPerBatch; Index++)
+					{
+						Deck->ReturnCard(Cards[Index % Cards.Num()]);
+					}
+				}));
+		}
+
+		if (PassesFilter(TEXT("Mulligan"), Filter))
+		{
+			OutResults.Add(Measure(TEXT("Mulligan"), Params, DeckOpsPerBatch, ResetDeck, [Deck, &Cards]()
+				{
+					for (int32 Index = 0; Index < DeckOpsPerBatch; Index++)
+					{
+						Deck->Mulligan(Cards[Index % Cards.Num()]);
+					}
+				}));
+		}
+	}
+
+	for (ACardBase* Card : Cards)
+	{
+		Card->Destroy();
+	}
+	Deck->SetDecklist(TArray<ACardBase*>());
+	Deck->Destroy();
+}
+
+void FTCG_Bench::RunManaCases(const FString& Filter, TArray<FResult>& OutResults)
+{
+	static const TCHAR* Shapes[] = { TEXT("Mono"), TEXT("Split"), TEXT("Heavy"), TEXT("Alternatives") };
+
+	for (const TCHAR* Shape : Shapes)
+	{
+		const TArray<FTCG_ManaSource> Lands = MakeLands(Shape);
+		for (const int32 HandSize : HandSizes)
+		{
+			TArray<TArray<FManaCost>> Hand;
+			for (int32 Index = 0; Index < HandSize; Index++)
+			{
+				Hand.Add(MakeCardCosts(Shape, Index));
+			}
+			TArray<const TArray<FManaCost>*> FutureCosts;
+			for (const TArray<FManaCost>& Card : Hand)
+			{
+				FutureCosts.Add(&Card);
+			}
+
+			TArray<TPair<FString, FString>> Params = {
+				{ TEXT("hand"), FString::FromInt(HandSize) },
+				{ TEXT("shape"), Shape },
+				{ TEXT("lands"), FString::FromInt(Lands.Num()) } };
+
+			// one op is a whole hand after the untapped lands changed
+			FTCG_ManaSolver Solver;
+			if (PassesFilter(TEXT("ManaPlayable"), Filter))
+			{
+				OutResults.Add(Measure(TEXT("ManaPlayable"), Params, HandsPerBatch, []() {},
+					[&Solver, &Lands, &Hand]()
+					{
+						for (int32 Index = 0; Index < HandsPerBatch; Index++)
+						{
+							Solver.SetSources(Lands);
+							for (const TArray<FManaCost>& Card : Hand)
+							{
+								Solver.CanPayAny(Card);
+							}
+						}
+					}));
+			}
+
+			if (PassesFilter(TEXT("ManaSolve"), Filter))
+			{
+				OutResults.Add(Measure(TEXT("ManaSolve"), Params, HandsPerBatch, []() {},
+					[&Solver, &Lands, &Hand, &FutureCosts]()
+					{
+						for (int32 Index = 0; Index < HandsPerBatch; Index++)
+						{
+							Solver.SetSources(Lands);
+							for (const TArray<FManaCost>& Card : Hand)
+							{
+								Solver.Solve(Card, FutureCosts);
+							}
+						}
+					}));
+			}
+		}
+	}
+}
+
+FString FTCG_Bench::ExportJson(const TArray<FResult>& Results, const FString& Path)
+{
+	FString Json = TEXT("{\n");
+	Json += FString::Printf(TEXT("\t\"build\": \"%s\",\n\t\"platform\": \"%s\",\n\t\"minTime\": %.3f,\n"),
+		LexToString(FApp::GetBuildConfiguration()), ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()),
+		CVarBenchMinTime.GetValueOnGameThread());
+
+	// what the fields are, and what the benchmark doesn't measure
+	Json += TEXT("\t\"schema\": {\n");
+	Json += TEXT("\t\t\"nsPerOpMin\": \"fastest batch, wall time per op\",\n");
+	Json += TEXT("\t\t\"nsPerOpMedian\": \"median batch, wall time per op\",\n");
+	Json += TEXT("\t\t\"taggedBytesPerOp\": \"net growth of the TCG and TweenMaker LLM tags per op, null without -llm. Stands in for allocations per op, memory allocated and freed within the op counts 0\",\n");
+	Json += TEXT("\t\t\"cacheMisses\": \"not measured, use a hardware profiler\"\n");
+	Json += TEXT("\t},\n\t\"results\": [\n");
+
+	for (int32 Index = 0; Index < Results.Num(); Index++)
+	{
+		const FResult& Result = Results[Index];
+		FString Params;
+		for (const TPair<FString, FString>& Param : Result.Params)
+		{
+			Params += FString::Printf(TEXT("%s\"%s\": %s"), Params.IsEmpty() ? TEXT("") : TEXT(", "),
+				*Param.Key, Param.Value.IsNumeric() ? *Param.Value : *FString::Printf(TEXT("\"%s\""), *Param.Value));
+		}
+
+		Json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"params\": { %s }, \"ops\": %lld, \"nsPerOpMin\": %.2f, \"nsPerOpMedian\": %.2f, \"taggedBytesPerOp\": %s }%s\n"),
+			*Result.Name, *Params, Result.Ops, Result.MinNsPerOp, Result.MedianNsPerOp,
+			Result.TaggedBytesPerOp >= 0.0 ? *FString::Printf(TEXT("%.2f"), Result.TaggedBytesPerOp) : TEXT("null"),
+			Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+	Json += TEXT("\t]\n}\n");
+
+	const FString FilePath = Path.IsEmpty() ? FPaths::ProfilingDir() / FString::Printf(
+		TEXT("TCG_Bench_%s.json"), *FDateTime::Now().ToString()) : Path;
+	if (!FFileHelper::SaveStringToFile(Json, *FilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Benchmark results not written to %s"), *FilePath);
+		return FString();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Benchmark results written to %s"), *FilePath);
+	return FilePath;
+}
@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_CardBitmapIndex.h"
+#include "TCG_CardDatabase.h"
+#include "Algo/StableSort.h"
+
+template <typename EnumType>
+static int32 GetEnumCount()
+{
+	// NumEnums includes the generated _MAX entry
+	return StaticEnum<EnumType>()->NumEnums() - 1;
+}
+
+void FTCG_CardBitmapIndex::Build(const FTCG_CardDatabase& CardDatabase)
+{
+	const TArray<FTCG_CardEntry>& Entries = CardDatabase.GetEntries();
+	const int32 NumCards = Entries.Num();
+
+	CardIds.SetNum(NumCards);
+	ByCardType.Init(FTCG_CardBitset(NumCards), GetEnumCount<ECardType>());
+	ByRarity.Init(FTCG_CardBitset(NumCards), GetEnumCount<ERarity>());
+	ByManaType.Init(FTCG_CardBitset(NumCards), GetEnumCount<EManaType>());
+	for (TArray<FTCG_CardBitset>& Buckets : AtLeast)
+	{
+		Buckets.Init(FTCG_CardBitset(NumCards), NumStatBuckets);
+	}
+	Owned.Init(NumCards, true);
+
+	for (int32 Index = 0; Index < NumCards; Index++)
+	{
+		const FTCG_CardEntry& Entry = Entries[Index];
+		CardIds[Index] = Entry.CardId;
+
+		ByCardType[static_cast<int32>(Entry.CardType)].Set(Index);
+		ByRarity[static_cast<int32>(Entry.Rarity)].Set(Index);
+
+		if (Entry.CardType == ECardType::Mana)
+		{
+			ByManaType[static_cast<int32>(Entry.ManaType)].Set(Index);
+		}
+		for (const FManaCost& Option : Entry.Costs)
+		{
+			for (const TPair<EManaType, int32>& Cost : Option.Cost)
+			{
+				if (Cost.Value > 0)
+				{
+					ByManaType[static_cast<int32>(Cost.Key)].Set(Index);
+				}
+			}
+		}
+
+		const int32 Stats[] = { GetTotalCost(Entry), Entry.Attack, Entry.HitPoint };
+		for (int32 Stat = 0; Stat < UE_ARRAY_COUNT(Stats); Stat++)
+		{
+			for (int32 Bucket = 0; Bucket <= ToBucket(Stats[Stat]); Bucket++)
+			{
+				AtLeast[Stat][Bucket].Set(Index);
+			}
+		}
+	}
+
+	SortOrders.SetNum(GetEnumCount<ECardSortKey>());
+	for (int32 Key = 0; Key < SortOrders.Num(); Key++)
+	{
+		BuildSortOrder(Entries, static_cast<ECardSortKey>(Key));
+	}
+}
+
+void FTCG_CardBitmapIndex::RebuildNameOrder(const FTCG_CardDatabase& CardDatabase)
+{
+	if (SortOrders.IsValidIndex(static_cast<int32>(ECardSortKey::Name)))
+	{
+		BuildSortOrder(CardDatabase.GetEntries(), ECardSortKey::Name);
+	}
+}
+
+void FTCG_CardBitmapIndex::BuildSortOrder(const TArray<FTCG_CardEntry>& Entries, 
+	const ECardSortKey SortKey)
+{
+	TArray<int32>& Order = SortOrders[static_cast<int32>(SortKey)];
+	Order.SetNum(Entries.Num());
+	for (int32 Index = 0; Index < Entries.Num(); Index++)
+	{
+		Order[Index] = Index;
+	}
+
+	Algo::StableSort(Order, [&Entries, SortKey](const int32 A, const int32 B)
+		{
+			const FTCG_CardEntry& Left = Entries[A];
+			const FTCG_CardEntry& Right = Entries[B];
+			switch (SortKey)
+			{
+			case ECardSortKey::Name:
+				// collation of the current culture
+				return Left.Data->CardName.CompareTo(Right.Data->CardName) < 0;
+			case ECardSortKey::Cost:
+				return GetTotalCost(Left) < GetTotalCost(Right);
+			case ECardSortKey::Attack:
+				return Left.Attack < Right.Attack;
+			case ECardSortKey::HitPoint:
+				return Left.HitPoint < Right.HitPoint;
+			default:
+				return Left.CardId < Right.CardId;
+			}
+		});
+}
+
+void FTCG_CardBitmapIndex::SetOwnedCards(const TArray<int32>& OwnedCardIds)
+{
+	TMap<int32, int32> CardIdToIndex;
+	CardIdToIndex.Reserve(CardIds.Num());
+	for (int32 Index = 0; Index < CardIds.Num(); Index++)
+	{
+		CardIdToIndex.Add(CardIds[Index], Index);
+	}
+
+	Owned.Init(CardIds.Num());
+	for (const int32 CardId : OwnedCardIds)
+	{
+		if (const int32* Index = CardIdToIndex.Find(CardId))
+		{
+			Owned.Set(*Index);
+		}
+	}
+}
+
+FTCG_CardBitset FTCG_CardBitmapIndex::Evaluate(const FTCG_CardFilter& Filter) const
+{
+	FTCG_CardBitset Result(CardIds.Num(), true);
+
+	auto AndFacet = [&Result](const TArray<FTCG_CardBitset>& Bitsets, auto&& Values)
+		{
+			if (Values.Num() == 0)
+			{
+				return;
+			}
+
+			FTCG_CardBitset Facet(Result.Num());
+			for (const auto Value : Values)
+			{
+				Facet |= Bitsets[static_cast<int32>(Value)];
+			}
+			Result &= Facet;
+		};
+
+	AndFacet(ByCardType, Filter.CardTypes);
+	AndFacet(ByRarity, Filter.Rarities);
+	AndFacet(ByManaType, Filter.ManaTypes);
+
+	AndRange(Result, EStat::Cost, Filter.MinCost, Filter.MaxCost);
+	AndRange(Result, EStat::Attack, Filter.MinAttack, Filter.MaxAttack);
+	AndRange(Result, EStat::HitPoint, Filter.MinHitPoint, Filter.MaxHitPoint);
+
+	if (Filter.bOwnedOnly)
+	{
+		Result &= Owned;
+	}
+	return Result;
+}
+
+int32 FTCG_CardBitmapIndex::Query(const FTCG_CardFilter& Filter, 
+	TArray<int32>& OutCardIds) const
+{
+	OutCardIds.Reset();
+
+	const FTCG_CardBitset Matches = Evaluate(Filter);
+	const int32 Total = Matches.CountSetBits();
+
+	const int32 PageSize = FMath::Max(Filter.PageSize, 1);
+	int32 Skip = FMath::Max(Filter.PageIndex, 0) * PageSize;
+	if (Skip >= Total || !SortOrders.IsValidIndex(static_cast<int32>(Filter.SortBy)))
+	{
+		return Total;
+	}
+
+	for (const int32 Index : SortOrders[static_cast<int32>(Filter.SortBy)])
+	{
+		if (!Matches.Contains(Index))
+		{
+			continue;
+		}
+		if (Skip > 0)
+		{
+			Skip--;
+			continue;
+		}
+
+		OutCardIds.Add(CardIds[Index]);
+		if (OutCardIds.Num() == PageSize)
+		{
+			break;
+		}
+	}
+	return Total;
+}
+
+int32 FTCG_CardBitmapIndex::GetTotalCost(const FTCG_CardEntry& Entry)
+{
+	// cheapest alternative
+	int32 Cheapest = Entry.Costs.Num() > 0 ? MAX_int32 : 0;
+	for (const FManaCost& Option : Entry.Costs)
+	{
+		int32 Total = 0;
+		for (const TPair<EManaType, int32>& Cost : Option.Cost)
+		{
+			Total += Cost.Value;
+		}
+		Cheapest = FMath::Min(Cheapest, Total);
+	}
+	return Cheapest;
+}
+
+int32 FTCG_CardBitmapIndex::ToBucket(const int32 Value)
+{
+	return FMath::Clamp(Value, 0, NumStatBuckets - 1);
+}
+
+void FTCG_CardBitmapIndex::AndRange(FTCG_CardBitset& Result, const EStat Stat, 
+	const int32 Min, const int32 Max) const
+{
+	const TArray<FTCG_CardBitset>& Buckets = AtLeast[static_cast<int32>(Stat)];
+
+	if (Min > 0)
+	{
+		Result &= Buckets[ToBucket(Min)];
+	}
+	if (Max < NumStatBuckets - 1)
+	{
+		Result.AndNot(Buckets[ToBucket(Max + 1)]);
+	}
+}
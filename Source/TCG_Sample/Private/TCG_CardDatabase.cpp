@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_CardDatabase.h"
+#include "TCG_MemoryTags.h"
+#include "Engine/DataTable.h"
+
+void FTCG_CardDatabase::Build(const TArray<const UDataTable*>& Tables)
+{
+	LLM_SCOPE_BYTAG(TCG_Cards);
+
+	Entries.Reset();
+	CardIdToIndex.Reset();
+
+	for (const UDataTable* Table : Tables)
+	{
+		const UScriptStruct* RowStruct = Table ? Table->GetRowStruct() : nullptr;
+		if (!RowStruct || !RowStruct->IsChildOf(FCardData::StaticStruct()))
+		{
+			continue;
+		}
+
+		const bool bMinion = RowStruct->IsChildOf(FMinionData::StaticStruct());
+		const bool bSpell = RowStruct->IsChildOf(FSpellData::StaticStruct());
+		const bool bLand = RowStruct->IsChildOf(FLandData::StaticStruct());
+
+		for (const TPair<FName, uint8*>& Row : Table->GetRowMap())
+		{
+			const FCardData* Data = reinterpret_cast<const FCardData*>(Row.Value);
+			if (CardIdToIndex.Contains(Data->CardId))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Duplicate CardId %d in %s"), 
+					Data->CardId, *Row.Key.ToString());
+				continue;
+			}
+
+			FTCG_CardEntry Entry;
+			Entry.CardId = Data->CardId;
+			Entry.RowName = Row.Key;
+			Entry.CardType = Data->CardType;
+			Entry.Rarity = Data->Rarity;
+			Entry.Data = Data;
+
+			if (bMinion)
+			{
+				const FMinionData* Minion = static_cast<const FMinionData*>(Data);
+				Entry.Attack = Minion->Attack;
+				Entry.HitPoint = Minion->HitPoint;
+				Entry.Costs = Minion->Costs;
+			}
+			else if (bSpell)
+			{
+				Entry.Costs = static_cast<const FSpellData*>(Data)->Costs;
+			}
+			else if (bLand)
+			{
+				Entry.ManaType = static_cast<const FLandData*>(Data)->IncreaseManaType;
+			}
+
+			CardIdToIndex.Add(Entry.CardId, Entries.Add(MoveTemp(Entry)));
+		}
+	}
+}
+
+const FTCG_CardEntry* FTCG_CardDatabase::Find(const int32 CardId) const
+{
+	const int32 Index = IndexOf(CardId);
+	return Index != INDEX_NONE ? &Entries[Index] : nullptr;
+}
+
+int32 FTCG_CardDatabase::IndexOf(const int32 CardId) const
+{
+	const int32* Index = CardIdToIndex.Find(CardId);
+	return Index ? *Index : INDEX_NONE;
+}
+
+bool FTCG_CardDatabase::ValidateDecklist(const FTCG_Decklist& Decklist, 
+	FString& OutError) const
+{
+	if (Decklist.CardIds.Num() < MinDeckSize || Decklist.CardIds.Num() > MaxDeckSize)
+	{
+		OutError = FString::Printf(TEXT("%s has %d cards, needs %d to %d"), 
+			*Decklist.DeckName, Decklist.CardIds.Num(), MinDeckSize, MaxDeckSize);
+		return false;
+	}
+
+	TMap<int32, int32> Copies;
+	for (const int32 CardId : Decklist.CardIds)
+	{
+		const FTCG_CardEntry* Entry = Find(CardId);
+		if (!Entry)
+		{
+			OutError = FString::Printf(TEXT("%s has unknown card %d"), 
+				*Decklist.DeckName, CardId);
+			return false;
+		}
+
+		// lands are not limited
+		const int32 Count = ++Copies.FindOrAdd(CardId);
+		const int32 Limit = Entry->Rarity == ERarity::Rare ? MaxRareCopies : MaxCopies;
+		if (Entry->CardType != ECardType::Mana && Count > Limit)
+		{
+			OutError = FString::Printf(TEXT("%s has more than %d copies of card %d"), 
+				*Decklist.DeckName, Limit, CardId);
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_CardSearchIndex.h"
+#include "TCG_CardDatabase.h"
+#include "Algo/BinarySearch.h"
+
+void FTCG_CardSearchIndex::Build(const FTCG_CardDatabase& CardDatabase, 
+	const FString& InCulture)
+{
+	const TArray<FTCG_CardEntry>& Entries = CardDatabase.GetEntries();
+
+	Culture = InCulture;
+	Names.SetNum(Entries.Num());
+	Descriptions.SetNum(Entries.Num());
+	CardIds.SetNum(Entries.Num());
+	Postings.Reset();
+	LastQuery.Reset();
+	LastMatches.Reset();
+
+	for (int32 Index = 0; Index < Entries.Num(); Index++)
+	{
+		CardIds[Index] = Entries[Index].CardId;
+		Names[Index] = Entries[Index].Data->CardName.ToString().ToLower();
+		Descriptions[Index] = Entries[Index].Data->CardDescription.ToString().ToLower();
+
+		AddTrigrams(Names[Index], Index);
+		AddTrigrams(Descriptions[Index], Index);
+	}
+}
+
+int32 FTCG_CardSearchIndex::Search(const FString& Query, const int32 MaxResults, 
+	TArray<int32>& OutCardIds)
+{
+	OutCardIds.Reset();
+
+	const FString LowerQuery = Query.TrimStartAndEnd().ToLower();
+	if (LowerQuery.IsEmpty())
+	{
+		LastQuery.Reset();
+		LastMatches.Reset();
+		return 0;
+	}
+
+	TArray<int32> Candidates;
+	if (!LastQuery.IsEmpty() && LowerQuery.Contains(LastQuery))
+	{
+		// refining, anything matching now matched the previous query too
+		Candidates = MoveTemp(LastMatches);
+	}
+	else if (LowerQuery.Len() >= 3)
+	{
+		// intersect posting lists, starting from the shortest
+		TArray<const TArray<int32>*> Lists;
+		for (int32 Start = 0; Start + 3 <= LowerQuery.Len(); Start++)
+		{
+			const TArray<int32>* List = Postings.Find(MakeTrigram(*LowerQuery + Start));
+			if (!List)
+			{
+				LastQuery = LowerQuery;
+				LastMatches.Reset();
+				return 0;
+			}
+			Lists.AddUnique(List);
+		}
+		Lists.Sort([](const TArray<int32>& A, const TArray<int32>& B) 
+			{ 
+				return A.Num() < B.Num(); 
+			});
+
+		Candidates = *Lists[0];
+		for (int32 ListIndex = 1; ListIndex < Lists.Num() && Candidates.Num() > 0; ListIndex++)
+		{
+			const TArray<int32>& List = *Lists[ListIndex];
+			Candidates.RemoveAll([&List](const int32 CardIndex)
+				{
+					return Algo::BinarySearch(List, CardIndex) == INDEX_NONE;
+				});
+		}
+	}
+	else
+	{
+		// too short for trigrams, plain scan over names and text
+		Candidates.SetNum(Names.Num());
+		for (int32 Index = 0; Index < Names.Num(); Index++)
+		{
+			Candidates[Index] = Index;
+		}
+	}
+
+	// trigrams only say the pieces are there, check the real substring
+	TArray<TPair<EMatchRank, int32>> Ranked;
+	Ranked.Reserve(Candidates.Num());
+	LastMatches.Reset();
+	for (const int32 CardIndex : Candidates)
+	{
+		const EMatchRank MatchRank = Rank(CardIndex, LowerQuery);
+		if (MatchRank != EMatchRank::None)
+		{
+			Ranked.Emplace(MatchRank, CardIndex);
+			LastMatches.Add(CardIndex);
+		}
+	}
+	LastQuery = LowerQuery;
+
+	Ranked.Sort([this](const TPair<EMatchRank, int32>& A, const TPair<EMatchRank, int32>& B)
+		{
+			if (A.Key != B.Key)
+			{
+				return A.Key < B.Key;
+			}
+			return Names[A.Value].Len() < Names[B.Value].Len();
+		});
+
+	const int32 ResultNum = FMath::Min(Ranked.Num(), FMath::Max(MaxResults, 0));
+	OutCardIds.Reserve(ResultNum);
+	for (int32 Index = 0; Index < ResultNum; Index++)
+	{
+		OutCardIds.Add(CardIds[Ranked[Index].Value]);
+	}
+	return Ranked.Num();
+}
+
+uint64 FTCG_CardSearchIndex::MakeTrigram(const TCHAR* Chars)
+{
+	// 21 bits covers any code point
+	constexpr uint64 Mask = (1ull << 21) - 1;
+	return (static_cast<uint64>(Chars[0]) & Mask)
+		| ((static_cast<uint64>(Chars[1]) & Mask) << 21)
+		| ((static_cast<uint64>(Chars[2]) & Mask) << 42);
+}
+
+void FTCG_CardSearchIndex::AddTrigrams(const FString& Text, const int32 CardIndex)
+{
+	for (int32 Start = 0; Start + 3 <= Text.Len(); Start++)
+	{
+		// cards are added in index order, so lists stay sorted
+		TArray<int32>& List = Postings.FindOrAdd(MakeTrigram(*Text + Start));
+		if (List.Num() == 0 || List.Last() != CardIndex)
+		{
+			List.Add(CardIndex);
+		}
+	}
+}
+
+FTCG_CardSearchIndex::EMatchRank FTCG_CardSearchIndex::Rank(const int32 CardIndex, 
+	const FString& LowerQuery) const
+{
+	const FString& Name = Names[CardIndex];
+	const int32 Found = Name.Find(LowerQuery, ESearchCase::CaseSensitive);
+	if (Found != INDEX_NONE)
+	{
+		if (Found == 0)
+		{
+			return Name.Len() == LowerQuery.Len() ? EMatchRank::NameExact 
+				: EMatchRank::NamePrefix;
+		}
+
+		// any later occurrence starting a word ranks above a mid-word one
+		for (int32 Start = Found; Start != INDEX_NONE; 
+			Start = Name.Find(LowerQuery, ESearchCase::CaseSensitive, 
+				ESearchDir::FromStart, Start + 1))
+		{
+			if (!FChar::IsAlnum(Name[Start - 1]))
+			{
+				return EMatchRank::NameWordStart;
+			}
+		}
+		return EMatchRank::NameSubstring;
+	}
+
+	if (Descriptions[CardIndex].Contains(LowerQuery, ESearchCase::CaseSensitive))
+	{
+		return EMatchRank::Description;
+	}
+	return EMatchRank::None;
+}
@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_DeckCode.h"
+#include "TCG_MemoryTags.h"
+#include "TCG_CardDatabase.h"
+#include "Misc/Base64.h"
+#include "Misc/Crc.h"
+
+// a deck never has more distinct cards or copies than this
+static constexpr uint32 MaxDeckCodeEntries = 256;
+
+FString FTCG_DeckCode::Encode(const FTCG_Decklist& Decklist)
+{
+	LLM_SCOPE_BYTAG(TCG_Decks);
+
+	TMap<int32, int32> Copies;
+	for (const int32 CardId : Decklist.CardIds)
+	{
+		Copies.FindOrAdd(CardId)++;
+	}
+	Copies.KeySort(TLess<int32>());
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(4 + Copies.Num() * 3);
+	Bytes.Add(Version);
+	WriteVarint(Bytes, Copies.Num());
+
+	// ids are sorted, so deltas stay small
+	int32 PreviousId = 0;
+	for (const TPair<int32, int32>& Entry : Copies)
+	{
+		WriteVarint(Bytes, static_cast<uint32>(Entry.Key - PreviousId));
+		WriteVarint(Bytes, static_cast<uint32>(Entry.Value));
+		PreviousId = Entry.Key;
+	}
+
+	const uint16 Sum = Checksum(Bytes.GetData(), Bytes.Num());
+	Bytes.Add(static_cast<uint8>(Sum & 0xFF));
+	Bytes.Add(static_cast<uint8>(Sum >> 8));
+
+	return FBase64::Encode(Bytes, EBase64Mode::UrlSafe);
+}
+
+bool FTCG_DeckCode::Decode(const FString& Code, FTCG_Decklist& OutDecklist, 
+	FString& OutError)
+{
+	LLM_SCOPE_BYTAG(TCG_Decks);
+
+	TArray<uint8> Bytes;
+	if (!FBase64::Decode(Code, Bytes, EBase64Mode::UrlSafe) || Bytes.Num() < 4)
+	{
+		OutError = TEXT("Not a deck code");
+		return false;
+	}
+
+	const int32 PayloadNum = Bytes.Num() - 2;
+	const uint16 Stored = Bytes[PayloadNum] | (Bytes[PayloadNum + 1] << 8);
+	if (Stored != Checksum(Bytes.GetData(), PayloadNum))
+	{
+		OutError = TEXT("Deck code checksum mismatch");
+		return false;
+	}
+	Bytes.SetNum(PayloadNum, EAllowShrinking::No);
+
+	if (Bytes[0] != Version)
+	{
+		OutError = FString::Printf(TEXT("Unsupported deck code version %d"), Bytes[0]);
+		return false;
+	}
+
+	int32 Offset = 1;
+	uint32 EntryNum = 0;
+	if (!ReadVarint(Bytes, Offset, EntryNum) || EntryNum > MaxDeckCodeEntries)
+	{
+		OutError = TEXT("Corrupt deck code");
+		return false;
+	}
+
+	OutDecklist.CardIds.Reset();
+	int32 CardId = 0;
+	for (uint32 Index = 0; Index < EntryNum; Index++)
+	{
+		uint32 Delta = 0;
+		uint32 Count = 0;
+		if (!ReadVarint(Bytes, Offset, Delta) || !ReadVarint(Bytes, Offset, Count)
+			|| Count == 0 || Count > MaxDeckCodeEntries)
+		{
+			OutError = TEXT("Corrupt deck code");
+			return false;
+		}
+
+		CardId += static_cast<int32>(Delta);
+		for (uint32 Copy = 0; Copy < Count; Copy++)
+		{
+			OutDecklist.CardIds.Add(CardId);
+		}
+	}
+
+	if (Offset != Bytes.Num())
+	{
+		OutError = TEXT("Trailing data in deck code");
+		return false;
+	}
+	return true;
+}
+
+bool FTCG_DeckCode::Validate(const FString& Code, const FTCG_CardDatabase& CardDatabase, 
+	FString& OutError)
+{
+	FTCG_Decklist Decklist;
+	return Decode(Code, Decklist, OutError) 
+		&& CardDatabase.ValidateDecklist(Decklist, OutError);
+}
+
+void FTCG_DeckCode::WriteVarint(TArray<uint8>& Bytes, uint32 Value)
+{
+	while (Value >= 0x80)
+	{
+		Bytes.Add(static_cast<uint8>(Value | 0x80));
+		Value >>= 7;
+	}
+	Bytes.Add(static_cast<uint8>(Value));
+}
+
+bool FTCG_DeckCode::ReadVarint(const TArray<uint8>& Bytes, int32& Offset, 
+	uint32& OutValue)
+{
+	OutValue = 0;
+	for (int32 Shift = 0; Shift < 35; Shift += 7)
+	{
+		if (Offset >= Bytes.Num())
+		{
+			return false;
+		}
+
+		const uint8 Byte = Bytes[Offset++];
+		OutValue |= static_cast<uint32>(Byte & 0x7F) << Shift;
+		if ((Byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint16 FTCG_DeckCode::Checksum(const uint8* Data, const int32 Num)
+{
+	const uint32 Crc = FCrc::MemCrc32(Data, Num);
+	return static_cast<uint16>(Crc ^ (Crc >> 16));
+}
@@ -1,4 +1,104 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 
-#include "TCG_Definitions.h"
\ No newline at end of file
+#include "TCG_Definitions.h"
+#include "TCG_NetPacking.h"
+
+bool FManaCost::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	const int32 ManaTypeNum = StaticEnum<EManaType>()->NumEnums() - 1;
+	int32 Bits = 0;
+
+	if (Ar.IsLoading())
+	{
+		Cost.Reset();
+	}
+	for (int32 Type = 0; Type < ManaTypeNum; Type++)
+	{
+		const EManaType ManaType = static_cast<EManaType>(Type);
+		int32 Amount = Ar.IsSaving() ? Cost.FindRef(ManaType) : 0;
+
+		Bits++;
+		if (!FTCG_NetPacking::SerializeFlag(Ar, Amount != 0))
+		{
+			continue;
+		}
+
+		// the top value escapes to the full width amount
+		int32 Quantized = Amount >= 0 && Amount < NetAmountEscape ? Amount : NetAmountEscape;
+		Bits += FTCG_NetPacking::SerializeQuantized(Ar, Quantized, NetAmountEscape);
+		if (Quantized == NetAmountEscape)
+		{
+			Bits += FTCG_NetPacking::SerializeSigned(Ar, Amount);
+		}
+		else
+		{
+			Amount = Quantized;
+		}
+		if (Ar.IsLoading())
+		{
+			Cost.Add(ManaType, Amount);
+		}
+	}
+
+	if (Ar.IsSaving())
+	{
+		// what a TArray of (uint8 key, int32 amount) pairs would cost
+		FTCG_NetPacking::Record(ETCG_PackedStruct::ManaCost, Bits, 32 + Cost.Num() * 40);
+	}
+	bOutSuccess = true;
+	return true;
+}
+
+bool FTCG_CardHandle::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	int32 Bits = 1;
+	if (FTCG_NetPacking::SerializeFlag(Ar, IsValid()))
+	{
+		Bits += FTCG_NetPacking::SerializeUnsigned(Ar, Index);
+	}
+	else
+	{
+		Index = INDEX_NONE;
+	}
+
+	if (Ar.IsSaving())
+	{
+		FTCG_NetPacking::Record(ETCG_PackedStruct::CardHandle, Bits, 32);
+	}
+	bOutSuccess = true;
+	return true;
+}
+
+bool FTCG_NetHitpoint::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	int32 Bits = FTCG_NetPacking::SerializeSigned(Ar, Value);
+	Bits += FTCG_NetPacking::SerializeUnsigned(Ar, AckedPredictionKey);
+	if (Ar.IsSaving())
+	{
+		FTCG_NetPacking::Record(ETCG_PackedStruct::Hitpoint, Bits, 64);
+	}
+	bOutSuccess = true;
+	return true;
+}
+
+bool FTCG_Command::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	int32 TypeValue = static_cast<int32>(Type);
+
+	int32 Bits = FTCG_NetPacking::SerializeUnsigned(Ar, Serial);
+	// two seats
+	Bits += FTCG_NetPacking::SerializeQuantized(Ar, PlayerIndex, 1);
+	Bits += FTCG_NetPacking::SerializeQuantized(Ar, TypeValue, 
+		StaticEnum<ETCG_CommandType>()->NumEnums() - 2);
+	// phases, deck owners and damage are all small
+	Bits += FTCG_NetPacking::SerializeSigned(Ar, Value);
+
+	Type = static_cast<ETCG_CommandType>(TypeValue);
+	if (Ar.IsSaving())
+	{
+		FTCG_NetPacking::Record(ETCG_PackedStruct::Command, Bits, 32 + 32 + 8 + 32);
+	}
+	bOutSuccess = true;
+	return true;
+}
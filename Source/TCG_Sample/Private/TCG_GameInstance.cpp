@@ -2,10 +2,24 @@
 
 
 #include "TCG_GameInstance.h"
+#include "TCG_MemoryTags.h"
+#include "TCG_TraceLog.h"
 #include "Engine/World.h"
 #include "Online/OnlineSessionNames.h"
 #include "TCG_Definitions.h"
+#include "TCG_CardDatabase.h"
+#include "TCG_CardBitmapIndex.h"
+#include "TCG_CardSearchIndex.h"
+#include "TCG_DeckCode.h"
+#include "CardAssetStreamer.h"
 #include "OnlineSubsystem.h"
+#include "Async/Async.h"
+#include "Engine/AssetManager.h"
+#include "Engine/DataTable.h"
+#include "Internationalization/Culture.h"
+#include "Internationalization/Internationalization.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
 UTCG_GameInstance::UTCG_GameInstance()
 {
@@ -36,10 +50,222 @@ void UTCG_GameInstance::Init()
 				&UTCG_GameInstance::OnJoinSessionComplete);
 		}
 	}
+
+	FInternationalization::Get().OnCultureChanged().AddUObject(this, 
+		&UTCG_GameInstance::OnCultureChanged);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("TCGTrace")))
+	{
+		FTCG_TraceLog::Start();
+	}
+
+	StartPreload();
+}
+
+void UTCG_GameInstance::Shutdown()
+{
+	FTCG_TraceLog::Stop();
+
+	Super::Shutdown();
+}
+
+void UTCG_GameInstance::StartPreload()
+{
+	PreloadStartTime = FPlatformTime::Seconds();
+	SetPreloadPhase(ETCG_PreloadPhase::LoadingTables);
+
+	TArray<FSoftObjectPath> TablePaths;
+	for (const TSoftObjectPtr<UDataTable>& Table : CardTables)
+	{
+		if (!Table.IsNull())
+		{
+			TablePaths.Add(Table.ToSoftObjectPath());
+		}
+	}
+
+	if (TablePaths.Num() == 0)
+	{
+		OnCardTablesLoaded();
+		return;
+	}
+
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(TablePaths,
+		FStreamableDelegate::CreateUObject(this, &UTCG_GameInstance::OnCardTablesLoaded),
+		FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UTCG_GameInstance::OnCardTablesLoaded()
+{
+	LoadedCardTables.Reset();
+	TArray<const UDataTable*> Tables;
+	for (const TSoftObjectPtr<UDataTable>& Table : CardTables)
+	{
+		if (UDataTable* Loaded = Table.Get())
+		{
+			LoadedCardTables.Add(Loaded);
+			Tables.Add(Loaded);
+		}
+	}
+
+	SetPreloadPhase(ETCG_PreloadPhase::Indexing);
+
+	// the tables are kept alive by LoadedCardTables while the worker reads them
+	TWeakObjectPtr<UTCG_GameInstance> WeakThis(this);
+	TArray<FTCG_Decklist> DecksToValidate = Decklists;
+	const FString Culture = FInternationalization::Get().GetCurrentCulture()->GetName();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, 
+		[WeakThis, Tables, DecksToValidate, Culture]()
+		{
+			TSharedPtr<FTCG_CardDatabase, ESPMode::ThreadSafe> Database = 
+				MakeShared<FTCG_CardDatabase, ESPMode::ThreadSafe>();
+			Database->Build(Tables);
+
+			TSharedPtr<FTCG_CardBitmapIndex, ESPMode::ThreadSafe> Index = 
+				MakeShared<FTCG_CardBitmapIndex, ESPMode::ThreadSafe>();
+			Index->Build(*Database);
+
+			TSharedPtr<FTCG_CardSearchIndex, ESPMode::ThreadSafe> Search = 
+				MakeShared<FTCG_CardSearchIndex, ESPMode::ThreadSafe>();
+			Search->Build(*Database, Culture);
+
+			TArray<FString> Errors;
+			for (const FTCG_Decklist& Deck : DecksToValidate)
+			{
+				FString Error;
+				if (!Database->ValidateDecklist(Deck, Error))
+				{
+					Errors.Add(Error);
+				}
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Database, Index, Search, Errors]()
+				{
+					if (UTCG_GameInstance* GameInstance = WeakThis.Get())
+					{
+						GameInstance->OnCardDatabaseBuilt(Database, Index, Search, Errors);
+					}
+				});
+		});
+}
+
+void UTCG_GameInstance::OnCardDatabaseBuilt(
+	TSharedPtr<FTCG_CardDatabase, ESPMode::ThreadSafe> Database, 
+	TSharedPtr<FTCG_CardBitmapIndex, ESPMode::ThreadSafe> Index, 
+	TSharedPtr<FTCG_CardSearchIndex, ESPMode::ThreadSafe> Search, TArray<FString> Errors)
+{
+	CardDatabase = Database;
+	CardIndex = Index;
+	CardSearch = Search;
+	DeckErrors = MoveTemp(Errors);
+	// the culture may have changed while the worker was indexing
+	OnCultureChanged();
+
+	for (const FString& Error : DeckErrors)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Invalid deck: %s"), *Error);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Indexed %d cards, time to interactive: %.1f ms"),
+		CardDatabase->Num(), (FPlatformTime::Seconds() - GStartTime) * 1000.0);
+
+	SetPreloadPhase(ETCG_PreloadPhase::WarmingAssets);
+
+	UCardAssetStreamer* Streamer = GetSubsystem<UCardAssetStreamer>();
+	if (!Streamer || IsDedicatedServerInstance() || !Decklists.IsValidIndex(ActiveDeckIndex))
+	{
+		OnCardAssetsWarmed();
+		return;
+	}
+
+	// resident assets complete inside the request, so every card is
+	// requested before anything listens for the last load
+	for (const int32 CardId : Decklists[ActiveDeckIndex].CardIds)
+	{
+		if (const FTCG_CardEntry* Entry = CardDatabase->Find(CardId))
+		{
+			Streamer->PrewarmCardAssets(*Entry->Data);
+		}
+	}
+	WarmRequestNum = Streamer->GetPendingLoadNum();
+
+	if (WarmRequestNum == 0)
+	{
+		OnCardAssetsWarmed();
+		return;
+	}
+
+	WarmCompleteHandle = Streamer->OnAllLoadsComplete.AddUObject(this, 
+		&UTCG_GameInstance::OnCardAssetsWarmed);
+}
+
+void UTCG_GameInstance::OnCardAssetsWarmed()
+{
+	if (UCardAssetStreamer* Streamer = GetSubsystem<UCardAssetStreamer>())
+	{
+		Streamer->OnAllLoadsComplete.Remove(WarmCompleteHandle);
+	}
+
+	if (PreloadPhase != ETCG_PreloadPhase::WarmingAssets)
+	{
+		return;
+	}
+
+	const bool bSuccess = CardDatabase.IsValid() && CardDatabase->Num() > 0;
+	SetPreloadPhase(bSuccess ? ETCG_PreloadPhase::Complete : ETCG_PreloadPhase::Failed);
+	OnPreloadComplete.Broadcast(bSuccess);
+}
+
+void UTCG_GameInstance::SetPreloadPhase(const ETCG_PreloadPhase NewPhase)
+{
+	PreloadPhase = NewPhase;
+
+	const double Now = FPlatformTime::Seconds();
+	UE_LOG(LogTemp, Log, TEXT("Preload %s: %.1f ms since init, %.1f ms since start"),
+		*UEnum::GetValueAsString(NewPhase), (Now - PreloadStartTime) * 1000.0,
+		(Now - GStartTime) * 1000.0);
+}
+
+float UTCG_GameInstance::GetPreloadProgress() const
+{
+	switch (PreloadPhase)
+	{
+	case ETCG_PreloadPhase::LoadingTables:
+		return 0.f;
+	case ETCG_PreloadPhase::Indexing:
+		return 0.25f;
+	case ETCG_PreloadPhase::WarmingAssets:
+	{
+		const UCardAssetStreamer* Streamer = GetSubsystem<UCardAssetStreamer>();
+		if (!Streamer || WarmRequestNum == 0)
+		{
+			return 0.5f;
+		}
+		const int32 Done = FMath::Max(WarmRequestNum - Streamer->GetPendingLoadNum(), 0);
+		return 0.5f + 0.5f * Done / WarmRequestNum;
+	}
+	case ETCG_PreloadPhase::Complete:
+	case ETCG_PreloadPhase::Failed:
+		return 1.f;
+	default:
+		return 0.f;
+	}
+}
+
+void UTCG_GameInstance::MarkMatchStarted()
+{
+	if (bFirstMatchStarted)
+	{
+		return;
+	}
+
+	bFirstMatchStarted = true;
+	UE_LOG(LogTemp, Log, TEXT("Time to first match: %.1f ms"), 
+		(FPlatformTime::Seconds() - GStartTime) * 1000.0);
 }
 
 void UTCG_GameInstance::OnCreateSessionComplete(FName ServerName, bool bSuccess)
 {
+	TCG_TRACE(SessionCreated, "Session {0} created: {1}", ServerName, bSuccess);
+
 	bCreatingServer = false;
 	if (bSuccess)
 	{
@@ -54,13 +280,15 @@ void UTCG_GameInstance::OnCreateSessionComplete(FName ServerName, bool bSuccess)
 
 void UTCG_GameInstance::OnFindSessionComplete(bool bSuccess)
 {
+	LLM_SCOPE_BYTAG(TCG_Sessions);
+
 	if (bSuccess)
 	{
 		SearchResults.Empty();
 		SearchResults = SessionSearch->SearchResults;
 		if (SearchResults.Num() > 0)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("Found Servers, Num: %d"), SearchResults.Num());
+			TCG_TRACE(SessionsFound, "Found Servers, Num: {0}", SearchResults.Num());
 			for (FOnlineSessionSearchResult SearchResult : SearchResults)
 			{
 				FString SessionID = SearchResult.Session.GetSessionIdStr();
@@ -80,11 +308,11 @@ void UTCG_GameInstance::OnFindSessionComplete(bool bSuccess)
 void UTCG_GameInstance::OnJoinSessionComplete(FName ServerName, 
 	EOnJoinSessionCompleteResult::Type JoinSessoinCompleteResult)
 {
+	TCG_TRACE(SessionJoined, "Join session {0}, result {1}", ServerName, JoinSessoinCompleteResult);
+
 	switch (JoinSessoinCompleteResult)
 	{
 	case EOnJoinSessionCompleteResult::Success:
-		// UE_LOG(LogTemp, Warning, TEXT(
-		// 	"Joined Session, SessionName: %s"), *ServerName);
 		// when successful
 		break;
 	// all the others -> failure
@@ -146,6 +374,8 @@ bool UTCG_GameInstance::CreateServer(FString InSessionName, int32 PlayerNum)
 
 bool UTCG_GameInstance::FindServers()
 {
+	LLM_SCOPE_BYTAG(TCG_Sessions);
+
 	SessionSearch = MakeShareable(new FOnlineSessionSearch());
 	
 	SessionSearch->bIsLanQuery = true;
@@ -174,3 +404,75 @@ bool UTCG_GameInstance::FindLocalUserSteamID()
 {
 	return false;
 }
+
+int32 UTCG_GameInstance::FilterCollection(const FTCG_CardFilter& Filter, 
+	TArray<int32>& OutCardIds) const
+{
+	if (!CardIndex.IsValid())
+	{
+		OutCardIds.Reset();
+		return 0;
+	}
+	return CardIndex->Query(Filter, OutCardIds);
+}
+
+int32 UTCG_GameInstance::SearchCards(const FString& Query, const int32 MaxResults, 
+	TArray<int32>& OutCardIds)
+{
+	if (!CardSearch.IsValid())
+	{
+		OutCardIds.Reset();
+		return 0;
+	}
+	return CardSearch->Search(Query, MaxResults, OutCardIds);
+}
+
+void UTCG_GameInstance::OnCultureChanged()
+{
+	const FString Culture = FInternationalization::Get().GetCurrentCulture()->GetName();
+	if (CardDatabase.IsValid() && CardSearch.IsValid() && CardSearch->GetCulture() != Culture)
+	{
+		CardSearch->Build(*CardDatabase, Culture);
+		// the deck builder's name sort was collated with the old culture too
+		if (CardIndex.IsValid())
+		{
+			CardIndex->RebuildNameOrder(*CardDatabase);
+		}
+	}
+}
+
+void UTCG_GameInstance::SetOwnedCards(const TArray<int32>& OwnedCardIds)
+{
+	if (CardIndex.IsValid())
+	{
+		CardIndex->SetOwnedCards(OwnedCardIds);
+	}
+}
+
+FString UTCG_GameInstance::ExportDeckCode(const int32 DeckIndex) const
+{
+	if (!Decklists.IsValidIndex(DeckIndex))
+	{
+		return FString();
+	}
+	return FTCG_DeckCode::Encode(Decklists[DeckIndex]);
+}
+
+bool UTCG_GameInstance::ImportDeckCode(const FString& Code, const FString& DeckName, 
+	FString& OutError)
+{
+	FTCG_Decklist Decklist;
+	if (!FTCG_DeckCode::Decode(Code, Decklist, OutError))
+	{
+		return false;
+	}
+	Decklist.DeckName = DeckName;
+
+	if (CardDatabase.IsValid() && !CardDatabase->ValidateDecklist(Decklist, OutError))
+	{
+		return false;
+	}
+
+	Decklists.Add(MoveTemp(Decklist));
+	return true;
+}
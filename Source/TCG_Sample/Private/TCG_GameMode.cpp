@@ -2,20 +2,142 @@
 
 
 #include "TCG_GameMode.h"
+#include "TCG_GameState.h"
+#include "TCG_IdleTickSubsystem.h"
+#include "TCG_MatchStats.h"
+#include "Deck.h"
+#include "EngineUtils.h"
+#include "TCG_PlayerState.h"
+#include "TCG_SpectatorComponent.h"
+#include "GameFramework/GameSession.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
 void ATCG_GameMode::BeginPlay()
 {
-
+	Super::BeginPlay();
 }
 
 void ATCG_GameMode::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATCG_GameMode::InitGameState()
+{
+	Super::InitGameState();
+
+	bLoadTestSession = FParse::Param(FCommandLine::Get(), TEXT("TCGLoadTest"));
+
+	if (ATCG_GameState* TCG_GameState = GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->SetLockstep(bLockstep);
+		TCG_GameState->SetLoadTestSession(bLoadTestSession);
+	}
+}
+
+void ATCG_GameMode::PreLogin(const FString& Options, const FString& Address, 
+	const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage)
+{
+	Super::PreLogin(Options, Address, UniqueId, ErrorMessage);
+
+	const bool bSpectator = UGameplayStatics::ParseOption(Options, TEXT("SpectatorOnly")) == TEXT("1");
+	if (ErrorMessage.IsEmpty() && !bSpectator && FindFreeSeat() == INDEX_NONE)
+	{
+		ErrorMessage = TEXT("Every seat in this match is taken");
+	}
+}
+
+int32 ATCG_GameMode::FindFreeSeat() const
+{
+	if (!GameState)
+	{
+		return INDEX_NONE;
+	}
 
+	// load test bots past the deck seats play without a deck
+	const int32 SeatNum = bLoadTestSession ? 
+		GameState->PlayerArray.Num() + 1 : FTCG_ZoneIndex::MaxPlayers;
+	for (int32 Seat = 0; Seat < SeatNum; Seat++)
+	{
+		const bool bTaken = GameState->PlayerArray.ContainsByPredicate(
+			[Seat](const APlayerState* Player)
+			{
+				const ATCG_PlayerState* TCG_Player = Cast<ATCG_PlayerState>(Player);
+				return TCG_Player && TCG_Player->GetPlayerIndex() == Seat;
+			});
+		if (!bTaken)
+		{
+			return Seat;
+		}
+	}
+	return INDEX_NONE;
 }
 
+void ATCG_GameMode::PostLogin(APlayerController* NewPlayer)
+{
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	Super::PostLogin(NewPlayer);
+
+	// viewers get the shared broadcast instead of a seat
+	if (NewPlayer->PlayerState && NewPlayer->PlayerState->IsOnlyASpectator())
+	{
+		if (!NewPlayer->FindComponentByClass<UTCG_SpectatorComponent>())
+		{
+			UTCG_SpectatorComponent* Spectator = 
+				NewObject<UTCG_SpectatorComponent>(NewPlayer);
+			Spectator->RegisterComponent();
+		}
+		return;
+	}
+
+	// lowest free seat, matching the decks' OwnerIndex. seats of players
+	// who left are handed out again
+	if (ATCG_PlayerState* PlayerState = NewPlayer->GetPlayerState<ATCG_PlayerState>())
+	{
+		const int32 Seat = FindFreeSeat();
+		if (Seat == INDEX_NONE)
+		{
+			// split screen guests and races with another login skip PreLogin's check
+			UE_LOG(LogTemp, Warning, TEXT("No free seat for %s"), *PlayerState->GetPlayerName());
+			if (GameSession)
+			{
+				GameSession->KickPlayer(NewPlayer, 
+					FText::FromString(TEXT("Every seat in this match is taken")));
+			}
+			return;
+		}
+		PlayerState->SetPlayerIndex(Seat);
+
+		if (bLockstep)
+		{
+			for (TActorIterator<ADeck> It(GetWorld()); It; ++It)
+			{
+				if (It->GetOwnerIndex() == PlayerState->GetPlayerIndex())
+				{
+					PlayerState->Client_SetDeckSeed(*It, It->GetShuffleSeed());
+				}
+			}
+		}
+	}
+}
+
+// player requests are checked by the player state or the lockstep command
+// before they get here, the server's own calls go through unchecked
 void ATCG_GameMode::RequestPhaseChange_Implementation(const EGamePhase TargetPhase)
 {
+	TCG_SCOPE_HOTSPOT(RequestPhaseChange);
+	UTCG_IdleTickSubsystem::Wake(this);
+
 	CurrentGamePhase = TargetPhase;
+
+	if (ATCG_GameState* TCG_GameState = GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->SetGamePhase(CurrentGamePhase);
+	}
 	
 	OnGamePhaseChanged.Broadcast(GetCurrentGamePhase());
 }
@@ -2,13 +2,560 @@
 
 
 #include "TCG_GameState.h"
+#include "TCG_MemoryTags.h"
+#include "CardBase.h"
+#include "Deck.h"
+#include "EngineUtils.h"
+#include "TCG_GameInstance.h"
+#include "TCG_IdleTickSubsystem.h"
+#include "TCG_MatchStats.h"
+#include "TCG_PlayerState.h"
+#include "TCG_SpectatorBroadcaster.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+static FAutoConsoleCommandWithWorld StateHashDumpCommand(
+	TEXT("tcg.StateHash.Dump"),
+	TEXT("Logs the match state hash, its recent mutations and zone contents"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (ATCG_GameState* GameState = World ? World->GetGameState<ATCG_GameState>() : nullptr)
+		{
+			GameState->DumpStateDiagnostics(TEXT("console"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld StatLayersVerifyAllCommand(
+	TEXT("tcg.StatLayers.VerifyAll"),
+	TEXT("Checks the layered stats of every card against a full recompute of all effects"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (ATCG_GameState* GameState = World ? World->GetGameState<ATCG_GameState>() : nullptr)
+		{
+			UE_LOG(LogTemp, Log, TEXT("Stat layers: %d mismatches"), 
+				GameState->GetStatLayers().VerifyAll());
+		}
+	}));
+
+void ATCG_GameState::PostInitializeComponents()
+{
+	LLM_SCOPE_BYTAG(TCG_Match);
+
+	Super::PostInitializeComponents();
+
+	// before any deck's begin play registers its cards
+	FTCG_MatchArena::FScope ArenaScope(MatchArena);
+	ZoneIndex.Init(MaxMatchCards);
+	StatLayers.Init(MaxMatchCards, &ZoneIndex);
+}
 
 void ATCG_GameState::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (UTCG_GameInstance* GameInstance = GetGameInstance<UTCG_GameInstance>())
+	{
+		GameInstance->MarkMatchStarted();
+	}
+	FTCG_MatchStats::BeginMatch(GetWorld());
+
+	if (HasAuthority() && bLoadTestSession)
+	{
+		GetWorldTimerManager().SetTimer(ServerTickTimeTimer, this, 
+			&ATCG_GameState::UpdateServerTickTime, 1.0f, true);
+		if (UTCG_IdleTickSubsystem* IdleTick = GetWorld()->GetSubsystem<UTCG_IdleTickSubsystem>())
+		{
+			IdleTick->WatchTimer(ServerTickTimeTimer);
+		}
+	}
+}
+
+void ATCG_GameState::UpdateServerTickTime()
+{
+	if (UTCG_IdleTickSubsystem* IdleTick = GetWorld()->GetSubsystem<UTCG_IdleTickSubsystem>())
+	{
+		ServerTickTime = static_cast<float>(IdleTick->GetTickWorkTime() * 1000.0);
+	}
 }
 
 void ATCG_GameState::EndPlay(EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
+
+	if (bLockstep)
+	{
+		// an estimate from the struct size, the packed commands on the wire are smaller
+		UE_LOG(LogTemp, Log, TEXT("Lockstep match applied %d commands, estimated %d bytes of unpacked payload"),
+			AppliedCommandNum, AppliedCommandNum * static_cast<int32>(sizeof(FTCG_Command)));
+	}
+
+	FTCG_MatchStats::EndMatch(GetWorld());
+
+	// drop every container pointing into the arena, then release it in one shot
+	StatLayers = FTCG_StatLayers();
+	ZoneIndex = FTCG_ZoneIndex();
+
+	UE_LOG(LogTemp, Log, TEXT("Match arena peak %lld bytes in %d blocks"),
+		MatchArena.GetStats().PeakUsedBytes, MatchArena.GetStats().BlockNum);
+	MatchArena.Reset();
+}
+
+void ATCG_GameState::GetLifetimeReplicatedProps(
+	TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ATCG_GameState, GamePhase);
+	DOREPLIFETIME(ATCG_GameState, PhaseSerial);
+	DOREPLIFETIME(ATCG_GameState, ActivePlayerIndex);
+	DOREPLIFETIME_CONDITION(ATCG_GameState, bLockstep, COND_InitialOnly);
+	DOREPLIFETIME(ATCG_GameState, ServerTickTime);
+}
+
+void ATCG_GameState::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// every peer advances the phase itself from the commands
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ATCG_GameState, GamePhase, !bLockstep);
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ATCG_GameState, PhaseSerial, !bLockstep);
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ATCG_GameState, ActivePlayerIndex, !bLockstep);
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ATCG_GameState, ServerTickTime, bLoadTestSession);
+}
+
+void ATCG_GameState::OnRep_GamePhase()
+{
+	TCG_SCOPE_HOTSPOT(OnRep_GamePhase);
+
+	HashGamePhase();
+	FTCG_MatchStats::EnterPhase(GetWorld(), GamePhase);
+
+	if (bHasPredictedPhase)
+	{
+		// already showing this phase, nothing to roll back. a wrong
+		// prediction is cleared when the server answers the request
+		if (GamePhase == PredictedGamePhase)
+		{
+			bHasPredictedPhase = false;
+		}
+		return;
+	}
+
+	OnGamePhaseChanged.Broadcast(GamePhase);
+}
+
+// the first turn begins after the mulligan, later ones wrap around from PostTurnEnd
+static bool StartsNewTurn(const EGamePhase From, const EGamePhase To)
+{
+	return (To == EGamePhase::PreTurnStart || To == EGamePhase::TurnStart) &&
+		(From < EGamePhase::PreTurnStart || From == EGamePhase::PostTurnEnd);
+}
+
+void ATCG_GameState::SetGamePhase(const EGamePhase NewPhase)
+{
+	if (StartsNewTurn(GamePhase, NewPhase))
+	{
+		ActivePlayerIndex = (ActivePlayerIndex + 1) % FTCG_ZoneIndex::MaxPlayers;
+	}
+	GamePhase = NewPhase;
+	HashGamePhase();
+	FTCG_MatchStats::EnterPhase(GetWorld(), GamePhase);
+
+	PhaseSerial++;
+	if (UTCG_SpectatorBroadcaster* Broadcaster = 
+		GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+	{
+		Broadcaster->QueuePhaseChanged(GamePhase);
+	}
+
+	FStateHashSnapshot& Snapshot = StateHashSnapshots.Num() < MaxStateHashSnapshots ?
+		StateHashSnapshots.AddDefaulted_GetRef() :
+		StateHashSnapshots[(PhaseSerial - 1) % MaxStateHashSnapshots];
+	Snapshot.Serial = PhaseSerial;
+	for (int32 Partition = 0; Partition < FTCG_StateHash::PartitionNum; Partition++)
+	{
+		for (int32 Key = 0; Key < FTCG_StateHash::KeyNum; Key++)
+		{
+			Snapshot.Partitions[Partition][Key] = StateHash.Get(Partition, 1u << Key);
+		}
+	}
+
+	// behind every card move already sent to the owner on the same channel
+	if (HasAuthority() && !bLockstep)
+	{
+		for (APlayerState* Player : PlayerArray)
+		{
+			ATCG_PlayerState* TCG_PlayerState = Cast<ATCG_PlayerState>(Player);
+			const APlayerController* Controller = TCG_PlayerState ? 
+				Cast<APlayerController>(TCG_PlayerState->GetOwner()) : nullptr;
+			if (Controller && !Controller->IsLocalController() && 
+				!TCG_PlayerState->IsOnlyASpectator())
+			{
+				TCG_PlayerState->Client_ReportStateHash(PhaseSerial);
+			}
+		}
+	}
+
+	OnGamePhaseChanged.Broadcast(GamePhase);
+}
+
+void ATCG_GameState::OnRep_PhaseSerial()
+{
+	TCG_SCOPE_HOTSPOT(OnRep_PhaseSerial);
+
+	// GamePhase comes in the same update, make sure it is hashed first.
+	// the check itself is asked for by the server, ordered with the card moves
+	HashGamePhase();
+}
+
+void ATCG_GameState::HashGamePhase()
+{
+	StateHash.Update(FTCG_StateHash::SharedPartition, ETCG_HashKey::GamePhase, 0,
+		static_cast<int32>(HashedGamePhase), static_cast<int32>(GamePhase));
+	HashedGamePhase = GamePhase;
+}
+
+FTCG_CardHandle ATCG_GameState::RegisterCard(const FTCG_CardEntry& Entry, 
+	const int32 OwnerIndex, const ECardZone Zone)
+{
+	const FTCG_CardHandle Handle = ZoneIndex.Register(Entry, OwnerIndex, Zone);
+	if (Handle.IsValid())
+	{
+		StateHash.Toggle(OwnerIndex, ETCG_HashKey::CardIdentity, Handle.Index, Entry.CardId);
+		StateHash.Toggle(OwnerIndex, ETCG_HashKey::CardZone, Handle.Index, 
+			static_cast<int32>(Zone));
+
+		if (UTCG_SpectatorBroadcaster* Broadcaster = 
+			GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+		{
+			Broadcaster->QueueCardMoved(OwnerIndex, Handle, Zone, Entry.CardId);
+		}
+	}
+	return Handle;
+}
+
+bool ATCG_GameState::FindStateHashSnapshot(const int32 Serial, const int32 PlayerIndex, 
+	uint64& OutHash) const
+{
+	const uint32 KeyMask = GetCheckedHashKeys();
+	for (const FStateHashSnapshot& Snapshot : StateHashSnapshots)
+	{
+		if (Snapshot.Serial == Serial && 
+			PlayerIndex >= 0 && PlayerIndex < FTCG_StateHash::SharedPartition)
+		{
+			OutHash = 0;
+			for (int32 Key = 0; Key < FTCG_StateHash::KeyNum; Key++)
+			{
+				if (KeyMask & (1u << Key))
+				{
+					OutHash ^= Snapshot.Partitions[FTCG_StateHash::SharedPartition][Key]
+						^ Snapshot.Partitions[PlayerIndex][Key];
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void ATCG_GameState::SetLockstep(const bool bInLockstep)
+{
+	bLockstep = bInLockstep;
+}
+
+void ATCG_GameState::SetLoadTestSession(const bool bInLoadTestSession)
+{
+	bLoadTestSession = bInLoadTestSession;
+}
+
+void ATCG_GameState::SubmitCommand(FTCG_Command Command)
+{
+	if (!IsCommandAllowed(Command))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Lockstep command %d (%d) from player %d rejected in phase %d"),
+			static_cast<int32>(Command.Type), Command.Value, Command.PlayerIndex, 
+			static_cast<int32>(GamePhase));
+		return;
+	}
+
+	Command.Serial = ++NextCommandSerial;
+	Multicast_ApplyCommand(Command);
+}
+
+bool ATCG_GameState::IsCommandAllowed(const FTCG_Command& Command) const
+{
+	// spectators and players not seated yet send nothing
+	if (Command.PlayerIndex < 0 || Command.PlayerIndex >= FTCG_ZoneIndex::MaxPlayers ||
+		GamePhase == EGamePhase::GameEnd)
+	{
+		return false;
+	}
+
+	const bool bActivePlayer = Command.PlayerIndex == ActivePlayerIndex;
+	const bool bInTurn = GamePhase >= EGamePhase::PreTurnStart && 
+		GamePhase <= EGamePhase::PostTurnEnd;
+
+	switch (Command.Type)
+	{
+	case ETCG_CommandType::Draw:
+		// own deck only, both players draw their opening hand
+		return Command.Value == Command.PlayerIndex && FindDeck(Command.Value) &&
+			(GamePhase == EGamePhase::Mulligan || (bActivePlayer && bInTurn));
+	case ETCG_CommandType::PhaseChange:
+	{
+		if (Command.Value < 0 || 
+			Command.Value >= StaticEnum<EGamePhase>()->NumEnums() - 1)
+		{
+			return false;
+		}
+
+		// anyone seated starts the match, then only the player whose turn it is
+		if (ActivePlayerIndex != INDEX_NONE && !bActivePlayer)
+		{
+			return false;
+		}
+		const EGamePhase TargetPhase = static_cast<EGamePhase>(Command.Value);
+		return TargetPhase > GamePhase || StartsNewTurn(GamePhase, TargetPhase);
+	}
+	case ETCG_CommandType::Damage:
+		return Command.Value > 0 && bActivePlayer && bInTurn;
+	default:
+		return false;
+	}
+}
+
+void ATCG_GameState::Multicast_ApplyCommand_Implementation(const FTCG_Command& Command)
+{
+	TCG_COUNT_RPC(Multicast_ApplyCommand);
+
+	// reliable multicasts keep their order, a gap means the simulation diverged
+	ensureMsgf(Command.Serial == AppliedCommandNum + 1, 
+		TEXT("Lockstep command %d applied after %d"), Command.Serial, AppliedCommandNum);
+	AppliedCommandNum = Command.Serial;
+
+	ApplyCommand(Command);
+}
+
+void ATCG_GameState::ApplyCommand(const FTCG_Command& Command)
+{
+	switch (Command.Type)
+	{
+	case ETCG_CommandType::Draw:
+		if (ADeck* Deck = FindDeck(Command.Value))
+		{
+			// only the server and the owner know the deck order
+			if (HasAuthority() || GetLocalPlayerIndex() == Command.Value)
+			{
+				Deck->Draw();
+			}
+			else
+			{
+				Deck->DrawHidden();
+			}
+		}
+		break;
+	case ETCG_CommandType::PhaseChange:
+	{
+		const EGamePhase TargetPhase = static_cast<EGamePhase>(Command.Value);
+		if (ATCG_GameMode* GameMode = GetWorld()->GetAuthGameMode<ATCG_GameMode>())
+		{
+			GameMode->RequestPhaseChange_Implementation(TargetPhase);
+		}
+		else
+		{
+			SetGamePhase(TargetPhase);
+
+			// hash check at the same point of the command stream as the server
+			if (ATCG_PlayerState* PlayerState = FindPlayerState(GetLocalPlayerIndex()))
+			{
+				PlayerState->ReportStateHash(PhaseSerial);
+			}
+		}
+		break;
+	}
+	case ETCG_CommandType::Damage:
+		if (ATCG_PlayerState* PlayerState = FindPlayerState(Command.PlayerIndex))
+		{
+			PlayerState->ApplyDamage(Command.Value);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void ATCG_GameState::RevealCard(ACardBase* Card)
+{
+	if (!HasAuthority() || !Card || !Card->CardHandle.IsValid())
+	{
+		return;
+	}
+
+	Multicast_RevealCard(ZoneIndex.GetOwner(Card->CardHandle), Card->GetCardData().CardId,
+		ECardZone::OpponentRevealed);
+}
+
+void ATCG_GameState::Multicast_RevealCard_Implementation(const int32 OwnerIndex, 
+	const int32 CardId, const ECardZone Zone)
+{
+	TCG_COUNT_RPC(Multicast_RevealCard);
+
+	if (HasAuthority() || GetLocalPlayerIndex() == OwnerIndex)
+	{
+		return;
+	}
+
+	if (ADeck* Deck = FindDeck(OwnerIndex))
+	{
+		Deck->RevealHiddenCard(CardId, Zone);
+	}
+}
+
+int32 ATCG_GameState::GetLocalPlayerIndex() const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const ATCG_PlayerState* PlayerState = PlayerController ? 
+		PlayerController->GetPlayerState<ATCG_PlayerState>() : nullptr;
+	return PlayerState ? PlayerState->GetPlayerIndex() : INDEX_NONE;
+}
+
+ADeck* ATCG_GameState::FindDeck(const int32 OwnerIndex) const
+{
+	for (TActorIterator<ADeck> It(GetWorld()); It; ++It)
+	{
+		if (It->GetOwnerIndex() == OwnerIndex)
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+ACardBase* ATCG_GameState::FindCard(const FTCG_CardHandle Handle) const
+{
+	if (!ZoneIndex.IsRegistered(Handle))
+	{
+		return nullptr;
+	}
+
+	const ADeck* Deck = FindDeck(ZoneIndex.GetOwner(Handle));
+	return Deck ? Deck->FindOwnedCard(Handle) : nullptr;
+}
+
+ATCG_PlayerState* ATCG_GameState::FindPlayerState(const int32 PlayerIndex) const
+{
+	for (APlayerState* Player : PlayerArray)
+	{
+		ATCG_PlayerState* TCG_PlayerState = Cast<ATCG_PlayerState>(Player);
+		if (TCG_PlayerState && TCG_PlayerState->GetPlayerIndex() == PlayerIndex)
+		{
+			return TCG_PlayerState;
+		}
+	}
+	return nullptr;
+}
+
+void ATCG_GameState::DumpStateDiagnostics(const FString& Context) const
+{
+	StateHash.Dump(FString::Printf(TEXT("%s, phase %d serial %d"), *Context, 
+		static_cast<int32>(GamePhase), PhaseSerial));
+
+	const UEnum* ZoneEnum = StaticEnum<ECardZone>();
+	for (int32 Owner = 0; Owner < FTCG_ZoneIndex::MaxPlayers; Owner++)
+	{
+		for (int32 Zone = 0; Zone < ZoneEnum->NumEnums() - 1; Zone++)
+		{
+			FTCG_CardBitset Cards = ZoneIndex.GetZoneBits(static_cast<ECardZone>(Zone));
+			Cards &= ZoneIndex.GetOwnerBits(Owner);
+			if (Cards.IsEmpty())
+			{
+				continue;
+			}
+
+			FString Handles;
+			Cards.ForEachSetBit([&Handles](const int32 Index)
+				{
+					Handles += FString::Printf(TEXT("%d "), Index);
+				});
+			UE_LOG(LogTemp, Warning, TEXT("  Player %d %s: %s"), Owner, 
+				*ZoneEnum->GetNameStringByIndex(Zone), *Handles);
+		}
+	}
+
+	for (APlayerState* Player : PlayerArray)
+	{
+		if (const ATCG_PlayerState* TCG_PlayerState = Cast<ATCG_PlayerState>(Player))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("  Player %d hitpoint %d"), 
+				TCG_PlayerState->GetPlayerIndex(), TCG_PlayerState->GetHitpoint());
+		}
+	}
+}
+
+// zones whose cards the opponent's peer doesn't know in lockstep
+static bool IsHiddenZone(const ECardZone Zone)
+{
+	return Zone == ECardZone::Library || Zone == ECardZone::DeckTop || 
+		Zone == ECardZone::Hand || Zone == ECardZone::OpponentHidden;
+}
+
+void ATCG_GameState::MoveCardZone(const FTCG_CardHandle Handle, const ECardZone Zone)
+{
+	if (!ZoneIndex.IsRegistered(Handle))
+	{
+		return;
+	}
+
+	// played or discarded, the opponent's peer learns which card it was
+	if (bLockstep && HasAuthority() && 
+		IsHiddenZone(ZoneIndex.GetZone(Handle)) && !IsHiddenZone(Zone))
+	{
+		Multicast_RevealCard(ZoneIndex.GetOwner(Handle), ZoneIndex.GetCardId(Handle), Zone);
+	}
+
+	StateHash.Update(ZoneIndex.GetOwner(Handle), ETCG_HashKey::CardZone, Handle.Index,
+		static_cast<int32>(ZoneIndex.GetZone(Handle)), static_cast<int32>(Zone));
+
+	if (UTCG_SpectatorBroadcaster* Broadcaster = 
+		GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+	{
+		Broadcaster->QueueCardMoved(ZoneIndex.GetOwner(Handle), Handle, Zone, 
+			ZoneIndex.GetCardId(Handle));
+	}
+
+	// no arena scope, only the index and stat layers set up at init live there
+	const ECardZone PreviousZone = ZoneIndex.GetZone(Handle);
+	ZoneIndex.MoveCard(Handle, Zone);
+	StatLayers.RefreshAuras();
+
+	OnCardZoneChanged.Broadcast(Handle, PreviousZone, Zone);
+}
+
+void ATCG_GameState::PredictGamePhase(const EGamePhase TargetPhase)
+{
+	if (TargetPhase == GetGamePhase())
+	{
+		return;
+	}
+
+	PredictedGamePhase = TargetPhase;
+	bHasPredictedPhase = true;
+	OnGamePhaseChanged.Broadcast(PredictedGamePhase);
+}
+
+void ATCG_GameState::ClearPredictedGamePhase()
+{
+	if (!bHasPredictedPhase)
+	{
+		return;
+	}
+
+	bHasPredictedPhase = false;
+	if (PredictedGamePhase != GamePhase)
+	{
+		// roll back to what the server has
+		OnGamePhaseChanged.Broadcast(GamePhase);
+	}
 }
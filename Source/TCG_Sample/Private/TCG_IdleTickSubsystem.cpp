@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_IdleTickSubsystem.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "TimerManager.h"
+
+static TAutoConsoleVariable<int32> CVarIdleTickEnabled(
+	TEXT("tcg.Idle.Enabled"),
+	1,
+	TEXT("Drop the dedicated server tick rate while the match has no pending work"));
+
+static TAutoConsoleVariable<int32> CVarIdleTickRate(
+	TEXT("tcg.Idle.TickRate"),
+	10,
+	TEXT("Server ticks per second while idle, bounds the delay of an RPC that arrives mid sleep"));
+
+static TAutoConsoleVariable<float> CVarIdleTickLinger(
+	TEXT("tcg.Idle.Linger"),
+	0.5f,
+	TEXT("Seconds the server stays at full rate after a wake, so replication of the result goes out"));
+
+static FAutoConsoleCommandWithWorld IdleReportCommand(
+	TEXT("tcg.Idle.Report"),
+	TEXT("Logs idle and active frame counts of the server tick"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UTCG_IdleTickSubsystem* IdleTick = World ?
+			World->GetSubsystem<UTCG_IdleTickSubsystem>() : nullptr)
+		{
+			IdleTick->Report();
+		}
+	}));
+
+bool UTCG_IdleTickSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && World && World->IsGameWorld();
+}
+
+void UTCG_IdleTickSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(
+		this, &UTCG_IdleTickSubsystem::OnWorldTickStart);
+}
+
+void UTCG_IdleTickSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	SetIdle(false);
+	if (IdleFrames > 0)
+	{
+		Report();
+	}
+
+	Super::Deinitialize();
+}
+
+void UTCG_IdleTickSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// net dispatch and actor ticks, tickables run after both
+	if (TickStartTime > 0.0)
+	{
+		TickWorkTime = FMath::Lerp(TickWorkTime, FPlatformTime::Seconds() - TickStartTime, 0.1);
+	}
+
+	// listen servers render, clients don't own the rate
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() != NM_DedicatedServer)
+	{
+		return;
+	}
+	if (CVarIdleTickEnabled.GetValueOnGameThread() == 0)
+	{
+		SetIdle(false);
+		return;
+	}
+
+	if (bIdle)
+	{
+		IdleFrames++;
+		IdleSeconds += DeltaTime;
+	}
+	else
+	{
+		ActiveFrames++;
+	}
+
+	const double Now = World->GetTimeSeconds();
+	while (Deadlines.Num() > 0 && Deadlines.HeapTop() <= Now)
+	{
+		double Due = 0.0;
+		Deadlines.HeapPop(Due, EAllowShrinking::No);
+		Resume();
+	}
+
+	// a deadline due before the next idle frame is served at the full rate
+	const double IdleInterval = 1.0 / FMath::Max(CVarIdleTickRate.GetValueOnGameThread(), 1);
+	const bool bDeadlineSoon = Deadlines.Num() > 0 && Deadlines.HeapTop() - Now < IdleInterval;
+
+	// timers ticked before the tickables, the remaining time is to the next firing
+	FTimerManager& TimerManager = World->GetTimerManager();
+	WatchedTimers.RemoveAll([&TimerManager](const FTimerHandle& Handle)
+		{
+			return !TimerManager.TimerExists(Handle);
+		});
+	bool bTimerSoon = false;
+	for (const FTimerHandle& Handle : WatchedTimers)
+	{
+		// paused timers have no deadline
+		if (TimerManager.IsTimerActive(Handle) && 
+			TimerManager.GetTimerRemaining(Handle) < IdleInterval)
+		{
+			bTimerSoon = true;
+			break;
+		}
+	}
+
+	SetIdle(Now >= AwakeUntil && !bDeadlineSoon && !bTimerSoon);
+}
+
+TStatId UTCG_IdleTickSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTCG_IdleTickSubsystem, STATGROUP_Tickables);
+}
+
+void UTCG_IdleTickSubsystem::Wake(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if (UTCG_IdleTickSubsystem* IdleTick = World ?
+		World->GetSubsystem<UTCG_IdleTickSubsystem>() : nullptr)
+	{
+		IdleTick->Resume();
+	}
+}
+
+void UTCG_IdleTickSubsystem::ScheduleWake(const double Time)
+{
+	Deadlines.HeapPush(Time);
+}
+
+void UTCG_IdleTickSubsystem::WatchTimer(const FTimerHandle& Handle)
+{
+	if (Handle.IsValid())
+	{
+		WatchedTimers.AddUnique(Handle);
+	}
+}
+
+void UTCG_IdleTickSubsystem::Report() const
+{
+	// resident memory, compares server and game builds at idle
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	UE_LOG(LogTemp, Log, TEXT("Idle tick: %s, %lld idle frames (%.1f s), %lld active frames, %d wakes, %d deadlines pending, %d timers watched, %.1f MB used"),
+		bIdle ? TEXT("idle") : TEXT("active"), IdleFrames, IdleSeconds, ActiveFrames,
+		WakeNum, Deadlines.Num(), WatchedTimers.Num(), MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+}
+
+void UTCG_IdleTickSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, 
+	float DeltaTime)
+{
+	if (World == GetWorld())
+	{
+		TickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UTCG_IdleTickSubsystem::Resume()
+{
+	AwakeUntil = GetWorld()->GetTimeSeconds() + CVarIdleTickLinger.GetValueOnGameThread();
+	if (bIdle)
+	{
+		WakeNum++;
+	}
+	SetIdle(false);
+}
+
+void UTCG_IdleTickSubsystem::SetIdle(const bool bNewIdle)
+{
+	UNetDriver* NetDriver = GetWorld() ? GetWorld()->GetNetDriver() : nullptr;
+	if (!NetDriver || bNewIdle == bIdle)
+	{
+		return;
+	}
+
+	// whatever the config asked for, read before the first drop
+	if (ActiveTickRate == 0)
+	{
+		ActiveTickRate = NetDriver->GetNetServerMaxTickRate();
+	}
+
+	const int32 IdleTickRate = FMath::Clamp(CVarIdleTickRate.GetValueOnGameThread(),
+		1, ActiveTickRate);
+	NetDriver->SetNetServerMaxTickRate(bNewIdle ? IdleTickRate : ActiveTickRate);
+	bIdle = bNewIdle;
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_LoadTestBot.h"
+#include "Deck.h"
+#include "TCG_GameState.h"
+#include "TCG_PlayerState.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+
+UTCG_LoadTestBot::UTCG_LoadTestBot()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UTCG_LoadTestBot::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Script.ParseIntoArray(ScriptSteps, TEXT(","));
+
+	// spread the bots over the interval instead of firing together
+	GetWorld()->GetTimerManager().SetTimer(ActionTimer, this,
+		&UTCG_LoadTestBot::PerformAction, ActionInterval, true,
+		FMath::FRandRange(0.0f, ActionInterval));
+}
+
+void UTCG_LoadTestBot::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->GetTimerManager().ClearTimer(ActionTimer);
+	if (ATCG_PlayerState* PlayerState = BoundPlayerState.Get())
+	{
+		PlayerState->OnActionReconciled.Remove(ReconciledHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTCG_LoadTestBot::TakeLatencySamples(TArray<double>& OutSamples)
+{
+	OutSamples.Append(LatencySamples);
+	LatencySamples.Reset();
+}
+
+ATCG_PlayerState* UTCG_LoadTestBot::BindPlayerState()
+{
+	const APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	ATCG_PlayerState* PlayerState = Controller ?
+		Controller->GetPlayerState<ATCG_PlayerState>() : nullptr;
+	if (PlayerState && PlayerState != BoundPlayerState.Get())
+	{
+		if (ATCG_PlayerState* OldPlayerState = BoundPlayerState.Get())
+		{
+			OldPlayerState->OnActionReconciled.Remove(ReconciledHandle);
+		}
+		ReconciledHandle = PlayerState->OnActionReconciled.AddUObject(
+			this, &UTCG_LoadTestBot::OnActionReconciled);
+		BoundPlayerState = PlayerState;
+	}
+	return PlayerState;
+}
+
+void UTCG_LoadTestBot::PerformAction()
+{
+	// the player state replicates in a while after the controller
+	ATCG_PlayerState* PlayerState = BindPlayerState();
+	const ATCG_GameState* GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	if (!PlayerState || !GameState)
+	{
+		return;
+	}
+
+	FString Step;
+	if (ScriptSteps.Num() > 0)
+	{
+		Step = ScriptSteps[ScriptIndex].TrimStartAndEnd();
+		ScriptIndex = (ScriptIndex + 1) % ScriptSteps.Num();
+	}
+	else
+	{
+		static const TCHAR* RandomSteps[] = { TEXT("draw"), TEXT("damage"), TEXT("phase") };
+		Step = RandomSteps[FMath::RandHelper(UE_ARRAY_COUNT(RandomSteps))];
+	}
+
+	// load test seats past the decks have nothing to draw, they deal damage
+	ADeck* Deck = GameState->FindDeck(PlayerState->GetPlayerIndex());
+	if (Step == TEXT("draw") && Deck)
+	{
+		PlayerState->RequestDraw(Deck);
+	}
+	else if (Step == TEXT("damage") || Step == TEXT("draw"))
+	{
+		PlayerState->RequestDamage(1);
+	}
+	else if (Step == TEXT("phase"))
+	{
+		// cycle through the turn, the match never ends on its own
+		const int32 Next = static_cast<int32>(GameState->GetGamePhase()) + 1;
+		const EGamePhase TargetPhase = Next >= static_cast<int32>(EGamePhase::GameEnd) ?
+			EGamePhase::TurnStart : static_cast<EGamePhase>(Next);
+		PlayerState->RequestPhaseChange(TargetPhase);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Load test bot skips unknown step %s"), *Step);
+		return;
+	}
+	ActionNum++;
+}
+
+void UTCG_LoadTestBot::OnActionReconciled(const FPredictedAction& Action)
+{
+	LatencySamples.Add((FPlatformTime::Seconds() - Action.RequestTime) * 1000.0);
+}
@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_LoadTestSubsystem.h"
+#include "TCG_GameState.h"
+#include "TCG_LoadTestBot.h"
+#include "Engine/GameInstance.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+static TAutoConsoleVariable<float> CVarLoadTestReportInterval(
+	TEXT("tcg.Bot.ReportInterval"),
+	5.0f,
+	TEXT("Seconds between load test reports"));
+
+static FAutoConsoleCommandWithWorldAndArgs BotSpawnCommand(
+	TEXT("tcg.Bot.Spawn"),
+	TEXT("Adds load test bots to this client, e.g. tcg.Bot.Spawn 8"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (UTCG_LoadTestSubsystem* LoadTest = GameInstance ?
+			GameInstance->GetSubsystem<UTCG_LoadTestSubsystem>() : nullptr)
+		{
+			LoadTest->AddBots(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld BotReportCommand(
+	TEXT("tcg.Bot.Report"),
+	TEXT("Logs load test latency percentiles, server tick time and bandwidth now"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (UTCG_LoadTestSubsystem* LoadTest = GameInstance ?
+			GameInstance->GetSubsystem<UTCG_LoadTestSubsystem>() : nullptr)
+		{
+			LoadTest->Report();
+		}
+	}));
+
+namespace
+{
+	double GetPercentile(const TArray<double>& Sorted, const double Percentile)
+	{
+		if (Sorted.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 Index = FMath::Clamp(
+			FMath::FloorToInt32(Percentile * (Sorted.Num() - 1)), 0, Sorted.Num() - 1);
+		return Sorted[Index];
+	}
+}
+
+void UTCG_LoadTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+	int32 BotNum = 0;
+	FParse::Value(CommandLine, TEXT("TCGBots="), BotNum);
+	FParse::Value(CommandLine, TEXT("TCGBotRamp="), RampInterval);
+	FParse::Value(CommandLine, TEXT("TCGBotInterval="), ActionInterval);
+	FParse::Value(CommandLine, TEXT("TCGBotScript="), Script);
+
+	if (BotNum > 0)
+	{
+		AddBots(BotNum);
+	}
+}
+
+void UTCG_LoadTestSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	Super::Deinitialize();
+}
+
+void UTCG_LoadTestSubsystem::AddBots(const int32 Num)
+{
+	if (Num <= 0 || IsRunningDedicatedServer())
+	{
+		return;
+	}
+
+	TargetBotNum += Num;
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &UTCG_LoadTestSubsystem::Tick), 0.25f);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Load test ramping to %d bots"), TargetBotNum);
+}
+
+bool UTCG_LoadTestSubsystem::Tick(float DeltaTime)
+{
+	// waits on the main menu until the client has joined a server
+	const UWorld* World = GetGameInstance()->GetWorld();
+	if (!World || World->GetNetMode() != NM_Client)
+	{
+		return true;
+	}
+
+	AttachBots();
+
+	const double Now = FPlatformTime::Seconds();
+	if (GetGameInstance()->GetNumLocalPlayers() < TargetBotNum &&
+		Now - LastSpawnTime >= RampInterval)
+	{
+		LastSpawnTime = Now;
+		SpawnGuest();
+	}
+
+	if (LastReportTime == 0.0)
+	{
+		LastReportTime = Now;
+	}
+	else if (Now - LastReportTime >= CVarLoadTestReportInterval.GetValueOnGameThread())
+	{
+		Report();
+	}
+	return true;
+}
+
+void UTCG_LoadTestSubsystem::AttachBots()
+{
+	for (ULocalPlayer* LocalPlayer : GetGameInstance()->GetLocalPlayers())
+	{
+		// guests get their controller once the server accepts the join
+		APlayerController* Controller = LocalPlayer ? LocalPlayer->PlayerController : nullptr;
+		if (Controller && !Controller->FindComponentByClass<UTCG_LoadTestBot>())
+		{
+			UTCG_LoadTestBot* Bot = NewObject<UTCG_LoadTestBot>(Controller);
+			Bot->ActionInterval = ActionInterval;
+			Bot->Script = Script;
+			Bot->RegisterComponent();
+		}
+	}
+}
+
+void UTCG_LoadTestSubsystem::SpawnGuest()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	if (UGameViewportClient* Viewport = GameInstance->GetGameViewportClient())
+	{
+		Viewport->MaxSplitscreenPlayers = FMath::Max(Viewport->MaxSplitscreenPlayers,
+			TargetBotNum);
+	}
+
+	// a client world sends the split join, the server spawns its controller
+	FString Error;
+	if (!GameInstance->CreateLocalPlayer(-1, Error, true))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Load test bot not added: %s"), *Error);
+		TargetBotNum = GameInstance->GetNumLocalPlayers();
+	}
+}
+
+void UTCG_LoadTestSubsystem::Report()
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	const UWorld* World = GameInstance->GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	TArray<double> Samples;
+	int32 BotNum = 0;
+	int32 ActionNum = 0;
+	for (ULocalPlayer* LocalPlayer : GameInstance->GetLocalPlayers())
+	{
+		APlayerController* Controller = LocalPlayer ? LocalPlayer->PlayerController : nullptr;
+		if (UTCG_LoadTestBot* Bot = Controller ?
+			Controller->FindComponentByClass<UTCG_LoadTestBot>() : nullptr)
+		{
+			Bot->TakeLatencySamples(Samples);
+			ActionNum += Bot->GetActionNum();
+			BotNum++;
+		}
+	}
+	Samples.Sort();
+
+	const double Now = FPlatformTime::Seconds();
+	const double Elapsed = FMath::Max(Now - LastReportTime, UE_SMALL_NUMBER);
+	const double ActionRate = (ActionNum - ActionNumAtReport) / Elapsed;
+	LastReportTime = Now;
+	ActionNumAtReport = ActionNum;
+
+	const ATCG_GameState* GameState = World->GetGameState<ATCG_GameState>();
+	const UNetDriver* NetDriver = World->GetNetDriver();
+	const UNetConnection* Connection = NetDriver ? NetDriver->ServerConnection : nullptr;
+
+	// one process, one connection, however many bots share it
+	UE_LOG(LogTemp, Log, TEXT("Load test process %u: %d bots on 1 connection, %.1f actions/s, rtt p50 %.1f p90 %.1f p99 %.1f max %.1f ms (%d samples), server tick %.2f ms, in %.1f KB/s, out %.1f KB/s"),
+		FPlatformProcess::GetCurrentProcessId(), BotNum, ActionRate, GetPercentile(Samples, 0.5), GetPercentile(Samples, 0.9),
+		GetPercentile(Samples, 0.99), Samples.Num() > 0 ? Samples.Last() : 0.0, Samples.Num(),
+		GameState ? GameState->GetServerTickTime() : 0.0f,
+		Connection ? Connection->InBytesPerSecond / 1024.0 : 0.0,
+		Connection ? Connection->OutBytesPerSecond / 1024.0 : 0.0);
+}
@@ -0,0 +1,299 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_ManaSolver.h"
+
+void FTCG_ManaSolver::SetSources(const TArray<FTCG_ManaSource>& Sources)
+{
+	Groups.Reset();
+	GroupCounts = 0;
+	LeftoverMemo.Reset();
+	PayableCache.Reset();
+
+	for (const FTCG_ManaSource& Source : Sources)
+	{
+		if (Source.ColorMask == 0)
+		{
+			continue;
+		}
+
+		int32 GroupIndex = Groups.IndexOfByPredicate([&Source](const FSourceGroup& Group)
+			{
+				return Group.ColorMask == Source.ColorMask;
+			});
+		if (GroupIndex == INDEX_NONE)
+		{
+			if (Groups.Num() == MaxSourceGroups)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Too many kinds of mana sources, ignoring mask %d"),
+					Source.ColorMask);
+				continue;
+			}
+			GroupIndex = Groups.AddDefaulted();
+			Groups[GroupIndex].ColorMask = Source.ColorMask;
+		}
+
+		// a group never holds more than a packed count can hold
+		if (Groups[GroupIndex].SourceIds.Num() < 255)
+		{
+			Groups[GroupIndex].SourceIds.Add(Source.SourceId);
+		}
+	}
+
+	for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); GroupIndex++)
+	{
+		GroupCounts = SetCount(GroupCounts, GroupIndex, Groups[GroupIndex].SourceIds.Num());
+	}
+}
+
+bool FTCG_ManaSolver::CanPay(const FManaCost& Cost)
+{
+	bool bOverflow = false;
+	const FPackedCounts Requirement = PackCost(Cost, bOverflow);
+	if (bOverflow)
+	{
+		return false;
+	}
+
+	if (const bool* Cached = PayableCache.Find(Requirement))
+	{
+		return *Cached;
+	}
+	const bool bPayable = CanPayFrom(GroupCounts, Requirement);
+	PayableCache.Add(Requirement, bPayable);
+	return bPayable;
+}
+
+bool FTCG_ManaSolver::CanPayAny(const TArray<FManaCost>& Options)
+{
+	// no cost at all is free
+	if (Options.Num() == 0)
+	{
+		return true;
+	}
+
+	for (const FManaCost& Option : Options)
+	{
+		if (CanPay(Option))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+FTCG_ManaPayment FTCG_ManaSolver::Solve(const TArray<FManaCost>& Options, 
+	const TArray<const TArray<FManaCost>*>& FutureCosts)
+{
+	FTCG_ManaPayment Best;
+	if (Options.Num() == 0)
+	{
+		Best.bPayable = true;
+		return Best;
+	}
+
+	// packed future costs, once
+	TArray<TArray<FPackedCounts>> FutureRequirements;
+	for (const TArray<FManaCost>* Future : FutureCosts)
+	{
+		TArray<FPackedCounts>& Requirements = FutureRequirements.AddDefaulted_GetRef();
+		for (const FManaCost& Option : *Future)
+		{
+			bool bOverflow = false;
+			const FPackedCounts Requirement = PackCost(Option, bOverflow);
+			if (!bOverflow)
+			{
+				Requirements.Add(Requirement);
+			}
+		}
+	}
+
+	FPackedCounts BestLeftover = 0;
+	int32 BestFlexibility = -1;
+
+	for (int32 OptionIndex = 0; OptionIndex < Options.Num(); OptionIndex++)
+	{
+		bool bOverflow = false;
+		const FPackedCounts Requirement = PackCost(Options[OptionIndex], bOverflow);
+		if (bOverflow)
+		{
+			continue;
+		}
+
+		for (const FPackedCounts Leftover : GetLeftovers(0, Requirement))
+		{
+			int32 FuturePlays = 0;
+			for (const TArray<FPackedCounts>& Requirements : FutureRequirements)
+			{
+				for (const FPackedCounts Future : Requirements)
+				{
+					if (CanPayFrom(Leftover, Future))
+					{
+						FuturePlays++;
+						break;
+					}
+				}
+			}
+
+			// tie break: keep the sources that can make the most colors
+			int32 Flexibility = 0;
+			for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); GroupIndex++)
+			{
+				Flexibility += GetCount(Leftover, GroupIndex) 
+					* FMath::CountBits(Groups[GroupIndex].ColorMask);
+			}
+
+			if (!Best.bPayable || FuturePlays > Best.FuturePlays 
+				|| (FuturePlays == Best.FuturePlays && Flexibility > BestFlexibility))
+			{
+				Best.bPayable = true;
+				Best.OptionIndex = OptionIndex;
+				Best.FuturePlays = FuturePlays;
+				BestFlexibility = Flexibility;
+				BestLeftover = Leftover;
+			}
+		}
+	}
+
+	if (Best.bPayable)
+	{
+		for (int32 GroupIndex = 0; GroupIndex < Groups.Num(); GroupIndex++)
+		{
+			const int32 Tapped = GetCount(GroupCounts, GroupIndex) 
+				- GetCount(BestLeftover, GroupIndex);
+			for (int32 Index = 0; Index < Tapped; Index++)
+			{
+				Best.TappedSources.Add(Groups[GroupIndex].SourceIds[Index]);
+			}
+		}
+	}
+	return Best;
+}
+
+FTCG_ManaSolver::FPackedCounts FTCG_ManaSolver::PackCost(const FManaCost& Cost, 
+	bool& bOutOverflow)
+{
+	FPackedCounts Packed = 0;
+	bOutOverflow = false;
+	for (const TPair<EManaType, int32>& Pair : Cost.Cost)
+	{
+		const int32 Slot = static_cast<int32>(Pair.Key);
+		if (Pair.Value <= 0)
+		{
+			continue;
+		}
+		if (Slot >= MaxManaTypes || Pair.Value > 255)
+		{
+			bOutOverflow = true;
+			return 0;
+		}
+		Packed = SetCount(Packed, Slot, Pair.Value);
+	}
+	return Packed;
+}
+
+int32 FTCG_ManaSolver::GetCount(const FPackedCounts Packed, const int32 Slot)
+{
+	return static_cast<int32>((Packed >> (Slot * 8)) & 0xFF);
+}
+
+FTCG_ManaSolver::FPackedCounts FTCG_ManaSolver::SetCount(const FPackedCounts Packed, 
+	const int32 Slot, const int32 Count)
+{
+	const int32 Shift = Slot * 8;
+	return (Packed & ~(0xFFull << Shift)) | (static_cast<uint64>(Count & 0xFF) << Shift);
+}
+
+TArray<FTCG_ManaSolver::FPackedCounts> FTCG_ManaSolver::GetLeftovers(
+	const int32 GroupIndex, const FPackedCounts Requirement)
+{
+	if (GroupIndex == Groups.Num())
+	{
+		return Requirement == 0 ? TArray<FPackedCounts>({ 0 }) : TArray<FPackedCounts>();
+	}
+
+	const TPair<int32, FPackedCounts> Key(GroupIndex, Requirement);
+	if (const TArray<FPackedCounts>* Found = LeftoverMemo.Find(Key))
+	{
+		return *Found;
+	}
+
+	TArray<FPackedCounts> Leftovers;
+	DistributeGroup(GroupIndex, 0, GetCount(GroupCounts, GroupIndex), Requirement, Leftovers);
+
+	LeftoverMemo.Add(Key, Leftovers);
+	return Leftovers;
+}
+
+void FTCG_ManaSolver::DistributeGroup(const int32 GroupIndex, const int32 ColorSlot, 
+	const int32 Left, const FPackedCounts Requirement, TArray<FPackedCounts>& OutLeftovers)
+{
+	if (ColorSlot == MaxManaTypes)
+	{
+		for (const FPackedCounts Rest : GetLeftovers(GroupIndex + 1, Requirement))
+		{
+			OutLeftovers.AddUnique(SetCount(Rest, GroupIndex, Left));
+		}
+		return;
+	}
+
+	const int32 Needed = GetCount(Requirement, ColorSlot);
+	if (Needed == 0 || (Groups[GroupIndex].ColorMask & (1u << ColorSlot)) == 0)
+	{
+		DistributeGroup(GroupIndex, ColorSlot + 1, Left, Requirement, OutLeftovers);
+		return;
+	}
+
+	for (int32 Used = 0; Used <= FMath::Min(Left, Needed); Used++)
+	{
+		DistributeGroup(GroupIndex, ColorSlot + 1, Left - Used, 
+			SetCount(Requirement, ColorSlot, Needed - Used), OutLeftovers);
+	}
+}
+
+bool FTCG_ManaSolver::CanPayFrom(const FPackedCounts Counts, 
+	const FPackedCounts Requirement) const
+{
+	if (Requirement == 0)
+	{
+		return true;
+	}
+	if (Groups.Num() == 0)
+	{
+		return false;
+	}
+	return PayRecursive(Counts, 0, 0, GetCount(Counts, 0), Requirement);
+}
+
+bool FTCG_ManaSolver::PayRecursive(const FPackedCounts Counts, const int32 GroupIndex, 
+	const int32 ColorSlot, const int32 Left, const FPackedCounts Requirement) const
+{
+	if (Requirement == 0)
+	{
+		return true;
+	}
+
+	if (ColorSlot == MaxManaTypes)
+	{
+		const int32 NextGroup = GroupIndex + 1;
+		return NextGroup < Groups.Num() 
+			&& PayRecursive(Counts, NextGroup, 0, GetCount(Counts, NextGroup), Requirement);
+	}
+
+	const int32 Needed = GetCount(Requirement, ColorSlot);
+	if (Needed == 0 || (Groups[GroupIndex].ColorMask & (1u << ColorSlot)) == 0)
+	{
+		return PayRecursive(Counts, GroupIndex, ColorSlot + 1, Left, Requirement);
+	}
+
+	// spending as much as possible first finds single color payments right away
+	for (int32 Used = FMath::Min(Left, Needed); Used >= 0; Used--)
+	{
+		if (PayRecursive(Counts, GroupIndex, ColorSlot + 1, Left - Used, 
+			SetCount(Requirement, ColorSlot, Needed - Used)))
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_MatchArena.h"
+#include "TCG_MemoryTags.h"
+#include "Misc/ScopeLock.h"
+
+#if TCG_ARENA_DEBUG
+static constexpr uint32 ArenaCanary = 0xA7E4A7E4;
+static constexpr uint8 ArenaFreshFill = 0xCD;
+static constexpr uint8 ArenaResetFill = 0xDD;
+static constexpr int32 CanarySize = sizeof(uint32);
+#else
+static constexpr int32 CanarySize = 0;
+#endif
+
+static thread_local FTCG_MatchArena* CurrentArena = nullptr;
+
+// blocks shared by every match of the process
+static FCriticalSection BlockCacheLock;
+static TArray<uint8*> BlockCache;
+
+FTCG_MatchArena::~FTCG_MatchArena()
+{
+	Reset();
+}
+
+void* FTCG_MatchArena::Allocate(const SIZE_T Size, const uint32 Alignment)
+{
+	uint8* Result = AllocateFromBlocks(Size, Alignment);
+
+	Stats.Allocations++;
+	Stats.UsedBytes += Size;
+	Stats.PeakUsedBytes = FMath::Max(Stats.PeakUsedBytes, Stats.UsedBytes);
+	return Result;
+}
+
+void* FTCG_MatchArena::Reallocate(void* Ptr, const SIZE_T OldSize, const SIZE_T NewSize, 
+	const uint32 Alignment)
+{
+	uint8* Old = static_cast<uint8*>(Ptr);
+	if (Old && NewSize <= OldSize)
+	{
+		return Old;
+	}
+	if (Old && Old == LastAllocation && Old + NewSize + CanarySize <= End)
+	{
+		Cursor = Old + NewSize;
+#if TCG_ARENA_DEBUG
+		FMemory::Memset(Old + OldSize, ArenaFreshFill, NewSize - OldSize);
+		WriteCanary(Cursor);
+		Canaries.Last() = Cursor;
+#endif
+		Cursor += CanarySize;
+
+		Stats.InPlaceGrows++;
+		Stats.UsedBytes += NewSize - OldSize;
+		Stats.PeakUsedBytes = FMath::Max(Stats.PeakUsedBytes, Stats.UsedBytes);
+		return Old;
+	}
+
+	void* Result = Allocate(NewSize, Alignment);
+	if (Old && OldSize > 0)
+	{
+		FMemory::Memcpy(Result, Old, FMath::Min(OldSize, NewSize));
+	}
+	return Result;
+}
+
+void FTCG_MatchArena::Reset()
+{
+#if TCG_ARENA_DEBUG
+	ensureMsgf(Validate(), TEXT("Match arena overflow detected at reset"));
+	Canaries.Reset();
+#endif
+
+	for (const FBlock& Block : Blocks)
+	{
+#if TCG_ARENA_DEBUG
+		FMemory::Memset(Block.Data, ArenaResetFill, Block.Size);
+#endif
+		if (Block.Size == BlockSize)
+		{
+			ReleaseBlock(Block.Data);
+		}
+		else
+		{
+			FMemory::Free(Block.Data);
+		}
+	}
+	Blocks.Reset();
+
+	Cursor = nullptr;
+	End = nullptr;
+	LastAllocation = nullptr;
+	Generation++;
+
+	const int64 PeakUsedBytes = Stats.PeakUsedBytes;
+	Stats = FTCG_MatchArenaStats();
+	Stats.PeakUsedBytes = PeakUsedBytes;
+}
+
+bool FTCG_MatchArena::Validate() const
+{
+#if TCG_ARENA_DEBUG
+	for (const uint8* Canary : Canaries)
+	{
+		uint32 Value;
+		FMemory::Memcpy(&Value, Canary, sizeof(Value));
+		if (Value != ArenaCanary)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Match arena canary overwritten at %p"), Canary);
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+
+FTCG_MatchArena* FTCG_MatchArena::GetCurrent()
+{
+	return CurrentArena;
+}
+
+FTCG_MatchArena::FScope::FScope(FTCG_MatchArena& Arena)
+	: Previous(CurrentArena)
+{
+	CurrentArena = &Arena;
+}
+
+FTCG_MatchArena::FScope::~FScope()
+{
+	CurrentArena = Previous;
+}
+
+uint8* FTCG_MatchArena::AllocateFromBlocks(const SIZE_T Size, const uint32 Alignment)
+{
+	uint8* Result = Cursor ? Align(Cursor, Alignment) : nullptr;
+	if (!Result || Result + Size + CanarySize > End)
+	{
+		AddBlock(Size + Alignment + CanarySize);
+		Result = Align(Cursor, Alignment);
+	}
+
+	Cursor = Result + Size;
+#if TCG_ARENA_DEBUG
+	FMemory::Memset(Result, ArenaFreshFill, Size);
+	WriteCanary(Cursor);
+	Canaries.Add(Cursor);
+#endif
+	Cursor += CanarySize;
+	LastAllocation = Result;
+	return Result;
+}
+
+void FTCG_MatchArena::AddBlock(const SIZE_T MinSize)
+{
+	LLM_SCOPE_BYTAG(TCG_Match);
+
+	FBlock& Block = Blocks.AddDefaulted_GetRef();
+	if (MinSize <= BlockSize)
+	{
+		Block.Data = AcquireBlock();
+		Block.Size = BlockSize;
+	}
+	else
+	{
+		// oversized, goes straight back to the heap on reset
+		Block.Data = static_cast<uint8*>(FMemory::Malloc(MinSize));
+		Block.Size = static_cast<int32>(MinSize);
+	}
+
+	Cursor = Block.Data;
+	End = Block.Data + Block.Size;
+	LastAllocation = nullptr;
+
+	Stats.BlockNum++;
+	Stats.ReservedBytes += Block.Size;
+}
+
+uint8* FTCG_MatchArena::AcquireBlock()
+{
+	{
+		FScopeLock Lock(&BlockCacheLock);
+		if (BlockCache.Num() > 0)
+		{
+			return BlockCache.Pop(false);
+		}
+	}
+	return static_cast<uint8*>(FMemory::Malloc(BlockSize));
+}
+
+void FTCG_MatchArena::ReleaseBlock(uint8* Data)
+{
+	{
+		FScopeLock Lock(&BlockCacheLock);
+		if (BlockCache.Num() < MaxCachedBlocks)
+		{
+			BlockCache.Add(Data);
+			return;
+		}
+	}
+	FMemory::Free(Data);
+}
+
+#if TCG_ARENA_DEBUG
+void FTCG_MatchArena::WriteCanary(uint8* At)
+{
+	FMemory::Memcpy(At, &ArenaCanary, sizeof(ArenaCanary));
+}
+#endif
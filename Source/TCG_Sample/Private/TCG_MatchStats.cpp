@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_MatchStats.h"
+#include "TCG_NetPacking.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_STAT(STAT_TCG_RequestPhaseChange);
+DEFINE_STAT(STAT_TCG_Draw);
+DEFINE_STAT(STAT_TCG_Shuffle);
+DEFINE_STAT(STAT_TCG_ReturnCard);
+DEFINE_STAT(STAT_TCG_Req_Damage);
+DEFINE_STAT(STAT_TCG_OnRep_Hitpoint);
+DEFINE_STAT(STAT_TCG_OnRep_PlayerIndex);
+DEFINE_STAT(STAT_TCG_OnRep_GamePhase);
+DEFINE_STAT(STAT_TCG_OnRep_PhaseSerial);
+DEFINE_STAT(STAT_TCG_OnVoidDrawCount);
+DEFINE_STAT(STAT_TCG_OnRep_ShuffleSeed);
+
+CSV_DEFINE_CATEGORY_MODULE(TCG_SAMPLE_API, TCG, true);
+
+static TAutoConsoleVariable<int32> CVarMatchStatsExportOnEnd(
+	TEXT("tcg.Stats.ExportOnMatchEnd"),
+	0,
+	TEXT("Write the match stats csv to Saved/Profiling when a match ends"));
+
+static FAutoConsoleCommandWithWorldAndArgs MatchStatsDumpCommand(
+	TEXT("tcg.Stats.Dump"),
+	TEXT("Logs the top hot spots, RPCs, phase times and net bytes of the running match, e.g. tcg.Stats.Dump 5"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+	{
+		FTCG_MatchStats::Dump(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs MatchStatsCsvCommand(
+	TEXT("tcg.Stats.Csv"),
+	TEXT("Writes the running match's stats as csv, optionally to the given path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+		[](const TArray<FString>& Args, UWorld* World)
+	{
+		FTCG_MatchStats::ExportCsv(World, Args.Num() > 0 ? Args[0] : FString());
+	}));
+
+namespace
+{
+	struct FHotspotStats
+	{
+		int64 Count = 0;
+		uint64 TotalCycles = 0;
+		uint64 MaxCycles = 0;
+	};
+
+	struct FNetBytes
+	{
+		uint64 In = 0;
+		uint64 Out = 0;
+	};
+
+	// game thread only, like everything the hot spots wrap
+	TMap<FName, FHotspotStats> HotspotStats;
+	TMap<FName, int64> RpcCounts;
+	TMap<EGamePhase, double> PhaseSeconds;
+	EGamePhase CurrentPhase = EGamePhase::Start;
+	double PhaseStartTime = 0.0;
+	double MatchStartTime = 0.0;
+	FNetBytes NetBytesAtStart;
+	TWeakObjectPtr<const UWorld> MatchWorld;
+
+	bool HasAuthority(const UWorld* World)
+	{
+		return World && World->GetNetMode() != NM_Client;
+	}
+
+	FNetBytes GetNetBytes(const UWorld* World)
+	{
+		FNetBytes Bytes;
+		if (const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr)
+		{
+			Bytes.In = NetDriver->InTotalBytes;
+			Bytes.Out = NetDriver->OutTotalBytes;
+		}
+		return Bytes;
+	}
+
+	// the running phase counts up to now
+	TArray<TPair<EGamePhase, double>> GetPhaseTimes()
+	{
+		TMap<EGamePhase, double> Times = PhaseSeconds;
+		Times.FindOrAdd(CurrentPhase) += FPlatformTime::Seconds() - PhaseStartTime;
+
+		TArray<TPair<EGamePhase, double>> Sorted = Times.Array();
+		Sorted.Sort([](const TPair<EGamePhase, double>& A, const TPair<EGamePhase, double>& B)
+			{
+				return A.Value > B.Value;
+			});
+		return Sorted;
+	}
+
+	FString GetPhaseName(const EGamePhase Phase)
+	{
+		return StaticEnum<EGamePhase>()->GetNameStringByValue(static_cast<int64>(Phase));
+	}
+}
+
+FTCG_MatchStats::FHotspotScope::FHotspotScope(const FName InName)
+	: Name(InName)
+	, StartCycles(FPlatformTime::Cycles64())
+{
+}
+
+FTCG_MatchStats::FHotspotScope::~FHotspotScope()
+{
+	const uint64 Cycles = FPlatformTime::Cycles64() - StartCycles;
+	FHotspotStats& Stats = HotspotStats.FindOrAdd(Name);
+	Stats.Count++;
+	Stats.TotalCycles += Cycles;
+	Stats.MaxCycles = FMath::Max(Stats.MaxCycles, Cycles);
+}
+
+void FTCG_MatchStats::BeginMatch(const UWorld* World)
+{
+	const UWorld* Owner = MatchWorld.Get();
+	if (Owner && Owner != World && HasAuthority(Owner) && !HasAuthority(World))
+	{
+		return;
+	}
+	MatchWorld = World;
+
+	HotspotStats.Reset();
+	RpcCounts.Reset();
+	PhaseSeconds.Reset();
+	CurrentPhase = EGamePhase::Start;
+	MatchStartTime = FPlatformTime::Seconds();
+	PhaseStartTime = MatchStartTime;
+	NetBytesAtStart = GetNetBytes(World);
+	FTCG_NetPacking::ResetStats();
+}
+
+void FTCG_MatchStats::EndMatch(const UWorld* World)
+{
+	if (World != MatchWorld.Get())
+	{
+		return;
+	}
+	MatchWorld.Reset();
+
+	if (CVarMatchStatsExportOnEnd.GetValueOnGameThread() != 0)
+	{
+		ExportCsv(World);
+	}
+}
+
+void FTCG_MatchStats::CountRpc(const FName Name)
+{
+	RpcCounts.FindOrAdd(Name)++;
+}
+
+void FTCG_MatchStats::EnterPhase(const UWorld* World, const EGamePhase Phase)
+{
+	if (World != MatchWorld.Get())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	PhaseSeconds.FindOrAdd(CurrentPhase) += Now - PhaseStartTime;
+	CurrentPhase = Phase;
+	PhaseStartTime = Now;
+}
+
+void FTCG_MatchStats::Dump(const UWorld* World, const int32 TopNum)
+{
+	UE_LOG(LogTemp, Log, TEXT("Match stats after %.1f s"), FPlatformTime::Seconds() - MatchStartTime);
+
+	TArray<TPair<FName, FHotspotStats>> Hotspots = HotspotStats.Array();
+	Hotspots.Sort([](const TPair<FName, FHotspotStats>& A, const TPair<FName, FHotspotStats>& B)
+		{
+			return A.Value.TotalCycles > B.Value.TotalCycles;
+		});
+	for (int32 Index = 0; Index < FMath::Min(TopNum, Hotspots.Num()); Index++)
+	{
+		const FHotspotStats& Stats = Hotspots[Index].Value;
+		UE_LOG(LogTemp, Log, TEXT("  %s: %lld calls, %.3f ms total, %.2f us avg, %.2f us max"),
+			*Hotspots[Index].Key.ToString(), Stats.Count,
+			FPlatformTime::ToMilliseconds64(Stats.TotalCycles),
+			FPlatformTime::ToMilliseconds64(Stats.TotalCycles) * 1000.0 / FMath::Max<int64>(Stats.Count, 1),
+			FPlatformTime::ToMilliseconds64(Stats.MaxCycles) * 1000.0);
+	}
+
+	TArray<TPair<FName, int64>> Rpcs = RpcCounts.Array();
+	Rpcs.Sort([](const TPair<FName, int64>& A, const TPair<FName, int64>& B)
+		{
+			return A.Value > B.Value;
+		});
+	for (int32 Index = 0; Index < FMath::Min(TopNum, Rpcs.Num()); Index++)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s: %lld received"), *Rpcs[Index].Key.ToString(),
+			Rpcs[Index].Value);
+	}
+
+	for (const TPair<EGamePhase, double>& Phase : GetPhaseTimes())
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s: %.2f s"), *GetPhaseName(Phase.Key), Phase.Value);
+	}
+
+	const FNetBytes NetBytes = GetNetBytes(World);
+	UE_LOG(LogTemp, Log, TEXT("  Net: %llu bytes in, %llu bytes out"),
+		NetBytes.In - NetBytesAtStart.In, NetBytes.Out - NetBytesAtStart.Out);
+	FTCG_NetPacking::Report();
+}
+
+FString FTCG_MatchStats::ExportCsv(const UWorld* World, const FString& Path)
+{
+	FString Csv = TEXT("Kind,Name,Count,TotalMs,AvgUs,MaxUs,Bytes\n");
+
+	for (const TPair<FName, FHotspotStats>& Pair : HotspotStats)
+	{
+		const FHotspotStats& Stats = Pair.Value;
+		const double TotalMs = FPlatformTime::ToMilliseconds64(Stats.TotalCycles);
+		Csv += FString::Printf(TEXT("Hotspot,%s,%lld,%.4f,%.3f,%.3f,\n"), *Pair.Key.ToString(),
+			Stats.Count, TotalMs, TotalMs * 1000.0 / FMath::Max<int64>(Stats.Count, 1),
+			FPlatformTime::ToMilliseconds64(Stats.MaxCycles) * 1000.0);
+	}
+	for (const TPair<FName, int64>& Pair : RpcCounts)
+	{
+		Csv += FString::Printf(TEXT("Rpc,%s,%lld,,,,\n"), *Pair.Key.ToString(), Pair.Value);
+	}
+	for (const TPair<EGamePhase, double>& Phase : GetPhaseTimes())
+	{
+		Csv += FString::Printf(TEXT("Phase,%s,,%.1f,,,\n"), *GetPhaseName(Phase.Key),
+			Phase.Value * 1000.0);
+	}
+
+	const FNetBytes NetBytes = GetNetBytes(World);
+	Csv += FString::Printf(TEXT("Net,In,,,,,%llu\n"), NetBytes.In - NetBytesAtStart.In);
+	Csv += FString::Printf(TEXT("Net,Out,,,,,%llu\n"), NetBytes.Out - NetBytesAtStart.Out);
+	FTCG_NetPacking::ForEachStat([&Csv](const FString& Category, const int64 Count,
+		const int64 PackedBits, const int64 DefaultBits)
+		{
+			Csv += FString::Printf(TEXT("Packed,%s,%lld,,,,%lld\n"), *Category, Count, PackedBits / 8);
+		});
+
+	const FString FilePath = Path.IsEmpty() ? FPaths::ProfilingDir() / FString::Printf(
+		TEXT("TCG_MatchStats_%s.csv"), *FDateTime::Now().ToString()) : Path;
+	if (!FFileHelper::SaveStringToFile(Csv, *FilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Match stats not written to %s"), *FilePath);
+		return FString();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Match stats written to %s"), *FilePath);
+	return FilePath;
+}
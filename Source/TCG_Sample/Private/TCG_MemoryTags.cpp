@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_MemoryTags.h"
+#include "HAL/IConsoleManager.h"
+
+LLM_DEFINE_TAG(TCG);
+LLM_DEFINE_TAG(TCG_Cards, TEXT("Cards"), TEXT("TCG"));
+LLM_DEFINE_TAG(TCG_Decks, TEXT("Decks"), TEXT("TCG"));
+LLM_DEFINE_TAG(TCG_Hands, TEXT("Hands"), TEXT("TCG"));
+LLM_DEFINE_TAG(TCG_Sessions, TEXT("Sessions"), TEXT("TCG"));
+LLM_DEFINE_TAG(TCG_Match, TEXT("Match"), TEXT("TCG"));
+
+static FAutoConsoleCommand MemReportCommand(
+	TEXT("tcg.Mem.Report"),
+	TEXT("Logs the TCG and TweenMaker memory tags and their growth since the baseline. 'tcg.Mem.Report baseline' takes a new baseline"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() > 0 && Args[0] == TEXT("baseline"))
+		{
+			FTCG_MemoryTags::SetBaseline();
+		}
+		FTCG_MemoryTags::Report();
+	}));
+
+static FAutoConsoleCommand MemCheckBudgetCommand(
+	TEXT("tcg.Mem.CheckBudget"),
+	TEXT("Logs an error for every memory tag over budget, e.g. tcg.Mem.CheckBudget TCG/Cards=32 TweenMaker/Tweens=4 (MB)"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		TMap<FName, double> Overrides;
+		for (const FString& Arg : Args)
+		{
+			FString Tag;
+			FString Budget;
+			if (Arg.Split(TEXT("="), &Tag, &Budget))
+			{
+				Overrides.Add(FName(*Tag), FCString::Atod(*Budget));
+			}
+		}
+		FTCG_MemoryTags::CheckBudgets(Overrides);
+	}));
+
+namespace
+{
+	struct FTagBudget
+	{
+		const TCHAR* Name;
+		double BudgetMB;
+	};
+
+	// TweenMaker is looked up by name, server targets load the plugin but
+	// don't add it to this module's dependencies
+	const FTagBudget DefaultBudgets[] =
+	{
+		{ TEXT("TCG/Cards"), 64.0 },
+		{ TEXT("TCG/Decks"), 8.0 },
+		{ TEXT("TCG/Hands"), 4.0 },
+		{ TEXT("TCG/Sessions"), 2.0 },
+		{ TEXT("TCG/Match"), 32.0 },
+		{ TEXT("TweenMaker/Containers"), 4.0 },
+		{ TEXT("TweenMaker/Tweens"), 8.0 },
+		{ TEXT("TweenMaker/Delegates"), 2.0 },
+		{ TEXT("TweenMaker/Factories"), 2.0 },
+	};
+
+	TMap<FName, int64> BaselineBytes;
+}
+
+int64 FTCG_MemoryTags::GetTagBytes(const FName TagName)
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	if (FLowLevelMemTracker::IsEnabled())
+	{
+		return FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default,
+			TagName, ELLMTagSet::None);
+	}
+#endif
+	return -1;
+}
+
+int64 FTCG_MemoryTags::GetTotalBytes()
+{
+	if (GetTagBytes(TEXT("TCG")) < 0)
+	{
+		return -1;
+	}
+
+	int64 Total = 0;
+	for (const FTagBudget& Tag : DefaultBudgets)
+	{
+		Total += FMath::Max<int64>(GetTagBytes(Tag.Name), 0);
+	}
+	return Total;
+}
+
+void FTCG_MemoryTags::SetBaseline()
+{
+	BaselineBytes.Reset();
+	for (const FTagBudget& Tag : DefaultBudgets)
+	{
+		BaselineBytes.Add(Tag.Name, GetTagBytes(Tag.Name));
+	}
+}
+
+void FTCG_MemoryTags::Report()
+{
+	if (GetTagBytes(TEXT("TCG")) < 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Memory tags need the low level memory tracker, run with -llm"));
+		return;
+	}
+
+	for (const FTagBudget& Tag : DefaultBudgets)
+	{
+		const int64 Bytes = GetTagBytes(Tag.Name);
+		const int64* Baseline = BaselineBytes.Find(Tag.Name);
+		UE_LOG(LogTemp, Log, TEXT("%s: %.2f MB (%+.2f MB since baseline)"), Tag.Name,
+			Bytes / (1024.0 * 1024.0), Baseline ? (Bytes - *Baseline) / (1024.0 * 1024.0) : 0.0);
+	}
+}
+
+bool FTCG_MemoryTags::CheckBudgets(const TMap<FName, double>& BudgetOverrides)
+{
+	if (GetTagBytes(TEXT("TCG")) < 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Memory budgets not checked, run with -llm"));
+		return true;
+	}
+
+	bool bWithinBudget = true;
+	for (const FTagBudget& Tag : DefaultBudgets)
+	{
+		const double* Override = BudgetOverrides.Find(Tag.Name);
+		const double BudgetMB = Override ? *Override : Tag.BudgetMB;
+		const double UsedMB = GetTagBytes(Tag.Name) / (1024.0 * 1024.0);
+		if (UsedMB > BudgetMB)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s over budget: %.2f MB of %.2f MB"), Tag.Name, UsedMB, BudgetMB);
+			bWithinBudget = false;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Memory budget check %s"), bWithinBudget ? TEXT("passed") : TEXT("failed"));
+	return bWithinBudget;
+}
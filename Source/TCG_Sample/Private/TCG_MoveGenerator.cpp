@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_MoveGenerator.h"
+#include "CardBase.h"
+#include "TCG_CardDatabase.h"
+
+bool FTCG_MoveGenerator::SetCardDatabase(const FTCG_CardDatabase* InCardDatabase)
+{
+	if (CardDatabase == InCardDatabase)
+	{
+		return false;
+	}
+
+	CardDatabase = InCardDatabase;
+	for (FCardMoves& Moves : Hand)
+	{
+		Evaluate(Moves);
+	}
+	return true;
+}
+
+void FTCG_MoveGenerator::SetPhase(const EGamePhase InPhase)
+{
+	// cached results stay valid, the phase only gates them
+	Phase = InPhase;
+	if (Phase == EGamePhase::TurnStart)
+	{
+		bLandPlayed = false;
+	}
+}
+
+void FTCG_MoveGenerator::AddHandCard(const ACardBase* Card)
+{
+	if (!Card || Hand.ContainsByPredicate([Card](const FCardMoves& Moves) 
+		{ 
+			return Moves.Card == Card; 
+		}))
+	{
+		return;
+	}
+
+	FCardMoves& Moves = Hand.AddDefaulted_GetRef();
+	Moves.Card = Card;
+	Evaluate(Moves);
+
+	// payments weigh the rest of the hand, pick them again
+	for (FCardMoves& Other : Hand)
+	{
+		Other.bPaymentValid = false;
+	}
+}
+
+void FTCG_MoveGenerator::RemoveHandCard(const ACardBase* Card)
+{
+	const int32 Removed = Hand.RemoveAll([Card](const FCardMoves& Moves)
+		{
+			return Moves.Card == Card;
+		});
+
+	if (Removed > 0)
+	{
+		for (FCardMoves& Other : Hand)
+		{
+			Other.bPaymentValid = false;
+		}
+	}
+}
+
+void FTCG_MoveGenerator::SetManaSources(const TArray<FTCG_ManaSource>& Sources)
+{
+	ManaSolver.SetSources(Sources);
+
+	// only affordability changes, card data is kept
+	for (FCardMoves& Moves : Hand)
+	{
+		if (Moves.bKnown)
+		{
+			Moves.bPayable = ManaSolver.CanPayAny(Moves.Costs);
+			Moves.bPaymentValid = false;
+		}
+	}
+}
+
+void FTCG_MoveGenerator::SetTargets(const TArray<AActor*>& InTargets)
+{
+	// targets are read when moves are listed, nothing cached depends on them
+	Targets.Reset(InTargets.Num());
+	for (AActor* Target : InTargets)
+	{
+		Targets.Add(Target);
+	}
+}
+
+void FTCG_MoveGenerator::SetLandPlayed(const bool bInLandPlayed)
+{
+	bLandPlayed = bInLandPlayed;
+}
+
+bool FTCG_MoveGenerator::IsPlayable(const ACardBase* Card) const
+{
+	const FCardMoves* Moves = Hand.FindByPredicate([Card](const FCardMoves& Entry)
+		{
+			return Entry.Card == Card;
+		});
+	return Moves && IsCardPlayable(*Moves);
+}
+
+void FTCG_MoveGenerator::GetPlayableCards(TArray<const ACardBase*>& OutCards) const
+{
+	OutCards.Reset();
+	for (const FCardMoves& Moves : Hand)
+	{
+		if (IsCardPlayable(Moves))
+		{
+			OutCards.Add(Moves.Card.Get());
+		}
+	}
+}
+
+void FTCG_MoveGenerator::GetLegalMoves(TArray<FTCG_LegalMove>& OutMoves)
+{
+	OutMoves.Reset();
+	for (FCardMoves& Moves : Hand)
+	{
+		if (!IsCardPlayable(Moves))
+		{
+			continue;
+		}
+
+		if (Moves.bPaymentValid)
+		{
+			CacheHits++;
+		}
+		else
+		{
+			UpdatePayment(Moves);
+		}
+
+		FTCG_LegalMove Move;
+		Move.Card = Moves.Card.Get();
+		Move.Payment = Moves.Payment;
+
+		if (Moves.CardType == ECardType::Spell && Targets.Num() > 0)
+		{
+			for (const TWeakObjectPtr<AActor>& Target : Targets)
+			{
+				if (Target.IsValid())
+				{
+					Move.Target = Target.Get();
+					OutMoves.Add(Move);
+				}
+			}
+		}
+		else
+		{
+			OutMoves.Add(Move);
+		}
+	}
+}
+
+void FTCG_MoveGenerator::Evaluate(FCardMoves& Moves)
+{
+	Evaluations++;
+
+	const ACardBase* Card = Moves.Card.Get();
+	const FTCG_CardEntry* Entry = CardDatabase && Card 
+		? CardDatabase->Find(Card->GetCardData().CardId) : nullptr;
+
+	Moves.bKnown = Entry != nullptr;
+	Moves.bPaymentValid = false;
+	if (!Entry)
+	{
+		Moves.bPayable = false;
+		return;
+	}
+
+	Moves.CardType = Entry->CardType;
+	Moves.Costs = Entry->Costs;
+	Moves.bPayable = ManaSolver.CanPayAny(Moves.Costs);
+}
+
+void FTCG_MoveGenerator::UpdatePayment(FCardMoves& Moves)
+{
+	TArray<const TArray<FManaCost>*> FutureCosts;
+	for (const FCardMoves& Other : Hand)
+	{
+		if (&Other != &Moves && Other.bKnown && Other.Costs.Num() > 0)
+		{
+			FutureCosts.Add(&Other.Costs);
+		}
+	}
+
+	Moves.Payment = ManaSolver.Solve(Moves.Costs, FutureCosts);
+	Moves.bPaymentValid = true;
+}
+
+bool FTCG_MoveGenerator::IsCardPlayable(const FCardMoves& Moves) const
+{
+	if (!IsMainPhase() || !Moves.bKnown || !Moves.Card.IsValid())
+	{
+		return false;
+	}
+	if (Moves.CardType == ECardType::Mana)
+	{
+		return !bLandPlayed;
+	}
+	return Moves.bPayable;
+}
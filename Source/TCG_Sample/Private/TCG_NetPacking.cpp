@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_NetPacking.h"
+#include "HAL/IConsoleManager.h"
+#include <atomic>
+
+namespace
+{
+	// written from the net serializers, read by the reports
+	struct FPackingStats
+	{
+		std::atomic<int64> Count{ 0 };
+		std::atomic<int64> PackedBits{ 0 };
+		std::atomic<int64> DefaultBits{ 0 };
+	};
+
+	FPackingStats PackingStats[static_cast<int32>(ETCG_PackedStruct::Num)];
+
+	const TCHAR* GetStructName(const ETCG_PackedStruct Struct)
+	{
+		switch (Struct)
+		{
+		case ETCG_PackedStruct::ManaCost: return TEXT("ManaCost");
+		case ETCG_PackedStruct::CardHandle: return TEXT("CardHandle");
+		case ETCG_PackedStruct::Hitpoint: return TEXT("Hitpoint");
+		case ETCG_PackedStruct::Command: return TEXT("Command");
+		case ETCG_PackedStruct::SpectatorEvent: return TEXT("SpectatorEvent");
+		default: return TEXT("Unknown");
+		}
+	}
+
+	// SerializeIntPacked writes 7 value bits per byte
+	int32 GetPackedBits(uint32 Value)
+	{
+		int32 Groups = 1;
+		while (Value >= 0x80)
+		{
+			Value >>= 7;
+			Groups++;
+		}
+		return Groups * 8;
+	}
+}
+
+static FAutoConsoleCommand NetReportCommand(
+	TEXT("tcg.Net.Report"),
+	TEXT("Logs bits written by the packed serializers against the default encoding"),
+	FConsoleCommandDelegate::CreateStatic(&FTCG_NetPacking::Report));
+
+static FAutoConsoleCommand NetResetStatsCommand(
+	TEXT("tcg.Net.ResetStats"),
+	TEXT("Clears the packed serializer counters, e.g. before playing back a recorded match"),
+	FConsoleCommandDelegate::CreateStatic(&FTCG_NetPacking::ResetStats));
+
+bool FTCG_NetPacking::SerializeFlag(FArchive& Ar, const bool bFlag)
+{
+	uint8 Bit = bFlag ? 1 : 0;
+	Ar.SerializeBits(&Bit, 1);
+	return Bit != 0;
+}
+
+int32 FTCG_NetPacking::SerializeUnsigned(FArchive& Ar, int32& Value)
+{
+	uint32 Packed = static_cast<uint32>(FMath::Max(Value, 0));
+	Ar.SerializeIntPacked(Packed);
+	Value = static_cast<int32>(Packed);
+	return GetPackedBits(Packed);
+}
+
+int32 FTCG_NetPacking::SerializeSigned(FArchive& Ar, int32& Value)
+{
+	uint32 ZigZag = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	Ar.SerializeIntPacked(ZigZag);
+	Value = static_cast<int32>(ZigZag >> 1) ^ -static_cast<int32>(ZigZag & 1);
+	return GetPackedBits(ZigZag);
+}
+
+int32 FTCG_NetPacking::SerializeQuantized(FArchive& Ar, int32& Value, const int32 MaxValue)
+{
+	uint32 Quantized = static_cast<uint32>(FMath::Clamp(Value, 0, MaxValue));
+	Ar.SerializeInt(Quantized, static_cast<uint32>(MaxValue) + 1);
+	Value = static_cast<int32>(Quantized);
+	return FMath::Max(static_cast<int32>(FMath::CeilLogTwo(static_cast<uint32>(MaxValue) + 1)), 1);
+}
+
+void FTCG_NetPacking::RecordStats(const ETCG_PackedStruct Struct, const int32 PackedBits, 
+	const int32 DefaultBits)
+{
+	FPackingStats& Stats = PackingStats[static_cast<int32>(Struct)];
+	Stats.Count.fetch_add(1, std::memory_order_relaxed);
+	Stats.PackedBits.fetch_add(PackedBits, std::memory_order_relaxed);
+	Stats.DefaultBits.fetch_add(DefaultBits, std::memory_order_relaxed);
+}
+
+void FTCG_NetPacking::Report()
+{
+#if !TCG_NET_PACKING_STATS
+	UE_LOG(LogTemp, Log, TEXT("Packed serializer stats are compiled out of this build"));
+#endif
+	int64 TotalPacked = 0;
+	int64 TotalDefault = 0;
+	ForEachStat([&TotalPacked, &TotalDefault](const FString& Category, const int64 Count,
+		const int64 PackedBits, const int64 DefaultBits)
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s: %lld sent, %lld bits packed vs %lld default (%.1f%%)"),
+				*Category, Count, PackedBits, DefaultBits,
+				DefaultBits > 0 ? 100.0 * PackedBits / DefaultBits : 0.0);
+			TotalPacked += PackedBits;
+			TotalDefault += DefaultBits;
+		});
+	UE_LOG(LogTemp, Log, TEXT("Total: %lld bits packed vs %lld default, saved %lld bytes"),
+		TotalPacked, TotalDefault, (TotalDefault - TotalPacked) / 8);
+}
+
+void FTCG_NetPacking::ResetStats()
+{
+	for (FPackingStats& Stats : PackingStats)
+	{
+		Stats.Count.store(0, std::memory_order_relaxed);
+		Stats.PackedBits.store(0, std::memory_order_relaxed);
+		Stats.DefaultBits.store(0, std::memory_order_relaxed);
+	}
+}
+
+void FTCG_NetPacking::ForEachStat(TFunctionRef<void(const FString& Category, const int64 Count, 
+	const int64 PackedBits, const int64 DefaultBits)> Visitor)
+{
+	for (int32 Index = 0; Index < static_cast<int32>(ETCG_PackedStruct::Num); Index++)
+	{
+		const FPackingStats& Stats = PackingStats[Index];
+		const int64 Count = Stats.Count.load(std::memory_order_relaxed);
+		if (Count > 0)
+		{
+			Visitor(GetStructName(static_cast<ETCG_PackedStruct>(Index)), Count,
+				Stats.PackedBits.load(std::memory_order_relaxed),
+				Stats.DefaultBits.load(std::memory_order_relaxed));
+		}
+	}
+}
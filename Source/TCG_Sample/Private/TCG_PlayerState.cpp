@@ -2,12 +2,29 @@
 
 
 #include "TCG_PlayerState.h"
+#include "CardBase.h"
+#include "Deck.h"
+#include "TCG_GameMode.h"
+#include "TCG_GameState.h"
+#include "TCG_IdleTickSubsystem.h"
+#include "TCG_MatchStats.h"
+#include "TCG_SpectatorBroadcaster.h"
+#include "TCG_TraceLog.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 #include "Net/UnrealNetwork.h"
 
 void ATCG_PlayerState::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (HasAuthority())
+	{
+		ReplicatedHitpoint.Value = Hitpoint;
+	}
+	AckedHitpoint = Hitpoint;
+	HashHitpoint();
+
 	if (HasAuthority())
 	{
 		UE_LOG(LogTemp, Log, TEXT("Server Player's State"));
@@ -25,14 +42,493 @@ void ATCG_PlayerState::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 void ATCG_PlayerState::OnRep_Hitpoint()
 {
-	UE_LOG(LogTemp, Log, TEXT("Hitpoint updated: %d"), Hitpoint);
+	TCG_SCOPE_HOTSPOT(OnRep_Hitpoint);
+
+	TCG_TRACE(HitpointReplicated, "Player {0} hitpoint updated: {1}", PlayerIndex,
+		ReplicatedHitpoint.Value);
+
+	// replication is never older than a reconcile with the same key
+	if (ReplicatedHitpoint.AckedPredictionKey >= AckedPredictionKey)
+	{
+		AcknowledgeHitpoint(ReplicatedHitpoint.AckedPredictionKey, ReplicatedHitpoint.Value);
+	}
+}
+
+void ATCG_PlayerState::AcknowledgeHitpoint(const int32 PredictionKey, 
+	const int32 AuthoritativeHitpoint)
+{
+	AckedPredictionKey = PredictionKey;
+	AckedHitpoint = AuthoritativeHitpoint;
+
+	// keep showing damage the server has not processed yet
+	const int32 Corrected = GetPredictedHitpoint();
+	if (Hitpoint != Corrected)
+	{
+		Hitpoint = Corrected;
+		HashHitpoint();
+		OnHitpointChanged.Broadcast(Hitpoint);
+	}
+}
+
+void ATCG_PlayerState::OnRep_PlayerIndex(const int32 OldPlayerIndex)
+{
+	TCG_SCOPE_HOTSPOT(OnRep_PlayerIndex);
+
+	// move the hitpoint into the new seat's partition
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		FTCG_StateHash& StateHash = TCG_GameState->GetStateHash();
+		StateHash.Toggle(OldPlayerIndex, ETCG_HashKey::Hitpoint, 0, HashedHitpoint);
+		StateHash.Toggle(PlayerIndex, ETCG_HashKey::Hitpoint, 0, HashedHitpoint);
+	}
+}
+
+void ATCG_PlayerState::SetPlayerIndex(const int32 NewPlayerIndex)
+{
+	const int32 OldPlayerIndex = PlayerIndex;
+	PlayerIndex = NewPlayerIndex;
+	OnRep_PlayerIndex(OldPlayerIndex);
+
+	// spectators only hear about changes, give them the starting value
+	if (UTCG_SpectatorBroadcaster* Broadcaster = 
+		GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+	{
+		Broadcaster->QueueHitpointChanged(PlayerIndex, Hitpoint);
+	}
+}
+
+void ATCG_PlayerState::HashHitpoint()
+{
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->GetStateHash().Update(PlayerIndex, ETCG_HashKey::Hitpoint, 0,
+			HashedHitpoint, Hitpoint);
+		HashedHitpoint = Hitpoint;
+	}
+}
+
+void ATCG_PlayerState::ReportStateHash(const int32 PhaseSerial)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	// local moves the server only made after the snapshot
+	if (PendingPredictions.Num() > 0)
+	{
+		return;
+	}
+
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		Server_ReportStateHash(PhaseSerial, TCG_GameState->GetStateHash().GetPlayerView(
+			PlayerIndex, TCG_GameState->GetCheckedHashKeys()));
+	}
+}
+
+void ATCG_PlayerState::Client_ReportStateHash_Implementation(const int32 PhaseSerial)
+{
+	TCG_COUNT_RPC(Client_ReportStateHash);
+
+	ReportStateHash(PhaseSerial);
+}
+
+void ATCG_PlayerState::Server_ReportStateHash_Implementation(const int32 PhaseSerial, 
+	const uint64 ClientHash)
+{
+	TCG_COUNT_RPC(Server_ReportStateHash);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	uint64 ServerHash = 0;
+	if (!TCG_GameState || 
+		!TCG_GameState->FindStateHashSnapshot(PhaseSerial, PlayerIndex, ServerHash))
+	{
+		return;
+	}
+
+	if (ServerHash != ClientHash)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Desync with player %d at phase serial %d: server %016llx client %016llx"),
+			PlayerIndex, PhaseSerial, ServerHash, ClientHash);
+		TCG_GameState->DumpStateDiagnostics(TEXT("server"));
+		Client_DumpStateDiagnostics(PhaseSerial, ServerHash);
+	}
+}
+
+void ATCG_PlayerState::Client_DumpStateDiagnostics_Implementation(const int32 PhaseSerial, 
+	const uint64 ServerHash)
+{
+	TCG_COUNT_RPC(Client_DumpStateDiagnostics);
+
+	UE_LOG(LogTemp, Error, TEXT("Server reported a desync at phase serial %d, server hash %016llx"),
+		PhaseSerial, ServerHash);
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->DumpStateDiagnostics(TEXT("client"));
+	}
+}
+
+int32 ATCG_PlayerState::AddPrediction(const EPredictedAction Action, 
+	const int32 PredictedValue, const int32 Delta, ACardBase* PredictedCard, ADeck* Deck)
+{
+	FPredictedAction Prediction;
+	Prediction.PredictionKey = ++NextPredictionKey;
+	Prediction.Action = Action;
+	Prediction.PredictedValue = PredictedValue;
+	Prediction.Delta = Delta;
+	Prediction.PredictedCard = PredictedCard;
+	Prediction.Deck = Deck;
+	Prediction.RequestTime = FPlatformTime::Seconds();
+
+	PendingPredictions.Add(Prediction);
+	return Prediction.PredictionKey;
+}
+
+int32 ATCG_PlayerState::GetPredictedHitpoint() const
+{
+	int32 Result = AckedHitpoint;
+	for (const FPredictedAction& Pending : PendingPredictions)
+	{
+		if (Pending.Action == EPredictedAction::Damage && 
+			Pending.PredictionKey > AckedPredictionKey)
+		{
+			Result -= Pending.Delta;
+		}
+	}
+	return Result;
+}
+
+void ATCG_PlayerState::ApplyDamage(const int32 Damage)
+{
+	Hitpoint -= Damage;
+	if (HasAuthority())
+	{
+		ReplicatedHitpoint.Value = Hitpoint;
+	}
+	AckedHitpoint = Hitpoint;
+	HashHitpoint();
 
+	if (UTCG_SpectatorBroadcaster* Broadcaster = 
+		GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+	{
+		Broadcaster->QueueHitpointChanged(PlayerIndex, Hitpoint);
+	}
 	OnHitpointChanged.Broadcast(Hitpoint);
 }
 
 void ATCG_PlayerState::Req_Damage_Implementation(const int32& Damage)
 {
-	UE_LOG(LogTemp, Log, TEXT("Client: Hitpoint updated to %d"), Hitpoint);
+	TCG_SCOPE_HOTSPOT(Req_Damage);
+	TCG_COUNT_RPC(Req_Damage);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	if (!IsRequestAllowed(ETCG_CommandType::Damage, Damage))
+	{
+		return;
+	}
+	ApplyDamage(Damage);
+
+	TCG_TRACE(HitpointApplied, "Server: player {0} hitpoint updated to {1} by {2} damage",
+		PlayerIndex, Hitpoint, Damage);
+}
+
+void ATCG_PlayerState::SubmitCommand(const ETCG_CommandType Type, const int32 Value)
+{
+	FTCG_Command Command;
+	Command.Type = Type;
+	Command.Value = Value;
+
+	if (HasAuthority())
+	{
+		Server_SubmitCommand_Implementation(Command);
+	}
+	else
+	{
+		Server_SubmitCommand(Command);
+	}
+}
+
+void ATCG_PlayerState::Server_SubmitCommand_Implementation(const FTCG_Command& Command)
+{
+	TCG_COUNT_RPC(Server_SubmitCommand);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		// the sender decides nothing but what it asks for
+		FTCG_Command Submitted = Command;
+		Submitted.PlayerIndex = PlayerIndex;
+		TCG_GameState->SubmitCommand(Submitted);
+	}
+}
+
+bool ATCG_PlayerState::IsRequestAllowed(const ETCG_CommandType Type, const int32 Value) const
+{
+	const APlayerController* Controller = GetPlayerController();
+	if (Controller && Controller->IsLocalController())
+	{
+		return true;
+	}
+
+	const ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>();
+	FTCG_Command Command;
+	Command.PlayerIndex = PlayerIndex;
+	Command.Type = Type;
+	Command.Value = Value;
+	if (TCG_GameState && TCG_GameState->IsCommandAllowed(Command))
+	{
+		return true;
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("Request %d (%d) from player %d rejected"),
+		static_cast<int32>(Type), Value, PlayerIndex);
+	return false;
+}
+
+void ATCG_PlayerState::Client_SetDeckSeed_Implementation(ADeck* Deck, const int32 Seed)
+{
+	TCG_COUNT_RPC(Client_SetDeckSeed);
+
+	if (Deck)
+	{
+		Deck->SetShuffleSeed(Seed);
+	}
+}
+
+void ATCG_PlayerState::Client_MirrorDeck_Implementation(ADeck* Deck, 
+	const FTCG_DeckMutation& Mutation)
+{
+	TCG_COUNT_RPC(Client_MirrorDeck);
+
+	if (Deck)
+	{
+		Deck->ApplyMirroredMutation(Mutation);
+	}
+}
+
+static bool IsLockstepMatch(const UWorld* World)
+{
+	const ATCG_GameState* TCG_GameState = World->GetGameState<ATCG_GameState>();
+	return TCG_GameState && TCG_GameState->IsLockstep();
+}
+
+void ATCG_PlayerState::RequestDraw(ADeck* Deck)
+{
+	if (!Deck)
+	{
+		return;
+	}
+
+	if (IsLockstepMatch(GetWorld()))
+	{
+		SubmitCommand(ETCG_CommandType::Draw, Deck->GetOwnerIndex());
+		return;
+	}
+
+	if (HasAuthority())
+	{
+		Deck->Draw();
+		return;
+	}
+
+	ACardBase* PredictedCard = Deck->PredictDraw();
+	const int32 Key = AddPrediction(EPredictedAction::Draw, 
+		Deck->GetRemainingCardNum(), 0, PredictedCard, Deck);
+
+	Server_RequestDraw(Key, Deck);
+}
+
+void ATCG_PlayerState::RequestPhaseChange(const EGamePhase TargetPhase)
+{
+	if (IsLockstepMatch(GetWorld()))
+	{
+		SubmitCommand(ETCG_CommandType::PhaseChange, static_cast<int32>(TargetPhase));
+		return;
+	}
+
+	if (HasAuthority())
+	{
+		if (ATCG_GameMode* GameMode = GetWorld()->GetAuthGameMode<ATCG_GameMode>())
+		{
+			GameMode->RequestPhaseChange(TargetPhase);
+		}
+		return;
+	}
+
+	if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+	{
+		TCG_GameState->PredictGamePhase(TargetPhase);
+	}
+	const int32 Key = AddPrediction(EPredictedAction::PhaseChange, 
+		static_cast<int32>(TargetPhase));
+
+	Server_RequestPhaseChange(Key, TargetPhase);
+}
+
+void ATCG_PlayerState::RequestDamage(const int32 Damage)
+{
+	if (IsLockstepMatch(GetWorld()))
+	{
+		SubmitCommand(ETCG_CommandType::Damage, Damage);
+		return;
+	}
+
+	if (HasAuthority())
+	{
+		Req_Damage(Damage);
+		return;
+	}
+
+	ApplyDamage(Damage);
+	const int32 Key = AddPrediction(EPredictedAction::Damage, Hitpoint, Damage);
+
+	Server_RequestDamage(Key, Damage);
+}
+
+void ATCG_PlayerState::Server_RequestDraw_Implementation(const int32 PredictionKey, 
+	ADeck* Deck)
+{
+	TCG_COUNT_RPC(Server_RequestDraw);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	// players only draw from their own deck on their turn, the prediction gets rolled back
+	if (Deck && !IsRequestAllowed(ETCG_CommandType::Draw, Deck->GetOwnerIndex()))
+	{
+		Client_ReconcileAction(PredictionKey, Deck->GetRemainingCardNum(), FTCG_CardHandle());
+		return;
+	}
+
+	// the reconcile answers this draw, so it isn't mirrored
+	ACardBase* DrewCard = Deck ? Deck->DrawRequested() : nullptr;
+	const int32 Remaining = Deck ? Deck->GetRemainingCardNum() : 0;
+
+	Client_ReconcileAction(PredictionKey, Remaining, 
+		DrewCard ? DrewCard->CardHandle : FTCG_CardHandle());
+}
+
+void ATCG_PlayerState::Server_RequestPhaseChange_Implementation(const int32 PredictionKey, 
+	const EGamePhase TargetPhase)
+{
+	TCG_COUNT_RPC(Server_RequestPhaseChange);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	// forward only and by the player whose turn it is, else the client rolls back
+	ATCG_GameMode* GameMode = GetWorld()->GetAuthGameMode<ATCG_GameMode>();
+	EGamePhase ResultPhase = GameMode ? GameMode->GetCurrentGamePhase() : TargetPhase;
+	if (GameMode && IsRequestAllowed(ETCG_CommandType::PhaseChange, static_cast<int32>(TargetPhase)))
+	{
+		GameMode->RequestPhaseChange(TargetPhase);
+		ResultPhase = GameMode->GetCurrentGamePhase();
+	}
+
+	Client_ReconcileAction(PredictionKey, static_cast<int32>(ResultPhase), FTCG_CardHandle());
+}
+
+void ATCG_PlayerState::Server_RequestDamage_Implementation(const int32 PredictionKey, 
+	const int32 Damage)
+{
+	TCG_COUNT_RPC(Server_RequestDamage);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	// a rejected request answers with the unchanged hitpoint, no healing by negative damage
+	Req_Damage_Implementation(Damage);
+	ReplicatedHitpoint.AckedPredictionKey = PredictionKey;
+
+	Client_ReconcileAction(PredictionKey, Hitpoint, FTCG_CardHandle());
+}
+
+void ATCG_PlayerState::Client_ReconcileAction_Implementation(const int32 PredictionKey, 
+	const int32 AuthoritativeValue, const FTCG_CardHandle AuthoritativeHandle)
+{
+	TCG_COUNT_RPC(Client_ReconcileAction);
+
+	// reliable RPCs arrive in order, so this is normally the first entry
+	const int32 Index = PendingPredictions.IndexOfByPredicate(
+		[PredictionKey](const FPredictedAction& Pending)
+		{
+			return Pending.PredictionKey == PredictionKey;
+		});
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FPredictedAction Predicted = PendingPredictions[Index];
+	PendingPredictions.RemoveAt(Index);
+
+	bool bMismatch = false;
+	switch (Predicted.Action)
+	{
+	case EPredictedAction::Draw:
+	{
+		ACardBase* AuthoritativeCard = nullptr;
+		if (Predicted.PredictedCard && AuthoritativeHandle.IsValid() &&
+			Predicted.PredictedCard->CardHandle == AuthoritativeHandle)
+		{
+			AuthoritativeCard = Predicted.PredictedCard;
+		}
+		else if (Predicted.Deck)
+		{
+			// may be the card a later pending draw predicted, already in the hand
+			AuthoritativeCard = Predicted.Deck->FindOwnedCard(AuthoritativeHandle);
+		}
+
+		bMismatch = Predicted.PredictedCard != AuthoritativeCard;
+		if (Predicted.Deck && bMismatch)
+		{
+			// later draws from this deck were predicted on the wrong library,
+			// they are predicted again in key order and keep waiting
+			TArray<FPredictedAction*> LaterDraws;
+			TArray<ACardBase*> LaterCards;
+			for (FPredictedAction& Pending : PendingPredictions)
+			{
+				if (Pending.Action == EPredictedAction::Draw && Pending.Deck == Predicted.Deck &&
+					Pending.PredictionKey > PredictionKey)
+				{
+					LaterDraws.Add(&Pending);
+					LaterCards.Add(Pending.PredictedCard);
+				}
+			}
+
+			Predicted.Deck->ReconcileDraw(Predicted.PredictedCard, AuthoritativeCard, LaterCards);
+			for (int32 LaterIndex = 0; LaterIndex < LaterDraws.Num(); LaterIndex++)
+			{
+				LaterDraws[LaterIndex]->PredictedCard = LaterCards[LaterIndex];
+			}
+		}
+		break;
+	}
+	case EPredictedAction::PhaseChange:
+		bMismatch = Predicted.PredictedValue != AuthoritativeValue;
+		if (bMismatch)
+		{
+			if (ATCG_GameState* TCG_GameState = GetWorld()->GetGameState<ATCG_GameState>())
+			{
+				TCG_GameState->ClearPredictedGamePhase();
+			}
+		}
+		break;
+	case EPredictedAction::Damage:
+		bMismatch = Predicted.PredictedValue != AuthoritativeValue;
+		// replication may already have brought this damage and later ones
+		if (PredictionKey > AckedPredictionKey)
+		{
+			AcknowledgeHitpoint(PredictionKey, AuthoritativeValue);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (bMismatch)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Prediction %d rolled back"), PredictionKey);
+		OnPredictionRejected.Broadcast(Predicted);
+	}
+	OnActionReconciled.Broadcast(Predicted);
 }
 
 void ATCG_PlayerState::GetLifetimeReplicatedProps(
@@ -40,5 +536,15 @@ void ATCG_PlayerState::GetLifetimeReplicatedProps(
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ATCG_PlayerState, Hitpoint);
+	DOREPLIFETIME(ATCG_PlayerState, ReplicatedHitpoint);
+	DOREPLIFETIME(ATCG_PlayerState, PlayerIndex);
+}
+
+void ATCG_PlayerState::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// damage commands keep it up to date on every peer
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ATCG_PlayerState, ReplicatedHitpoint, 
+		!IsLockstepMatch(GetWorld()));
 }
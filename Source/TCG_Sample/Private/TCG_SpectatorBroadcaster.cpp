@@ -0,0 +1,297 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_SpectatorBroadcaster.h"
+#include "TCG_SpectatorComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/MemoryWriter.h"
+#include "TCG_IdleTickSubsystem.h"
+#include "TCG_NetPacking.h"
+
+static TAutoConsoleVariable<float> CVarSpectatorBroadcastDelay(
+	TEXT("tcg.Spectator.BroadcastDelay"),
+	0.0f,
+	TEXT("Seconds public events are held back before spectators see them"));
+
+int32 FTCG_SpectatorEvent::NetSerialize(FArchive& Ar, const FTCG_SpectatorState& Baseline)
+{
+	int32 TypeValue = static_cast<int32>(Type);
+	int32 Bits = FTCG_NetPacking::SerializeQuantized(Ar, TypeValue, 
+		StaticEnum<ETCG_SpectatorEventType>()->NumEnums() - 2);
+	Bits += FTCG_NetPacking::SerializeQuantized(Ar, PlayerIndex, 
+		FTCG_ZoneIndex::MaxPlayers - 1);
+	Type = static_cast<ETCG_SpectatorEventType>(TypeValue);
+
+	switch (Type)
+	{
+	case ETCG_SpectatorEventType::PhaseChanged:
+		Bits += FTCG_NetPacking::SerializeQuantized(Ar, Value, 
+			StaticEnum<EGamePhase>()->NumEnums() - 2);
+		break;
+	case ETCG_SpectatorEventType::HitpointChanged:
+	{
+		const int32 Previous = Baseline.Hitpoints[PlayerIndex];
+		int32 Delta = Value - Previous;
+		Bits += FTCG_NetPacking::SerializeSigned(Ar, Delta);
+		Value = Previous + Delta;
+		break;
+	}
+	case ETCG_SpectatorEventType::CardMoved:
+	{
+		int32 ZoneValue = static_cast<int32>(Zone);
+		Bits += FTCG_NetPacking::SerializeUnsigned(Ar, Value);
+		Bits += FTCG_NetPacking::SerializeQuantized(Ar, ZoneValue, 
+			StaticEnum<ECardZone>()->NumEnums() - 2);
+		Zone = static_cast<ECardZone>(ZoneValue);
+
+		Bits++;
+		if (FTCG_NetPacking::SerializeFlag(Ar, CardId != 0))
+		{
+			Bits += FTCG_NetPacking::SerializeUnsigned(Ar, CardId);
+		}
+		else
+		{
+			CardId = 0;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return Bits;
+}
+
+void FTCG_SpectatorState::Apply(const FTCG_SpectatorEvent& Event)
+{
+	LastSequence = Event.Sequence;
+
+	switch (Event.Type)
+	{
+	case ETCG_SpectatorEventType::PhaseChanged:
+		Phase = static_cast<EGamePhase>(Event.Value);
+		break;
+	case ETCG_SpectatorEventType::HitpointChanged:
+		if (Event.PlayerIndex >= 0 && Event.PlayerIndex < FTCG_ZoneIndex::MaxPlayers)
+		{
+			Hitpoints[Event.PlayerIndex] = Event.Value;
+		}
+		break;
+	case ETCG_SpectatorEventType::CardMoved:
+	{
+		FPublicCard& Card = Cards.FindOrAdd(Event.Value);
+		Card.PlayerIndex = Event.PlayerIndex;
+		Card.Zone = Event.Zone;
+		Card.CardId = Event.CardId;
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void FTCG_SpectatorState::Serialize(FArchive& Ar)
+{
+	uint8 PhaseByte = static_cast<uint8>(Phase);
+	Ar << LastSequence << PhaseByte;
+	Phase = static_cast<EGamePhase>(PhaseByte);
+
+	for (int32& Hitpoint : Hitpoints)
+	{
+		Ar << Hitpoint;
+	}
+
+	int32 CardNum = Cards.Num();
+	Ar << CardNum;
+	if (Ar.IsSaving())
+	{
+		for (TPair<int32, FPublicCard>& Pair : Cards)
+		{
+			uint8 PlayerByte = static_cast<uint8>(Pair.Value.PlayerIndex);
+			uint8 ZoneByte = static_cast<uint8>(Pair.Value.Zone);
+			Ar << Pair.Key << PlayerByte << ZoneByte << Pair.Value.CardId;
+		}
+	}
+	else
+	{
+		Cards.Reset();
+		for (int32 Index = 0; Index < CardNum && !Ar.IsError(); Index++)
+		{
+			int32 Handle = 0;
+			uint8 PlayerByte = 0;
+			uint8 ZoneByte = 0;
+			FPublicCard Card;
+			Ar << Handle << PlayerByte << ZoneByte << Card.CardId;
+			Card.PlayerIndex = PlayerByte;
+			Card.Zone = static_cast<ECardZone>(ZoneByte);
+			Cards.Add(Handle, Card);
+		}
+	}
+}
+
+bool UTCG_SpectatorBroadcaster::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return Super::ShouldCreateSubsystem(Outer) && World && World->IsGameWorld();
+}
+
+void UTCG_SpectatorBroadcaster::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Spectators.Num() == 0 && PendingEvents.Num() == 0)
+	{
+		return;
+	}
+	Flush(GetWorld()->GetTimeSeconds());
+}
+
+TStatId UTCG_SpectatorBroadcaster::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTCG_SpectatorBroadcaster, STATGROUP_Tickables);
+}
+
+void UTCG_SpectatorBroadcaster::QueuePhaseChanged(const EGamePhase Phase)
+{
+	FTCG_SpectatorEvent Event;
+	Event.Type = ETCG_SpectatorEventType::PhaseChanged;
+	Event.Value = static_cast<int32>(Phase);
+	QueueEvent(Event);
+}
+
+void UTCG_SpectatorBroadcaster::QueueHitpointChanged(const int32 PlayerIndex, 
+	const int32 Hitpoint)
+{
+	// players without a seat have nothing to show
+	if (PlayerIndex < 0 || PlayerIndex >= FTCG_ZoneIndex::MaxPlayers)
+	{
+		return;
+	}
+
+	FTCG_SpectatorEvent Event;
+	Event.Type = ETCG_SpectatorEventType::HitpointChanged;
+	Event.PlayerIndex = PlayerIndex;
+	Event.Value = Hitpoint;
+	QueueEvent(Event);
+}
+
+void UTCG_SpectatorBroadcaster::QueueCardMoved(const int32 PlayerIndex, 
+	const FTCG_CardHandle Handle, const ECardZone Zone, const int32 CardId)
+{
+	FTCG_SpectatorEvent Event;
+	Event.Type = ETCG_SpectatorEventType::CardMoved;
+	Event.PlayerIndex = PlayerIndex;
+	Event.Value = Handle.Index;
+	Event.Zone = Zone;
+	Event.CardId = IsPublicZone(Zone) ? CardId : 0;
+	QueueEvent(Event);
+}
+
+void UTCG_SpectatorBroadcaster::AddSpectator(UTCG_SpectatorComponent* Spectator)
+{
+	Spectators.AddUnique(Spectator);
+}
+
+void UTCG_SpectatorBroadcaster::RemoveSpectator(UTCG_SpectatorComponent* Spectator)
+{
+	Spectators.Remove(Spectator);
+}
+
+bool UTCG_SpectatorBroadcaster::IsPublicZone(const ECardZone Zone)
+{
+	return Zone == ECardZone::Board || Zone == ECardZone::Graveyard 
+		|| Zone == ECardZone::OpponentRevealed;
+}
+
+void UTCG_SpectatorBroadcaster::QueueEvent(FTCG_SpectatorEvent& Event)
+{
+	// clients predict and simulate too, only the server's events are real
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	Event.Sequence = NextSequence++;
+	Event.Time = GetWorld()->GetTimeSeconds();
+	PendingEvents.Add(Event);
+
+	// an idle server still has to flush it once the delay is over
+	if (UTCG_IdleTickSubsystem* IdleTick = GetWorld()->GetSubsystem<UTCG_IdleTickSubsystem>())
+	{
+		IdleTick->ScheduleWake(Event.Time + CVarSpectatorBroadcastDelay.GetValueOnGameThread());
+	}
+}
+
+void UTCG_SpectatorBroadcaster::Flush(const double Now)
+{
+	const double Horizon = Now - CVarSpectatorBroadcastDelay.GetValueOnGameThread();
+	int32 ReadyNum = 0;
+	while (ReadyNum < PendingEvents.Num() && PendingEvents[ReadyNum].Time <= Horizon)
+	{
+		ReadyNum++;
+	}
+
+	TOptional<FTCG_SharedPacket> Packet;
+	if (ReadyNum > 0)
+	{
+		// serialized once, whatever the number of spectators. every receiver
+		// holds DelayedState as it was before this packet
+		FBitWriter Writer(0, true);
+		int32 FirstSequence = PendingEvents[0].Sequence;
+		FTCG_NetPacking::SerializeUnsigned(Writer, ReadyNum);
+		FTCG_NetPacking::SerializeUnsigned(Writer, FirstSequence);
+		for (int32 Index = 0; Index < ReadyNum; Index++)
+		{
+			FTCG_SpectatorEvent& Event = PendingEvents[Index];
+			const int32 Bits = Event.NetSerialize(Writer, DelayedState);
+			DelayedState.Apply(Event);
+
+			// sequence, type, player, value, zone and card id as bytes and int32s
+			FTCG_NetPacking::Record(ETCG_PackedStruct::SpectatorEvent, Bits, 120);
+		}
+		PendingEvents.RemoveAt(0, ReadyNum, false);
+
+		Packet = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(*Writer.GetBuffer());
+		CachedSnapshot.Reset();
+	}
+
+	int32 Receivers = 0;
+	for (int32 Index = Spectators.Num() - 1; Index >= 0; Index--)
+	{
+		UTCG_SpectatorComponent* Spectator = Spectators[Index].Get();
+		if (!Spectator)
+		{
+			Spectators.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// the snapshot already holds this flush's events
+		if (!Spectator->HasSnapshot())
+		{
+			Spectator->SendSnapshot(GetSnapshot());
+		}
+		else if (Packet.IsSet())
+		{
+			Spectator->SendPacket(Packet.GetValue());
+			Receivers++;
+		}
+		else
+		{
+			Spectator->FlushPending();
+		}
+	}
+	SharedSends += FMath::Max(Receivers - 1, 0);
+}
+
+FTCG_SharedPacket UTCG_SpectatorBroadcaster::GetSnapshot()
+{
+	if (!CachedSnapshot.IsSet())
+	{
+		TArray<uint8> Buffer;
+		FMemoryWriter Writer(Buffer);
+		DelayedState.Serialize(Writer);
+		CachedSnapshot = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(Buffer));
+	}
+	return CachedSnapshot.GetValue();
+}
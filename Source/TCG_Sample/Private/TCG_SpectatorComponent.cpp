@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_SpectatorComponent.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/MemoryReader.h"
+#include "TCG_IdleTickSubsystem.h"
+#include "TCG_MatchStats.h"
+#include "TCG_NetPacking.h"
+
+UTCG_SpectatorComponent::UTCG_SpectatorComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UTCG_SpectatorComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// the client asks once the component exists on its side, 
+	// so the snapshot can't arrive before it
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if (PlayerController && PlayerController->IsLocalController() && 
+		GetOwnerRole() != ROLE_Authority)
+	{
+		Server_RequestSnapshot();
+	}
+}
+
+void UTCG_SpectatorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (UTCG_SpectatorBroadcaster* Broadcaster = 
+			GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+		{
+			Broadcaster->RemoveSpectator(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UTCG_SpectatorComponent::SendPacket(const FTCG_SharedPacket& Packet)
+{
+	PendingPackets.Add(Packet);
+	FlushPending();
+}
+
+void UTCG_SpectatorComponent::SendSnapshot(const FTCG_SharedPacket& Snapshot)
+{
+	PendingPackets.Reset();
+	Client_ReceiveSnapshot(*Snapshot);
+	bSnapshotSent = true;
+}
+
+void UTCG_SpectatorComponent::FlushPending()
+{
+	int32 SentNum = 0;
+	while (SentNum < PendingPackets.Num() && IsConnectionReady())
+	{
+		Client_ReceivePacket(*PendingPackets[SentNum]);
+		SentNum++;
+	}
+	if (SentNum > 0)
+	{
+		PendingPackets.RemoveAt(0, SentNum, false);
+	}
+
+	// retry next frame rather than next idle frame
+	if (PendingPackets.Num() > 0)
+	{
+		UTCG_IdleTickSubsystem::Wake(this);
+	}
+}
+
+int32 UTCG_SpectatorComponent::GetHitpoint(const int32 PlayerIndex) const
+{
+	return PlayerIndex >= 0 && PlayerIndex < FTCG_ZoneIndex::MaxPlayers ? 
+		State.Hitpoints[PlayerIndex] : 0;
+}
+
+void UTCG_SpectatorComponent::Server_RequestSnapshot_Implementation()
+{
+	TCG_COUNT_RPC(Server_RequestSnapshot);
+	UTCG_IdleTickSubsystem::Wake(this);
+
+	if (UTCG_SpectatorBroadcaster* Broadcaster = 
+		GetWorld()->GetSubsystem<UTCG_SpectatorBroadcaster>())
+	{
+		bSnapshotSent = false;
+		Broadcaster->AddSpectator(this);
+	}
+}
+
+void UTCG_SpectatorComponent::Client_ReceiveSnapshot_Implementation(
+	const TArray<uint8>& Snapshot)
+{
+	TCG_COUNT_RPC(Client_ReceiveSnapshot);
+
+	FMemoryReader Reader(Snapshot);
+	State = FTCG_SpectatorState();
+	State.Serialize(Reader);
+
+	OnSpectatorSnapshot.Broadcast();
+}
+
+void UTCG_SpectatorComponent::Client_ReceivePacket_Implementation(const TArray<uint8>& Packet)
+{
+	TCG_COUNT_RPC(Client_ReceivePacket);
+
+	FBitReader Reader(const_cast<uint8*>(Packet.GetData()), Packet.Num() * 8);
+	int32 EventNum = 0;
+	int32 FirstSequence = 0;
+	FTCG_NetPacking::SerializeUnsigned(Reader, EventNum);
+	FTCG_NetPacking::SerializeUnsigned(Reader, FirstSequence);
+
+	for (int32 Index = 0; Index < EventNum && !Reader.IsError(); Index++)
+	{
+		FTCG_SpectatorEvent Event;
+		Event.Sequence = FirstSequence + Index;
+		Event.NetSerialize(Reader, State);
+		if (Event.Sequence <= State.LastSequence)
+		{
+			continue;
+		}
+
+		State.Apply(Event);
+		OnSpectatorEvent.Broadcast(Event);
+	}
+}
+
+bool UTCG_SpectatorComponent::IsConnectionReady() const
+{
+	// keeps a slow viewer from overflowing its reliable buffer
+	UNetConnection* Connection = GetOwner()->GetNetConnection();
+	return Connection && Connection->IsNetReady(false);
+}
@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_StatLayers.h"
+#include "Algo/BinarySearch.h"
+
+static TAutoConsoleVariable<int32> CVarStatLayersVerify(
+	TEXT("tcg.StatLayers.Verify"),
+	0,
+	TEXT("Check every stat read against a full recompute of all effects."));
+
+void FTCG_StatLayers::Init(const int32 InMaxCards, FTCG_ZoneIndex* InZoneIndex)
+{
+	Cards.Reset();
+	Cards.SetNum(InMaxCards);
+	RegisteredNum = 0;
+	ZoneIndex = InZoneIndex;
+	if (ZoneIndex)
+	{
+		ZoneIndex->SetStatLayers(this);
+	}
+	DirtyIndices.Reset();
+	Effects.Reset();
+	NextEffectId = 1;
+	ResetStats();
+}
+
+void FTCG_StatLayers::Reset()
+{
+	Init(Cards.Num(), ZoneIndex);
+}
+
+void FTCG_StatLayers::SetBaseStats(const FTCG_CardHandle Handle, const int32 Attack, 
+	const int32 HitPoint)
+{
+	if (!Handle.IsValid() || Handle.Index >= Cards.Num())
+	{
+		return;
+	}
+
+	FCardStats& Card = Cards[Handle.Index];
+	if (!Card.bRegistered)
+	{
+		Card.bRegistered = true;
+		RegisteredNum++;
+	}
+	Card.BaseAttack = Attack;
+	Card.BaseHitPoint = HitPoint;
+
+	CountChange();
+	MarkDirty(Handle.Index);
+}
+
+int32 FTCG_StatLayers::AddEffect(const FTCG_StatEffect& Effect, 
+	const TArray<FTCG_CardHandle>& Targets)
+{
+	const int32 EffectId = NextEffectId++;
+	FEffect& NewEffect = Effects.Add(EffectId);
+	NewEffect.Stat = Effect;
+	NewEffect.Targets.Init(Cards.Num());
+
+	CountChange();
+	for (const FTCG_CardHandle Target : Targets)
+	{
+		if (FindCard(Target))
+		{
+			NewEffect.Targets.Set(Target.Index);
+			AddContribution(Target.Index, EffectId);
+		}
+	}
+	return EffectId;
+}
+
+int32 FTCG_StatLayers::AddAura(const FTCG_StatEffect& Effect, const FTCG_CompiledQuery& Query)
+{
+	const int32 EffectId = NextEffectId++;
+	FEffect& NewEffect = Effects.Add(EffectId);
+	NewEffect.Stat = Effect;
+	NewEffect.bAura = true;
+	NewEffect.Query = Query;
+	NewEffect.Targets.Init(Cards.Num());
+
+	CountChange();
+	FTCG_CardBitset Matches;
+	Query.Evaluate(Matches);
+	Matches.ForEachSetBit([this, &NewEffect, EffectId](const int32 Index)
+		{
+			if (Index < Cards.Num() && Cards[Index].bRegistered)
+			{
+				NewEffect.Targets.Set(Index);
+				AddContribution(Index, EffectId);
+			}
+		});
+	return EffectId;
+}
+
+void FTCG_StatLayers::RemoveEffect(const int32 EffectId)
+{
+	FEffect Removed;
+	if (!Effects.RemoveAndCopyValue(EffectId, Removed))
+	{
+		return;
+	}
+
+	CountChange();
+	Removed.Targets.ForEachSetBit([this, EffectId](const int32 Index)
+		{
+			RemoveContribution(Index, EffectId);
+		});
+}
+
+void FTCG_StatLayers::RefreshAuras()
+{
+	bool bCounted = false;
+	FTCG_CardBitset& Matches = AuraMatches;
+	FTCG_CardBitset& Changed = AuraChanged;
+	for (TPair<int32, FEffect>& Pair : Effects)
+	{
+		FEffect& Effect = Pair.Value;
+		if (!Effect.bAura)
+		{
+			continue;
+		}
+
+		Effect.Query.Evaluate(Matches);
+		if (Matches.Num() != Effect.Targets.Num())
+		{
+			continue;
+		}
+
+		// symmetric difference, the cards whose membership changed
+		Changed = Matches;
+		Changed.AndNot(Effect.Targets);
+		AuraLeft = Effect.Targets;
+		AuraLeft.AndNot(Matches);
+		Changed |= AuraLeft;
+		if (Changed.IsEmpty())
+		{
+			continue;
+		}
+
+		if (!bCounted)
+		{
+			CountChange();
+			bCounted = true;
+		}
+
+		const int32 EffectId = Pair.Key;
+		Changed.ForEachSetBit([this, &Effect, &Matches, EffectId](const int32 Index)
+			{
+				if (Matches.Contains(Index) && Cards[Index].bRegistered)
+				{
+					Effect.Targets.Set(Index);
+					AddContribution(Index, EffectId);
+				}
+				else if (Effect.Targets.Contains(Index))
+				{
+					Effect.Targets.Clear(Index);
+					RemoveContribution(Index, EffectId);
+				}
+			});
+	}
+}
+
+int32 FTCG_StatLayers::GetAttack(const FTCG_CardHandle Handle)
+{
+	const FCardStats* Card = ReadCard(Handle);
+	return Card ? Card->Attack : 0;
+}
+
+int32 FTCG_StatLayers::GetHitPoint(const FTCG_CardHandle Handle)
+{
+	const FCardStats* Card = ReadCard(Handle);
+	return Card ? Card->HitPoint : 0;
+}
+
+int32 FTCG_StatLayers::VerifyAll()
+{
+	int32 Mismatches = 0;
+	for (int32 Index = 0; Index < Cards.Num(); Index++)
+	{
+		FCardStats& Card = Cards[Index];
+		if (!Card.bRegistered)
+		{
+			continue;
+		}
+		if (Card.bDirty)
+		{
+			Recompute(Card);
+		}
+
+		int32 Attack = 0;
+		int32 HitPoint = 0;
+		ComputeFull(Index, Attack, HitPoint);
+		if (Attack != Card.Attack || HitPoint != Card.HitPoint)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Stat layers mismatch on card %d: %d/%d cached, %d/%d full"),
+				Index, Card.Attack, Card.HitPoint, Attack, HitPoint);
+			Mismatches++;
+		}
+	}
+	Stats.VerifyFailures += Mismatches;
+	return Mismatches;
+}
+
+FTCG_StatLayers::FCardStats* FTCG_StatLayers::FindCard(const FTCG_CardHandle Handle)
+{
+	if (!Handle.IsValid() || Handle.Index >= Cards.Num() || !Cards[Handle.Index].bRegistered)
+	{
+		return nullptr;
+	}
+	return &Cards[Handle.Index];
+}
+
+const FTCG_StatLayers::FCardStats* FTCG_StatLayers::ReadCard(const FTCG_CardHandle Handle)
+{
+	FCardStats* Card = FindCard(Handle);
+	if (!Card)
+	{
+		return nullptr;
+	}
+
+	Stats.Reads++;
+	if (Card->bDirty)
+	{
+		Recompute(*Card);
+	}
+	else
+	{
+		Stats.CacheHits++;
+	}
+
+	if (CVarStatLayersVerify.GetValueOnAnyThread() != 0)
+	{
+		int32 Attack = 0;
+		int32 HitPoint = 0;
+		ComputeFull(Handle.Index, Attack, HitPoint);
+		if (!ensureMsgf(Attack == Card->Attack && HitPoint == Card->HitPoint,
+			TEXT("Stat layers mismatch on card %d: %d/%d cached, %d/%d full"),
+			Handle.Index, Card->Attack, Card->HitPoint, Attack, HitPoint))
+		{
+			Stats.VerifyFailures++;
+		}
+	}
+	return Card;
+}
+
+void FTCG_StatLayers::MarkDirty(const int32 Index)
+{
+	FCardStats& Card = Cards[Index];
+	if (!Card.bPendingZoneIndex && ZoneIndex)
+	{
+		Card.bPendingZoneIndex = true;
+		DirtyIndices.Add(Index);
+	}
+	Card.bDirty = true;
+}
+
+void FTCG_StatLayers::FlushToZoneIndex()
+{
+	if (!ZoneIndex)
+	{
+		return;
+	}
+
+	// cards read since they changed are clean already but not in the buckets
+	for (const int32 Index : DirtyIndices)
+	{
+		FCardStats& Card = Cards[Index];
+		Card.bPendingZoneIndex = false;
+		if (!Card.bRegistered)
+		{
+			continue;
+		}
+
+		if (Card.bDirty)
+		{
+			Recompute(Card);
+		}
+		FTCG_CardHandle Handle;
+		Handle.Index = Index;
+		ZoneIndex->SetStats(Handle, Card.Attack, Card.HitPoint);
+	}
+	DirtyIndices.Reset();
+}
+
+void FTCG_StatLayers::AddContribution(const int32 Index, const int32 EffectId)
+{
+	// auras re-adding a card bring back older ids, so insert in order
+	TArray<int32, TInlineAllocator<4, FTCG_ArenaAllocator>>& EffectIds = Cards[Index].EffectIds;
+	EffectIds.Insert(EffectId, Algo::LowerBound(EffectIds, EffectId));
+	MarkDirty(Index);
+}
+
+void FTCG_StatLayers::RemoveContribution(const int32 Index, const int32 EffectId)
+{
+	Cards[Index].EffectIds.RemoveSingle(EffectId);
+	MarkDirty(Index);
+}
+
+void FTCG_StatLayers::CountChange()
+{
+	Stats.NaiveRecomputes += RegisteredNum;
+}
+
+void FTCG_StatLayers::Recompute(FCardStats& Card)
+{
+	Card.Attack = Card.BaseAttack;
+	Card.HitPoint = Card.BaseHitPoint;
+	ApplyLayers(Card.EffectIds, Card.Attack, Card.HitPoint);
+	Card.bDirty = false;
+	Stats.Recomputes++;
+}
+
+void FTCG_StatLayers::ComputeFull(const int32 Index, int32& OutAttack, 
+	int32& OutHitPoint) const
+{
+	FTCG_CardHandle Handle;
+	Handle.Index = Index;
+
+	TArray<int32, TInlineAllocator<8>> EffectIds;
+	for (const TPair<int32, FEffect>& Pair : Effects)
+	{
+		const FEffect& Effect = Pair.Value;
+		const bool bTargeted = Effect.bAura ? 
+			Effect.Query.Matches(Handle) : Effect.Targets.Contains(Index);
+		if (bTargeted)
+		{
+			EffectIds.Add(Pair.Key);
+		}
+	}
+	EffectIds.Sort();
+
+	OutAttack = Cards[Index].BaseAttack;
+	OutHitPoint = Cards[Index].BaseHitPoint;
+	ApplyLayers(EffectIds, OutAttack, OutHitPoint);
+}
+
+void FTCG_StatLayers::ApplyLayers(TArrayView<const int32> EffectIds, 
+	int32& InOutAttack, int32& InOutHitPoint) const
+{
+	for (const ETCG_StatLayer Layer : 
+		{ ETCG_StatLayer::Set, ETCG_StatLayer::Modify, ETCG_StatLayer::Aura })
+	{
+		for (const int32 EffectId : EffectIds)
+		{
+			const FTCG_StatEffect& Effect = Effects.FindChecked(EffectId).Stat;
+			if (Effect.Layer != Layer)
+			{
+				continue;
+			}
+
+			if (Layer == ETCG_StatLayer::Set)
+			{
+				InOutAttack = Effect.Attack;
+				InOutHitPoint = Effect.HitPoint;
+			}
+			else
+			{
+				InOutAttack += Effect.Attack;
+				InOutHitPoint += Effect.HitPoint;
+			}
+		}
+	}
+}
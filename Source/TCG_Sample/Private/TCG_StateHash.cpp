@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_StateHash.h"
+
+void FTCG_StateHash::Reset()
+{
+	FMemory::Memzero(Partitions);
+	Recent.Reset();
+	RecentHead = 0;
+}
+
+void FTCG_StateHash::Toggle(const int32 Partition, const ETCG_HashKey Key, 
+	const int32 Slot, const int32 Value)
+{
+	if (Partition < 0 || Partition >= PartitionNum)
+	{
+		return;
+	}
+
+	Partitions[Partition][static_cast<int32>(Key)] ^= MakeKey(Key, Slot, Value);
+
+	FMutation Mutation;
+	Mutation.Key = Key;
+	Mutation.Partition = Partition;
+	Mutation.Slot = Slot;
+	Mutation.Value = Value;
+	Mutation.Result = Get(Partition);
+	if (Recent.Num() < RecentNum)
+	{
+		Recent.Add(Mutation);
+	}
+	else
+	{
+		Recent[RecentHead] = Mutation;
+	}
+	RecentHead = (RecentHead + 1) % RecentNum;
+}
+
+void FTCG_StateHash::Update(const int32 Partition, const ETCG_HashKey Key, 
+	const int32 Slot, const int32 OldValue, const int32 NewValue)
+{
+	if (OldValue == NewValue)
+	{
+		return;
+	}
+
+	Toggle(Partition, Key, Slot, OldValue);
+	Toggle(Partition, Key, Slot, NewValue);
+}
+
+uint64 FTCG_StateHash::Get(const int32 Partition, const uint32 KeyMask) const
+{
+	if (Partition < 0 || Partition >= PartitionNum)
+	{
+		return 0;
+	}
+
+	uint64 Result = 0;
+	for (int32 Key = 0; Key < KeyNum; Key++)
+	{
+		if (KeyMask & (1u << Key))
+		{
+			Result ^= Partitions[Partition][Key];
+		}
+	}
+	return Result;
+}
+
+uint64 FTCG_StateHash::GetPlayerView(const int32 PlayerIndex, const uint32 KeyMask) const
+{
+	return Get(SharedPartition, KeyMask) ^ Get(PlayerIndex, KeyMask);
+}
+
+void FTCG_StateHash::Dump(const FString& Context) const
+{
+	UE_LOG(LogTemp, Warning, TEXT("State hash dump (%s)"), *Context);
+	for (int32 Partition = 0; Partition < PartitionNum; Partition++)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("  Partition %d: %016llx"), 
+			Partition, Get(Partition));
+	}
+
+	// oldest first
+	for (int32 Offset = 0; Offset < Recent.Num(); Offset++)
+	{
+		const int32 Index = Recent.Num() < RecentNum ? 
+			Offset : (RecentHead + Offset) % RecentNum;
+		const FMutation& Mutation = Recent[Index];
+		UE_LOG(LogTemp, Warning, TEXT("  [%d] key %d partition %d slot %d value %d -> %016llx"),
+			Offset, static_cast<int32>(Mutation.Key), Mutation.Partition, 
+			Mutation.Slot, Mutation.Value, Mutation.Result);
+	}
+}
+
+static uint64 MixBits(uint64 Z)
+{
+	// splitmix64 finalizer
+	Z += 0x9E3779B97F4A7C15ull;
+	Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+	return Z ^ (Z >> 31);
+}
+
+uint64 FTCG_StateHash::MakeKey(const ETCG_HashKey Key, const int32 Slot, const int32 Value)
+{
+	// stands in for a random table, which would need a row for every hitpoint
+	const uint64 SlotKey = MixBits((static_cast<uint64>(Key) << 32) 
+		| static_cast<uint32>(Slot));
+	return MixBits(SlotKey ^ static_cast<uint32>(Value));
+}
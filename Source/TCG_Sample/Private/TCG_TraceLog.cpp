@@ -0,0 +1,446 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_TraceLog.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+std::atomic<bool> FTCG_TraceLog::bRunning(false);
+
+static TAutoConsoleVariable<float> CVarTraceFlushInterval(
+	TEXT("tcg.Trace.FlushInterval"),
+	0.05f,
+	TEXT("Seconds between writes of the trace ring buffers to the file"));
+
+static FAutoConsoleCommand TraceStartCommand(
+	TEXT("tcg.Trace.Start"),
+	TEXT("Starts recording hot path events to a .tcgtrace file, optionally at the given path"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FTCG_TraceLog::Start(Args.Num() > 0 ? Args[0] : FString());
+	}));
+
+static FAutoConsoleCommand TraceStopCommand(
+	TEXT("tcg.Trace.Stop"),
+	TEXT("Stops recording and closes the trace file"),
+	FConsoleCommandDelegate::CreateStatic(&FTCG_TraceLog::Stop));
+
+static FAutoConsoleCommand TraceDecodeCommand(
+	TEXT("tcg.Trace.Decode"),
+	TEXT("Writes a .tcgtrace file as text, e.g. tcg.Trace.Decode Saved/Logs/TCG.tcgtrace [out.log]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.Num() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("tcg.Trace.Decode needs a trace file"));
+			return;
+		}
+		FTCG_TraceLog::Decode(Args[0], Args.Num() > 1 ? Args[1] : FString());
+	}));
+
+namespace
+{
+	constexpr uint32 TraceMagic = 0x54474354;
+	constexpr uint32 TraceVersion = 1;
+	// power of two, about 400 KB per thread that traces
+	constexpr uint64 RingCapacity = 8192;
+
+	enum class ETraceChunk : uint8
+	{
+		Event,
+		Name,
+		Records,
+		End
+	};
+
+	// single producer, the owning thread, and single consumer, the writer
+	struct FThreadBuffer
+	{
+		uint32 ThreadId = 0;
+		std::atomic<uint64> Head{0};
+		std::atomic<uint64> Tail{0};
+		std::atomic<uint64> Dropped{0};
+		FTCG_TraceRecord Records[RingCapacity];
+	};
+
+	struct FEventInfo
+	{
+		FString Name;
+		FString Format;
+	};
+
+	// buffers live until exit, a thread only registers on its first write
+	FCriticalSection BuffersLock;
+	TArray<TUniquePtr<FThreadBuffer>> Buffers;
+	thread_local FThreadBuffer* LocalBuffer = nullptr;
+
+	FCriticalSection EventsLock;
+	TArray<FEventInfo> Events;
+
+	FThreadBuffer* GetLocalBuffer()
+	{
+		if (!LocalBuffer)
+		{
+			TUniquePtr<FThreadBuffer> Buffer = MakeUnique<FThreadBuffer>();
+			Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+			LocalBuffer = Buffer.Get();
+
+			FScopeLock Lock(&BuffersLock);
+			Buffers.Add(MoveTemp(Buffer));
+		}
+		return LocalBuffer;
+	}
+
+	void SerializeRecord(FArchive& Ar, FTCG_TraceRecord& Record)
+	{
+		Ar << Record.Cycles;
+		Ar << Record.EventId;
+		for (int32 Index = 0; Index < FTCG_TraceRecord::MaxFields; Index++)
+		{
+			uint8 Type = static_cast<uint8>(Record.FieldTypes[Index]);
+			Ar << Type;
+			Record.FieldTypes[Index] = static_cast<ETCG_TraceField>(Type);
+			if (Record.FieldTypes[Index] != ETCG_TraceField::None)
+			{
+				// both members are 8 bytes, floats travel as their bits
+				Ar << Record.Fields[Index].Int;
+			}
+		}
+	}
+
+	class FTraceWriter : public FRunnable
+	{
+	public:
+		explicit FTraceWriter(FArchive* InAr)
+			: Ar(InAr)
+		{
+		}
+
+		virtual uint32 Run() override
+		{
+			while (!bStopping.load())
+			{
+				Flush();
+				FPlatformProcess::Sleep(CVarTraceFlushInterval.GetValueOnAnyThread());
+			}
+			Flush();
+			return 0;
+		}
+
+		virtual void Stop() override
+		{
+			bStopping.store(true);
+		}
+
+		// after the thread has exited
+		void Close()
+		{
+			uint8 Chunk = static_cast<uint8>(ETraceChunk::End);
+			*Ar << Chunk;
+			Ar->Close();
+		}
+
+	private:
+		void Flush()
+		{
+			// definitions registered since the last flush go first
+			{
+				FScopeLock Lock(&EventsLock);
+				for (; EventsWritten < Events.Num(); EventsWritten++)
+				{
+					uint8 Chunk = static_cast<uint8>(ETraceChunk::Event);
+					uint16 EventId = static_cast<uint16>(EventsWritten);
+					*Ar << Chunk << EventId << Events[EventsWritten].Name << Events[EventsWritten].Format;
+				}
+			}
+
+			TArray<FThreadBuffer*> Snapshot;
+			{
+				FScopeLock Lock(&BuffersLock);
+				for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+				{
+					Snapshot.Add(Buffer.Get());
+				}
+			}
+
+			for (FThreadBuffer* Buffer : Snapshot)
+			{
+				const uint64 Head = Buffer->Head.load(std::memory_order_acquire);
+				uint64 Tail = Buffer->Tail.load(std::memory_order_relaxed);
+				if (Head == Tail)
+				{
+					continue;
+				}
+
+				Batch.Reset();
+				for (; Tail < Head; Tail++)
+				{
+					Batch.Add(Buffer->Records[Tail & (RingCapacity - 1)]);
+				}
+				Buffer->Tail.store(Tail, std::memory_order_release);
+
+				WriteNames();
+
+				uint8 Chunk = static_cast<uint8>(ETraceChunk::Records);
+				uint32 ThreadId = Buffer->ThreadId;
+				int32 Num = Batch.Num();
+				*Ar << Chunk << ThreadId << Num;
+				for (FTCG_TraceRecord& Record : Batch)
+				{
+					SerializeRecord(*Ar, Record);
+				}
+			}
+			Ar->Flush();
+		}
+
+		// each name is written once per file, before the first record using it
+		void WriteNames()
+		{
+			for (const FTCG_TraceRecord& Record : Batch)
+			{
+				for (int32 Index = 0; Index < FTCG_TraceRecord::MaxFields; Index++)
+				{
+					int64 Packed = Record.Fields[Index].Int;
+					if (Record.FieldTypes[Index] != ETCG_TraceField::Name || NamesWritten.Contains(Packed))
+					{
+						continue;
+					}
+					NamesWritten.Add(Packed);
+
+					uint8 Chunk = static_cast<uint8>(ETraceChunk::Name);
+					FString Name = FTCG_TraceRecord::UnpackName(Packed).ToString();
+					*Ar << Chunk << Packed << Name;
+				}
+			}
+		}
+
+		TUniquePtr<FArchive> Ar;
+		std::atomic<bool> bStopping{false};
+		int32 EventsWritten = 0;
+		TSet<int64> NamesWritten;
+		TArray<FTCG_TraceRecord> Batch;
+	};
+
+	// started and stopped from the game thread
+	TUniquePtr<FTraceWriter> Writer;
+	FRunnableThread* WriterThread = nullptr;
+	FString WriterPath;
+}
+
+bool FTCG_TraceLog::Start(const FString& Path)
+{
+	if (Writer)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Trace already recording to %s"), *WriterPath);
+		return false;
+	}
+
+	WriterPath = Path.IsEmpty() ? FPaths::ProjectLogDir() / FString::Printf(
+		TEXT("TCG_%s.tcgtrace"), *FDateTime::Now().ToString()) : Path;
+	FArchive* Ar = IFileManager::Get().CreateFileWriter(*WriterPath);
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Trace file %s not opened"), *WriterPath);
+		return false;
+	}
+
+	uint32 Magic = TraceMagic;
+	uint32 Version = TraceVersion;
+	double SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	*Ar << Magic << Version << SecondsPerCycle << StartCycles;
+
+	// records left over from an earlier trace belong to that file
+	{
+		FScopeLock Lock(&BuffersLock);
+		for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+		{
+			Buffer->Tail.store(Buffer->Head.load(std::memory_order_acquire), std::memory_order_release);
+			Buffer->Dropped.store(0);
+		}
+	}
+
+	Writer = MakeUnique<FTraceWriter>(Ar);
+	WriterThread = FRunnableThread::Create(Writer.Get(), TEXT("TCG_TraceWriter"), 0, TPri_BelowNormal);
+	bRunning.store(true);
+
+	UE_LOG(LogTemp, Log, TEXT("Trace recording to %s"), *WriterPath);
+	return true;
+}
+
+void FTCG_TraceLog::Stop()
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	bRunning.store(false);
+	WriterThread->Kill(true);
+	delete WriterThread;
+	WriterThread = nullptr;
+	Writer->Close();
+	Writer.Reset();
+
+	uint64 Dropped = 0;
+	{
+		FScopeLock Lock(&BuffersLock);
+		for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+		{
+			Dropped += Buffer->Dropped.load();
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("Trace written to %s, %llu records dropped"), *WriterPath, Dropped);
+}
+
+uint16 FTCG_TraceLog::RegisterEvent(const TCHAR* Name, const TCHAR* Format)
+{
+	FScopeLock Lock(&EventsLock);
+	const int32 Existing = Events.IndexOfByPredicate([Name](const FEventInfo& Event)
+		{
+			return Event.Name == Name;
+		});
+	if (Existing != INDEX_NONE)
+	{
+		return static_cast<uint16>(Existing);
+	}
+	return static_cast<uint16>(Events.Add({ Name, Format }));
+}
+
+void FTCG_TraceLog::Push(FTCG_TraceRecord& Record)
+{
+	Record.Cycles = FPlatformTime::Cycles64();
+
+	FThreadBuffer* Buffer = GetLocalBuffer();
+	const uint64 Head = Buffer->Head.load(std::memory_order_relaxed);
+	if (Head - Buffer->Tail.load(std::memory_order_acquire) >= RingCapacity)
+	{
+		Buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	Buffer->Records[Head & (RingCapacity - 1)] = Record;
+	Buffer->Head.store(Head + 1, std::memory_order_release);
+}
+
+bool FTCG_TraceLog::Decode(const FString& Path, const FString& OutPath)
+{
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*Path));
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Trace file %s not found"), *Path);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	double SecondsPerCycle = 0.0;
+	uint64 StartCycles = 0;
+	*Ar << Magic << Version;
+	if (Magic != TraceMagic || Version != TraceVersion)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s isn't a version %u trace"), *Path, TraceVersion);
+		return false;
+	}
+	*Ar << SecondsPerCycle << StartCycles;
+
+	TMap<uint16, FEventInfo> EventInfos;
+	TMap<int64, FString> Names;
+	TArray<TPair<uint64, FString>> Lines;
+	bool bEnded = false;
+	while (!bEnded && !Ar->AtEnd() && !Ar->IsError())
+	{
+		uint8 Chunk = 0;
+		*Ar << Chunk;
+		switch (static_cast<ETraceChunk>(Chunk))
+		{
+		case ETraceChunk::Event:
+		{
+			uint16 EventId = 0;
+			FEventInfo Event;
+			*Ar << EventId << Event.Name << Event.Format;
+			EventInfos.Add(EventId, MoveTemp(Event));
+			break;
+		}
+		case ETraceChunk::Name:
+		{
+			int64 Packed = 0;
+			FString Name;
+			*Ar << Packed << Name;
+			Names.Add(Packed, MoveTemp(Name));
+			break;
+		}
+		case ETraceChunk::Records:
+		{
+			uint32 ThreadId = 0;
+			int32 Num = 0;
+			*Ar << ThreadId << Num;
+			for (int32 Index = 0; Index < Num && !Ar->IsError(); Index++)
+			{
+				FTCG_TraceRecord Record;
+				SerializeRecord(*Ar, Record);
+
+				FStringFormatOrderedArguments Args;
+				for (int32 Field = 0; Field < FTCG_TraceRecord::MaxFields; Field++)
+				{
+					switch (Record.FieldTypes[Field])
+					{
+					case ETCG_TraceField::Int:
+						Args.Add(Record.Fields[Field].Int);
+						break;
+					case ETCG_TraceField::Float:
+						Args.Add(Record.Fields[Field].Float);
+						break;
+					case ETCG_TraceField::Name:
+						Args.Add(Names.FindRef(Record.Fields[Field].Int));
+						break;
+					default:
+						break;
+					}
+				}
+
+				const FEventInfo* Event = EventInfos.Find(Record.EventId);
+				const double Seconds = static_cast<int64>(Record.Cycles - StartCycles) * SecondsPerCycle;
+				Lines.Emplace(Record.Cycles, FString::Printf(TEXT("[%.6f][%u] %s: %s"), Seconds, ThreadId,
+					Event ? *Event->Name : TEXT("Unknown"),
+					Event ? *FString::Format(*Event->Format, Args) : TEXT("")));
+			}
+			break;
+		}
+		case ETraceChunk::End:
+			bEnded = true;
+			break;
+		default:
+			UE_LOG(LogTemp, Warning, TEXT("%s is corrupt after %d records"), *Path, Lines.Num());
+			return false;
+		}
+	}
+
+	// threads are flushed one after another, the log reads in time order
+	Lines.StableSort([](const TPair<uint64, FString>& A, const TPair<uint64, FString>& B)
+		{
+			return A.Key < B.Key;
+		});
+
+	FString Text;
+	for (const TPair<uint64, FString>& Line : Lines)
+	{
+		Text += Line.Value;
+		Text += LINE_TERMINATOR;
+	}
+
+	const FString FilePath = OutPath.IsEmpty() ? FPaths::ChangeExtension(Path, TEXT("log")) : OutPath;
+	if (!FFileHelper::SaveStringToFile(Text, *FilePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Decoded trace not written to %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Decoded %d trace records to %s%s"), Lines.Num(), *FilePath,
+		bEnded ? TEXT("") : TEXT(", the trace wasn't stopped cleanly"));
+	return true;
+}
@@ -0,0 +1,556 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_ZoneQuery.h"
+#include "TCG_CardDatabase.h"
+#include "TCG_StatLayers.h"
+
+template <typename EnumType>
+static int32 GetEnumCount()
+{
+	// NumEnums includes the generated _MAX entry
+	return StaticEnum<EnumType>()->NumEnums() - 1;
+}
+
+void FTCG_ZoneIndex::Init(const int32 InMaxCards)
+{
+	const FTCG_CardBitset Empty(InMaxCards);
+
+	CardNum = 0;
+	for (int32& OwnerCardNum : OwnerCardNums)
+	{
+		OwnerCardNum = 0;
+	}
+	All = Empty;
+	ByZone.Init(Empty, GetEnumCount<ECardZone>());
+	ByOwner.Init(Empty, MaxPlayers);
+	ByCardType.Init(Empty, GetEnumCount<ECardType>());
+	ByRarity.Init(Empty, GetEnumCount<ERarity>());
+	ByManaType.Init(Empty, GetEnumCount<EManaType>());
+	AttackAtLeast.Init(Empty, NumStatBuckets);
+	HitPointAtLeast.Init(Empty, NumStatBuckets);
+
+	Zones.Init(ECardZone::Library, InMaxCards);
+	Owners.Init(0, InMaxCards);
+	CardIds.Init(0, InMaxCards);
+	Attacks.Init(0, InMaxCards);
+	HitPoints.Init(0, InMaxCards);
+}
+
+FTCG_CardHandle FTCG_ZoneIndex::Register(const FTCG_CardEntry& Entry, 
+	const int32 OwnerIndex, const ECardZone Zone)
+{
+	FTCG_CardHandle Handle;
+	const int32 OwnerCapacity = All.Num() / MaxPlayers;
+	if (OwnerIndex < 0 || OwnerIndex >= MaxPlayers || 
+		OwnerCardNums[OwnerIndex] >= OwnerCapacity)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Can't register card %d in the zone index"), 
+			Entry.CardId);
+		return Handle;
+	}
+
+	Handle.Index = OwnerIndex * OwnerCapacity + OwnerCardNums[OwnerIndex]++;
+	CardNum++;
+	const int32 Index = Handle.Index;
+
+	All.Set(Index);
+	Zones[Index] = Zone;
+	ByZone[static_cast<int32>(Zone)].Set(Index);
+	Owners[Index] = OwnerIndex;
+	CardIds[Index] = Entry.CardId;
+	ByOwner[OwnerIndex].Set(Index);
+	ByCardType[static_cast<int32>(Entry.CardType)].Set(Index);
+	ByRarity[static_cast<int32>(Entry.Rarity)].Set(Index);
+
+	if (Entry.CardType == ECardType::Mana)
+	{
+		ByManaType[static_cast<int32>(Entry.ManaType)].Set(Index);
+	}
+	for (const FManaCost& Option : Entry.Costs)
+	{
+		for (const TPair<EManaType, int32>& Cost : Option.Cost)
+		{
+			if (Cost.Value > 0)
+			{
+				ByManaType[static_cast<int32>(Cost.Key)].Set(Index);
+			}
+		}
+	}
+
+	SetStats(Handle, Entry.Attack, Entry.HitPoint);
+	return Handle;
+}
+
+void FTCG_ZoneIndex::MoveCard(const FTCG_CardHandle Handle, const ECardZone Zone)
+{
+	if (!IsRegistered(Handle))
+	{
+		return;
+	}
+
+	ByZone[static_cast<int32>(Zones[Handle.Index])].Clear(Handle.Index);
+	ByZone[static_cast<int32>(Zone)].Set(Handle.Index);
+	Zones[Handle.Index] = Zone;
+}
+
+void FTCG_ZoneIndex::SetStats(const FTCG_CardHandle Handle, const int32 Attack, 
+	const int32 HitPoint)
+{
+	if (!IsRegistered(Handle))
+	{
+		return;
+	}
+
+	Attacks[Handle.Index] = Attack;
+	HitPoints[Handle.Index] = HitPoint;
+	SetStatBits(AttackAtLeast, Handle.Index, Attack);
+	SetStatBits(HitPointAtLeast, Handle.Index, HitPoint);
+}
+
+void FTCG_ZoneIndex::Reset()
+{
+	CardNum = 0;
+	for (int32& OwnerCardNum : OwnerCardNums)
+	{
+		OwnerCardNum = 0;
+	}
+	All.Reset();
+	for (TArray<FTCG_CardBitset, FTCG_ArenaAllocator>* Group : 
+		{ &ByZone, &ByOwner, &ByCardType, &ByRarity, &ByManaType, 
+		  &AttackAtLeast, &HitPointAtLeast })
+	{
+		for (FTCG_CardBitset& Bits : *Group)
+		{
+			Bits.Reset();
+		}
+	}
+}
+
+void FTCG_ZoneIndex::FlushPendingStats() const
+{
+	if (StatLayers)
+	{
+		StatLayers->FlushToZoneIndex();
+	}
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetZoneBits(const ECardZone Zone) const
+{
+	return ByZone[static_cast<int32>(Zone)];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetOwnerBits(const int32 OwnerIndex) const
+{
+	check(OwnerIndex >= 0 && OwnerIndex < MaxPlayers);
+	return ByOwner[OwnerIndex];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetCardTypeBits(const ECardType CardType) const
+{
+	return ByCardType[static_cast<int32>(CardType)];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetRarityBits(const ERarity Rarity) const
+{
+	return ByRarity[static_cast<int32>(Rarity)];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetManaTypeBits(const EManaType ManaType) const
+{
+	return ByManaType[static_cast<int32>(ManaType)];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetAttackAtLeast(const int32 Value) const
+{
+	return AttackAtLeast[ToBucket(Value)];
+}
+
+const FTCG_CardBitset& FTCG_ZoneIndex::GetHitPointAtLeast(const int32 Value) const
+{
+	return HitPointAtLeast[ToBucket(Value)];
+}
+
+int32 FTCG_ZoneIndex::ToBucket(const int32 Value)
+{
+	return FMath::Clamp(Value, 0, NumStatBuckets - 1);
+}
+
+void FTCG_ZoneIndex::SetStatBits(TArray<FTCG_CardBitset, FTCG_ArenaAllocator>& Buckets, const int32 Index, 
+	const int32 Value)
+{
+	const int32 Top = ToBucket(Value);
+	for (int32 Bucket = 0; Bucket < Buckets.Num(); Bucket++)
+	{
+		if (Bucket <= Top)
+		{
+			Buckets[Bucket].Set(Index);
+		}
+		else
+		{
+			Buckets[Bucket].Clear(Index);
+		}
+	}
+}
+
+FTCG_CardQuery& FTCG_CardQuery::InZone(const ECardZone Zone)
+{
+	Zones.AddUnique(Zone);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::OwnedBy(const int32 OwnerIndex)
+{
+	OwnerIndices.AddUnique(OwnerIndex);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::OfType(const ECardType CardType)
+{
+	CardTypes.AddUnique(CardType);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::OfRarity(const ERarity Rarity)
+{
+	Rarities.AddUnique(Rarity);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::WithManaType(const EManaType ManaType)
+{
+	ManaTypes.AddUnique(ManaType);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::AttackAtLeast(const int32 Value)
+{
+	MinAttack = FMath::Max(MinAttack, Value);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::AttackAtMost(const int32 Value)
+{
+	MaxAttack = FMath::Min(MaxAttack, Value);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::HitPointAtLeast(const int32 Value)
+{
+	MinHitPoint = FMath::Max(MinHitPoint, Value);
+	return *this;
+}
+
+FTCG_CardQuery& FTCG_CardQuery::HitPointAtMost(const int32 Value)
+{
+	MaxHitPoint = FMath::Min(MaxHitPoint, Value);
+	return *this;
+}
+
+template <typename EnumType>
+static bool ParseEnumValue(const FString& Text, EnumType& OutValue)
+{
+	const int64 Value = StaticEnum<EnumType>()->GetValueByNameString(Text);
+	if (Value == INDEX_NONE)
+	{
+		return false;
+	}
+	OutValue = static_cast<EnumType>(Value);
+	return true;
+}
+
+bool FTCG_CardQuery::Parse(const FString& Text, FTCG_CardQuery& OutQuery, 
+	FString& OutError)
+{
+	TArray<FString> Tokens;
+	Text.ParseIntoArrayWS(Tokens);
+
+	for (const FString& Token : Tokens)
+	{
+		FString Key;
+		FString Value;
+		FString Operator;
+		for (const TCHAR* Candidate : { TEXT(">="), TEXT("<="), TEXT(":") })
+		{
+			if (Token.Split(Candidate, &Key, &Value))
+			{
+				Operator = Candidate;
+				break;
+			}
+		}
+		Key.ToLowerInline();
+
+		bool bValid = !Operator.IsEmpty();
+		if (bValid && Operator == TEXT(":"))
+		{
+			if (Key == TEXT("zone"))
+			{
+				ECardZone Zone;
+				bValid = ParseEnumValue(Value, Zone);
+				if (bValid) OutQuery.InZone(Zone);
+			}
+			else if (Key == TEXT("owner"))
+			{
+				const int32 Owner = FCString::Atoi(*Value);
+				bValid = Value.IsNumeric() && Owner >= 0 && Owner < FTCG_ZoneIndex::MaxPlayers;
+				if (bValid) OutQuery.OwnedBy(Owner);
+			}
+			else if (Key == TEXT("type"))
+			{
+				ECardType CardType;
+				bValid = ParseEnumValue(Value, CardType);
+				if (bValid) OutQuery.OfType(CardType);
+			}
+			else if (Key == TEXT("rarity"))
+			{
+				ERarity Rarity;
+				bValid = ParseEnumValue(Value, Rarity);
+				if (bValid) OutQuery.OfRarity(Rarity);
+			}
+			else if (Key == TEXT("mana"))
+			{
+				EManaType ManaType;
+				bValid = ParseEnumValue(Value, ManaType);
+				if (bValid) OutQuery.WithManaType(ManaType);
+			}
+			else
+			{
+				bValid = false;
+			}
+		}
+		else if (bValid)
+		{
+			const bool bAtLeast = Operator == TEXT(">=");
+			const int32 Number = FCString::Atoi(*Value);
+			bValid = Value.IsNumeric();
+			if (bValid && Key == TEXT("attack"))
+			{
+				bAtLeast ? OutQuery.AttackAtLeast(Number) : OutQuery.AttackAtMost(Number);
+			}
+			else if (bValid && (Key == TEXT("hp") || Key == TEXT("hitpoint")))
+			{
+				bAtLeast ? OutQuery.HitPointAtLeast(Number) : OutQuery.HitPointAtMost(Number);
+			}
+			else
+			{
+				bValid = false;
+			}
+		}
+
+		if (!bValid)
+		{
+			OutError = FString::Printf(TEXT("Can't parse query term '%s'"), *Token);
+			return false;
+		}
+	}
+	return (!bRecheckAttack && !bRecheckHitPoint) || PassesExactStats(Handle.Index);
+}
+
+FTCG_CompiledQuery::FTCG_CompiledQuery(const FTCG_CardQuery& Query, 
+	const FTCG_ZoneIndex& InIndex)
+	: Index(&InIndex)
+{
+	// a clamped owner would silently match another player's cards
+	for (const int32 Owner : Query.OwnerIndices)
+	{
+		if (Owner < 0 || Owner >= FTCG_ZoneIndex::MaxPlayers)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Query names owner %d, the zone index has %d players"), 
+				Owner, FTCG_ZoneIndex::MaxPlayers);
+			bInvalid = true;
+		}
+	}
+	if (bInvalid)
+	{
+		bEmpty = true;
+		return;
+	}
+
+	// keeps unregistered slots and negated terms inside the match cards
+	AddTerm(InIndex.GetAll());
+
+	AddFacet(Query.Zones, [&InIndex](const ECardZone Zone) -> const FTCG_CardBitset& 
+		{ 
+			return InIndex.GetZoneBits(Zone); 
+		});
+	AddFacet(Query.OwnerIndices, [&InIndex](const int32 Owner) -> const FTCG_CardBitset& 
+		{ 
+			return InIndex.GetOwnerBits(Owner); 
+		});
+	AddFacet(Query.CardTypes, [&InIndex](const ECardType Type) -> const FTCG_CardBitset& 
+		{ 
+			return InIndex.GetCardTypeBits(Type); 
+		});
+	AddFacet(Query.Rarities, [&InIndex](const ERarity Rarity) -> const FTCG_CardBitset& 
+		{ 
+			return InIndex.GetRarityBits(Rarity); 
+		});
+	AddFacet(Query.ManaTypes, [&InIndex](const EManaType Mana) -> const FTCG_CardBitset& 
+		{ 
+			return InIndex.GetManaTypeBits(Mana); 
+		});
+
+	const int32 LastBucket = FTCG_ZoneIndex::NumStatBuckets - 1;
+	bEmpty = Query.MinAttack > Query.MaxAttack || Query.MinHitPoint > Query.MaxHitPoint;
+	MinAttack = Query.MinAttack;
+	MaxAttack = Query.MaxAttack;
+	MinHitPoint = Query.MinHitPoint;
+	MaxHitPoint = Query.MaxHitPoint;
+	// the last bucket only says "at least LastBucket", bounds past it need the exact stat
+	bRecheckAttack = MinAttack > LastBucket || (MaxAttack >= LastBucket && MaxAttack != MAX_int32);
+	bRecheckHitPoint = MinHitPoint > LastBucket || 
+		(MaxHitPoint >= LastBucket && MaxHitPoint != MAX_int32);
+	bReadsStats = MinAttack > 0 || MaxAttack < LastBucket || MinHitPoint > 0 || 
+		MaxHitPoint < LastBucket || bRecheckAttack || bRecheckHitPoint;
+	if (Query.MinAttack > 0)
+	{
+		AddTerm(InIndex.GetAttackAtLeast(Query.MinAttack));
+	}
+	if (Query.MaxAttack < LastBucket)
+	{
+		AddTerm(InIndex.GetAttackAtLeast(Query.MaxAttack + 1), true);
+	}
+	if (Query.MinHitPoint > 0)
+	{
+		AddTerm(InIndex.GetHitPointAtLeast(Query.MinHitPoint));
+	}
+	if (Query.MaxHitPoint < LastBucket)
+	{
+		AddTerm(InIndex.GetHitPointAtLeast(Query.MaxHitPoint + 1), true);
+	}
+}
+
+bool FTCG_CompiledQuery::Matches(const FTCG_CardHandle Handle) const
+{
+	if (bEmpty || !Index || !Handle.IsValid() || Handle.Index >= Index->GetCapacity())
+	{
+		return false;
+	}
+	if (bReadsStats)
+	{
+		Index->FlushPendingStats();
+	}
+
+	const int32 WordIndex = Handle.Index >> 6;
+	const uint64 Bit = 1ull << (Handle.Index & 63);
+	for (const FTerm& Term : Terms)
+	{
+		if ((Term.GetWord(WordIndex) & Bit) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FTCG_CompiledQuery::Evaluate(FTCG_CardBitset& OutResult) const
+{
+	OutResult.Init(Index ? Index->GetCapacity() : 0);
+	if (bEmpty || !Index)
+	{
+		return;
+	}
+	if (bReadsStats)
+	{
+		Index->FlushPendingStats();
+	}
+
+	const int32 WordNum = OutResult.GetWords().Num();
+	for (int32 WordIndex = 0; WordIndex < WordNum; WordIndex++)
+	{
+		uint64 Word = ~0ull;
+		for (const FTerm& Term : Terms)
+		{
+			Word &= Term.GetWord(WordIndex);
+		}
+		OutResult.SetWord(WordIndex, FilterTopBucket(WordIndex, Word));
+	}
+}
+
+int32 FTCG_CompiledQuery::Count() const
+{
+	if (bEmpty || !Index)
+	{
+		return 0;
+	}
+	if (bReadsStats)
+	{
+		Index->FlushPendingStats();
+	}
+
+	int32 Result = 0;
+	const int32 WordNum = Index->GetAll().GetWords().Num();
+	for (int32 WordIndex = 0; WordIndex < WordNum; WordIndex++)
+	{
+		uint64 Word = ~0ull;
+		for (const FTerm& Term : Terms)
+		{
+			Word &= Term.GetWord(WordIndex);
+		}
+		Result += FMath::CountBits(FilterTopBucket(WordIndex, Word));
+	}
+	return Result;
+}
+
+void FTCG_CompiledQuery::AddTerm(const FTCG_CardBitset& Bits, const bool bNegate)
+{
+	FTerm& Term = Terms.AddDefaulted_GetRef();
+	Term.AnyOf.Add(&Bits);
+	Term.bNegate = bNegate;
+}
+
+uint64 FTCG_CompiledQuery::FilterTopBucket(const int32 WordIndex, uint64 Word) const
+{
+	if (!bRecheckAttack && !bRecheckHitPoint)
+	{
+		return Word;
+	}
+
+	const int32 LastBucket = FTCG_ZoneIndex::NumStatBuckets - 1;
+	uint64 Candidates = 0;
+	if (bRecheckAttack)
+	{
+		Candidates |= Index->GetAttackAtLeast(LastBucket).GetWords()[WordIndex];
+	}
+	if (bRecheckHitPoint)
+	{
+		Candidates |= Index->GetHitPointAtLeast(LastBucket).GetWords()[WordIndex];
+	}
+
+	Candidates &= Word;
+	while (Candidates != 0)
+	{
+		const int32 Bit = static_cast<int32>(FMath::CountTrailingZeros64(Candidates));
+		Candidates &= Candidates - 1;
+		if (!PassesExactStats(WordIndex * 64 + Bit))
+		{
+			Word &= ~(1ull << Bit);
+		}
+	}
+	return Word;
+}
+
+bool FTCG_CompiledQuery::PassesExactStats(const int32 CardIndex) const
+{
+	FTCG_CardHandle Handle;
+	Handle.Index = CardIndex;
+	const int32 Attack = Index->GetAttack(Handle);
+	const int32 HitPoint = Index->GetHitPoint(Handle);
+	return Attack >= MinAttack && Attack <= MaxAttack && 
+		HitPoint >= MinHitPoint && HitPoint <= MaxHitPoint;
+}
+
+template <typename ValueType, typename GetterType>
+void FTCG_CompiledQuery::AddFacet(const TArray<ValueType>& Values, GetterType&& Getter)
+{
+	if (Values.Num() == 0)
+	{
+		return;
+	}
+
+	FTerm& Term = Terms.AddDefaulted_GetRef();
+	for (const ValueType& Value : Values)
+	{
+		Term.AnyOf.AddUnique(&Getter(Value));
+	}
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_MemoryTags.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTCG_MemoryTagsBudgetTest, "TCG.Memory.Budgets",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTCG_MemoryTagsBudgetTest::RunTest(const FString& Parameters)
+{
+	if (FTCG_MemoryTags::GetTotalBytes() < 0)
+	{
+		AddWarning(TEXT("Memory tag budgets need the low level memory tracker, run with -llm"));
+		return true;
+	}
+
+	// budgets of the current process, the perf match checks them again after a match
+	TestTrue(TEXT("Memory tags within budget"), FTCG_MemoryTags::CheckBudgets({}));
+	TestTrue(TEXT("TCG tag tracked"), FTCG_MemoryTags::GetTagBytes(TEXT("TCG")) >= 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,512 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CardBase.h"
+#include "Deck.h"
+#include "TCG_GameState.h"
+#include "TCG_MatchStats.h"
+#include "TCG_MemoryTags.h"
+#include "TCG_PlayerState.h"
+#include "CoreGlobals.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Tests/AutomationCommon.h"
+#include "UObject/UObjectArray.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Scripted end to end match for performance regression runs. It opens
+ * L_Testmap, plays a fixed match through the gameplay code (mulligan, a
+ * draw, damage and a card tween every turn, every phase in order) and
+ * samples frame and game thread time, memory, the change in live objects
+ * and net bytes. Each metric is compared with the baseline file, the test
+ * fails on a regression, on a metric missing from the baseline and when
+ * the baseline or the match itself is missing.
+ *
+ * TCG_Sample -game -nullrhi -nosound -unattended -TCGPerfTurns=10
+ *     -ExecCmds="Automation RunTests TCG.Perf.Match;Quit"
+ *     -TestExit="Automation Test Queue Empty"
+ * -TCGPerfBaseline=<csv> reads another baseline than Build/Perf/TCG_PerfBaseline.csv,
+ * -TCGPerfUpdateBaseline writes the measured values as the new baseline,
+ * -llm adds the TCG memory tags to the metrics and checks their budgets.
+ */
+
+static TAutoConsoleVariable<float> CVarPerfMatchTolerance(
+	TEXT("tcg.Perf.DefaultTolerance"),
+	0.1f,
+	TEXT("Allowed growth over the baseline for metrics without their own tolerance, 0.1 is 10%"));
+
+namespace
+{
+	const TCHAR* PerfMapName = TEXT("L_Testmap");
+	const TCHAR* PerfMapPath = TEXT("/Game/Maps/L_Testmap");
+	constexpr int32 OpeningHandSize = 7;
+	constexpr int32 MulliganNum = 2;
+	constexpr float TweenDuration = 0.25f;
+	constexpr float StepInterval = 0.05f;
+
+	double GetPercentile(TArray<double> Values, const double Percentile)
+	{
+		if (Values.Num() == 0)
+		{
+			return 0.0;
+		}
+		Values.Sort();
+		const int32 Index = FMath::Clamp(
+			FMath::FloorToInt32(Percentile * (Values.Num() - 1)), 0, Values.Num() - 1);
+		return Values[Index];
+	}
+
+	double GetAverage(const TArray<double>& Values)
+	{
+		double Total = 0.0;
+		for (const double Value : Values)
+		{
+			Total += Value;
+		}
+		return Values.Num() > 0 ? Total / Values.Num() : 0.0;
+	}
+
+	void GetNetBytes(const UWorld* World, uint64& OutIn, uint64& OutOut)
+	{
+		const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		OutIn = NetDriver ? NetDriver->InTotalBytes : 0;
+		OutOut = NetDriver ? NetDriver->OutTotalBytes : 0;
+	}
+
+	UWorld* FindGameWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) &&
+				Context.World())
+			{
+				return Context.World();
+			}
+		}
+		return nullptr;
+	}
+
+	ATCG_PlayerState* FindLocalPlayerState(const UWorld* World)
+	{
+		const APlayerController* Controller = World ? World->GetFirstPlayerController() : nullptr;
+		return Controller ? Controller->GetPlayerState<ATCG_PlayerState>() : nullptr;
+	}
+}
+
+// plays the match one step per update, then compares with the baseline
+class FTCG_PerfMatchCommand : public IAutomationLatentCommand
+{
+public:
+	explicit FTCG_PerfMatchCommand(FAutomationTestBase* InTest);
+
+	virtual bool Update() override;
+
+private:
+	struct FStep
+	{
+		FString Name;
+		TFunction<void()> Run;
+		// seconds to wait before the next step, e.g. for a tween to finish
+		float Wait = 0.0f;
+	};
+
+	struct FMetric
+	{
+		FString Name;
+		double Value = 0.0;
+	};
+
+	bool StartMatch(UWorld* World);
+	void BuildScript(ADeck* Deck);
+	void AnimateCard(ACardBase* Card, const int32 Slot);
+	void Sample();
+	void Finish(UWorld* World);
+
+	TArray<FMetric> CollectMetrics(UWorld* World) const;
+	// tolerance by metric, relative to the baseline value
+	bool LoadBaseline(TMap<FString, TPair<double, double>>& OutBaseline) const;
+	void SaveBaseline(const TArray<FMetric>& Metrics) const;
+
+	FAutomationTestBase* Test = nullptr;
+
+	FString BaselinePath;
+	int32 TurnNum = 10;
+	float WarmupSeconds = 2.0f;
+	float TimeoutSeconds = 300.0f;
+	bool bUpdateBaseline = false;
+
+	TArray<FStep> Steps;
+	int32 StepIndex = 0;
+	double NextStepTime = 0.0;
+	double StartTime = 0.0;
+	bool bRunning = false;
+	bool bAborted = false;
+
+	TArray<double> FrameTimes;
+	TArray<double> GameThreadTimes;
+	double NextMemorySampleTime = 0.0;
+	uint64 PeakUsedPhysical = 0;
+	int32 ObjectsAtStart = 0;
+	int64 TrackedBytesAtStart = 0;
+	uint64 NetInAtStart = 0;
+	uint64 NetOutAtStart = 0;
+
+	// level actors, they outlive the match
+	TArray<TWeakObjectPtr<ACardBase>> DrawnCards;
+};
+
+FTCG_PerfMatchCommand::FTCG_PerfMatchCommand(FAutomationTestBase* InTest)
+	: Test(InTest)
+{
+	const TCHAR* CommandLine = FCommandLine::Get();
+	BaselinePath = FPaths::ProjectDir() / TEXT("Build/Perf/TCG_PerfBaseline.csv");
+	FParse::Value(CommandLine, TEXT("TCGPerfBaseline="), BaselinePath);
+	FParse::Value(CommandLine, TEXT("TCGPerfTurns="), TurnNum);
+	FParse::Value(CommandLine, TEXT("TCGPerfWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("TCGPerfTimeout="), TimeoutSeconds);
+	bUpdateBaseline = FParse::Param(CommandLine, TEXT("TCGPerfUpdateBaseline"));
+	if (FPaths::IsRelative(BaselinePath))
+	{
+		BaselinePath = FPaths::ProjectDir() / BaselinePath;
+	}
+}
+
+bool FTCG_PerfMatchCommand::Update()
+{
+	if (GetCurrentRunTime() > TimeoutSeconds)
+	{
+		Test->AddError(FString::Printf(TEXT("Perf match timed out after %.0f s at step %d of %d"),
+			TimeoutSeconds, StepIndex, Steps.Num()));
+		return true;
+	}
+
+	UWorld* World = FindGameWorld();
+	if (!bRunning)
+	{
+		// the match starts once the map has loaded and warmed up
+		if (World && World->HasBegunPlay() && World->GetTimeSeconds() >= WarmupSeconds)
+		{
+			bRunning = StartMatch(World);
+		}
+		return bAborted;
+	}
+
+	Sample();
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now >= NextStepTime)
+	{
+		if (StepIndex >= Steps.Num())
+		{
+			Finish(World);
+			return true;
+		}
+
+		const FStep& Step = Steps[StepIndex++];
+		Step.Run();
+		NextStepTime = Now + FMath::Max(Step.Wait, StepInterval);
+	}
+	return false;
+}
+
+bool FTCG_PerfMatchCommand::StartMatch(UWorld* World)
+{
+	// scripted actions run on the authority, like a single player match
+	const ATCG_GameState* GameState = World->GetGameState<ATCG_GameState>();
+	if (!World->GetMapName().EndsWith(PerfMapName) || !GameState ||
+		World->GetNetMode() == NM_Client)
+	{
+		return false;
+	}
+
+	ADeck* Deck = GameState->FindDeck(0);
+	if (!Deck)
+	{
+		Test->AddError(FString::Printf(TEXT("Perf match found no deck for player 0 in %s"), PerfMapName));
+		bAborted = true;
+		return false;
+	}
+
+	BuildScript(Deck);
+
+	FTCG_MatchStats::BeginMatch(World);
+	FrameTimes.Reset();
+	GameThreadTimes.Reset();
+	PeakUsedPhysical = 0;
+	ObjectsAtStart = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	TrackedBytesAtStart = FTCG_MemoryTags::GetTotalBytes();
+	GetNetBytes(World, NetInAtStart, NetOutAtStart);
+
+	StartTime = FPlatformTime::Seconds();
+	NextStepTime = StartTime;
+	UE_LOG(LogTemp, Log, TEXT("Perf match started, %d steps over %d turns"), Steps.Num(), TurnNum);
+	return true;
+}
+
+void FTCG_PerfMatchCommand::BuildScript(ADeck* Deck)
+{
+	Steps.Reset();
+	StepIndex = 0;
+	DrawnCards.Reset();
+
+	TWeakObjectPtr<ADeck> WeakDeck = Deck;
+	auto RequestPhase = [this, WeakDeck](const EGamePhase Phase)
+	{
+		Steps.Add({ StaticEnum<EGamePhase>()->GetNameStringByValue(static_cast<int64>(Phase)),
+			[WeakDeck, Phase]()
+			{
+				if (ATCG_PlayerState* PlayerState = WeakDeck.IsValid() ?
+					FindLocalPlayerState(WeakDeck->GetWorld()) : nullptr)
+				{
+					PlayerState->RequestPhaseChange(Phase);
+				}
+			} });
+	};
+
+	RequestPhase(EGamePhase::Mulligan);
+	Steps.Add({ TEXT("OpeningHand"), [this, WeakDeck]()
+		{
+			for (int32 Index = 0; Index < OpeningHandSize && WeakDeck.IsValid(); Index++)
+			{
+				if (ACardBase* Card = WeakDeck->Draw())
+				{
+					AnimateCard(Card, DrawnCards.Add(Card));
+				}
+			}
+		}, TweenDuration });
+	Steps.Add({ TEXT("Mulligan"), [this, WeakDeck]()
+		{
+			TArray<TWeakObjectPtr<ACardBase>> Replacements;
+			for (int32 Index = 0; Index < MulliganNum && DrawnCards.Num() > 0 && WeakDeck.IsValid(); Index++)
+			{
+				ACardBase* Returned = DrawnCards.Pop().Get();
+				if (ACardBase* Card = Returned ? WeakDeck->Mulligan(Returned) : nullptr)
+				{
+					Replacements.Add(Card);
+				}
+			}
+			DrawnCards.Append(Replacements);
+		} });
+
+	for (int32 Turn = 0; Turn < TurnNum; Turn++)
+	{
+		RequestPhase(EGamePhase::PreTurnStart);
+		RequestPhase(EGamePhase::TurnStart);
+		Steps.Add({ TEXT("Draw"), [this, WeakDeck]()
+			{
+				if (ACardBase* Card = WeakDeck.IsValid() ? WeakDeck->Draw() : nullptr)
+				{
+					AnimateCard(Card, DrawnCards.Add(Card));
+				}
+			}, TweenDuration });
+		RequestPhase(EGamePhase::PostTurnStart);
+		RequestPhase(EGamePhase::TurnOngoing);
+		Steps.Add({ TEXT("Damage"), [WeakDeck]()
+			{
+				if (ATCG_PlayerState* PlayerState = WeakDeck.IsValid() ?
+					FindLocalPlayerState(WeakDeck->GetWorld()) : nullptr)
+				{
+					PlayerState->RequestDamage(1);
+				}
+			} });
+		RequestPhase(EGamePhase::PreTurnEnd);
+		RequestPhase(EGamePhase::TurnEnd);
+		RequestPhase(EGamePhase::PostTurnEnd);
+	}
+	RequestPhase(EGamePhase::GameEnd);
+}
+
+void FTCG_PerfMatchCommand::AnimateCard(ACardBase* Card, const int32 Slot)
+{
+	// a fanned row in front of the deck, the tween is what gets measured
+	const AActor* Deck = Card->GetOwner() ? Card->GetOwner() : Card;
+	const FVector Location = Deck->GetActorLocation() + FVector(200.0f, (Slot - 4) * 60.0f, 0.0f);
+	Card->MoveCardTo(Location, FRotator(0.0f, 0.0f, 180.0f), TweenDuration);
+}
+
+void FTCG_PerfMatchCommand::Sample()
+{
+	FrameTimes.Add(FApp::GetDeltaTime() * 1000.0);
+	GameThreadTimes.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	// reading the process stats isn't free, a few times a second is enough
+	const double Now = FPlatformTime::Seconds();
+	if (Now >= NextMemorySampleTime)
+	{
+		NextMemorySampleTime = Now + 0.5;
+		PeakUsedPhysical = FMath::Max<uint64>(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+	}
+}
+
+TArray<FTCG_PerfMatchCommand::FMetric> FTCG_PerfMatchCommand::CollectMetrics(UWorld* World) const
+{
+	uint64 NetIn = 0;
+	uint64 NetOut = 0;
+	GetNetBytes(World, NetIn, NetOut);
+
+	TArray<FMetric> Metrics;
+	Metrics.Add({ TEXT("FrameTimeAvgMs"), GetAverage(FrameTimes) });
+	Metrics.Add({ TEXT("FrameTimeP95Ms"), GetPercentile(FrameTimes, 0.95) });
+	Metrics.Add({ TEXT("GameThreadAvgMs"), GetAverage(GameThreadTimes) });
+	Metrics.Add({ TEXT("GameThreadP95Ms"), GetPercentile(GameThreadTimes, 0.95) });
+	Metrics.Add({ TEXT("PeakUsedPhysicalMB"), PeakUsedPhysical / (1024.0 * 1024.0) });
+	// objects alive now minus at the start, not every construction
+	Metrics.Add({ TEXT("ObjectCountDelta"),
+		static_cast<double>(GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsAtStart) });
+	Metrics.Add({ TEXT("NetInKB"), (NetIn - NetInAtStart) / 1024.0 });
+	Metrics.Add({ TEXT("NetOutKB"), (NetOut - NetOutAtStart) / 1024.0 });
+
+	// allocation growth of the tagged code, only with -llm
+	const int64 TrackedBytes = FTCG_MemoryTags::GetTotalBytes();
+	if (TrackedBytes >= 0 && TrackedBytesAtStart >= 0)
+	{
+		Metrics.Add({ TEXT("TaggedGrowthKB"), (TrackedBytes - TrackedBytesAtStart) / 1024.0 });
+	}
+	return Metrics;
+}
+
+void FTCG_PerfMatchCommand::Finish(UWorld* World)
+{
+	const ATCG_GameState* GameState = World ? World->GetGameState<ATCG_GameState>() : nullptr;
+	if (!GameState || GameState->GetGamePhase() != EGamePhase::GameEnd)
+	{
+		Test->AddError(TEXT("Perf match didn't reach the end of the game"));
+		return;
+	}
+
+	const TArray<FMetric> Metrics = CollectMetrics(World);
+	FTCG_MatchStats::ExportCsv(World);
+
+	// a full match is the soak, passes trivially without -llm
+	if (!FTCG_MemoryTags::CheckBudgets({}))
+	{
+		Test->AddError(TEXT("Memory tags over budget after the perf match"));
+	}
+
+	if (bUpdateBaseline)
+	{
+		SaveBaseline(Metrics);
+		return;
+	}
+
+	// without a baseline nothing can be compared, that isn't a pass
+	TMap<FString, TPair<double, double>> Baseline;
+	if (!LoadBaseline(Baseline))
+	{
+		Test->AddError(FString::Printf(TEXT("Perf baseline %s not found, run with -TCGPerfUpdateBaseline to write it"),
+			*BaselinePath));
+		return;
+	}
+
+	FString Csv = TEXT("Metric,Value,Baseline,Tolerance,Result\n");
+	int32 RegressionNum = 0;
+	for (const FMetric& Metric : Metrics)
+	{
+		const TPair<double, double>* Expected = Baseline.Find(Metric.Name);
+		FString Result = TEXT("Missing");
+		if (Expected)
+		{
+			// every metric is lower is better
+			const bool bRegressed = Metric.Value > Expected->Key * (1.0 + Expected->Value) &&
+				Metric.Value - Expected->Key > UE_KINDA_SMALL_NUMBER;
+			Result = bRegressed ? TEXT("Regressed") : TEXT("Ok");
+			RegressionNum += bRegressed ? 1 : 0;
+		}
+		else
+		{
+			Test->AddError(FString::Printf(TEXT("Perf metric %s isn't in the baseline"), *Metric.Name));
+		}
+
+		if (Result == TEXT("Regressed"))
+		{
+			Test->AddError(FString::Printf(TEXT("%s regressed: %.3f over baseline %.3f +%.0f%%"),
+				*Metric.Name, Metric.Value, Expected->Key, Expected->Value * 100.0));
+		}
+		UE_LOG(LogTemp, Log, TEXT("  %s: %.3f (baseline %.3f, +%.0f%%) %s"), *Metric.Name, Metric.Value,
+			Expected ? Expected->Key : 0.0, Expected ? Expected->Value * 100.0 : 0.0, *Result);
+		Csv += FString::Printf(TEXT("%s,%.4f,%.4f,%.3f,%s\n"), *Metric.Name, Metric.Value,
+			Expected ? Expected->Key : 0.0, Expected ? Expected->Value : 0.0, *Result);
+	}
+
+	const FString ResultPath = FPaths::ProfilingDir() / FString::Printf(
+		TEXT("TCG_PerfMatch_%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Csv, *ResultPath);
+
+	UE_LOG(LogTemp, Log, TEXT("Perf match finished in %.1f s, %d regressions, results in %s"),
+		FPlatformTime::Seconds() - StartTime, RegressionNum, *ResultPath);
+}
+
+bool FTCG_PerfMatchCommand::LoadBaseline(TMap<FString, TPair<double, double>>& OutBaseline) const
+{
+	FString Text;
+	if (!FFileHelper::LoadFileToString(Text, *BaselinePath))
+	{
+		return false;
+	}
+
+	TArray<FString> Lines;
+	Text.ParseIntoArrayLines(Lines);
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Columns;
+		Line.ParseIntoArray(Columns, TEXT(","));
+		if (Columns.Num() < 2 || Columns[0] == TEXT("Metric") || Line.StartsWith(TEXT("#")))
+		{
+			continue;
+		}
+
+		const double Tolerance = Columns.Num() > 2 ? FCString::Atod(*Columns[2]) :
+			CVarPerfMatchTolerance.GetValueOnGameThread();
+		OutBaseline.Add(Columns[0].TrimStartAndEnd(),
+			TPair<double, double>(FCString::Atod(*Columns[1]), Tolerance));
+	}
+	return OutBaseline.Num() > 0;
+}
+
+void FTCG_PerfMatchCommand::SaveBaseline(const TArray<FMetric>& Metrics) const
+{
+	// hand tuned tolerances survive a baseline update
+	TMap<FString, TPair<double, double>> Previous;
+	LoadBaseline(Previous);
+
+	FString Csv = TEXT("Metric,Value,Tolerance\n");
+	for (const FMetric& Metric : Metrics)
+	{
+		const TPair<double, double>* Old = Previous.Find(Metric.Name);
+		Csv += FString::Printf(TEXT("%s,%.4f,%.3f\n"), *Metric.Name, Metric.Value,
+			Old ? Old->Value : CVarPerfMatchTolerance.GetValueOnGameThread());
+	}
+
+	if (FFileHelper::SaveStringToFile(Csv, *BaselinePath))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Perf baseline written to %s"), *BaselinePath);
+	}
+	else
+	{
+		Test->AddError(FString::Printf(TEXT("Perf baseline not written to %s"), *BaselinePath));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTCG_PerfMatchTest, "TCG.Perf.Match",
+	EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FTCG_PerfMatchTest::RunTest(const FString& Parameters)
+{
+	AutomationOpenMap(PerfMapPath);
+	ADD_LATENT_AUTOMATION_COMMAND(FTCG_PerfMatchCommand(this));
+	return true;
+}
+
+#endif
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_CardDatabase.h"
+#include "TCG_StatLayers.h"
+#include "TCG_ZoneQuery.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTCG_StatLayersVerifyTest, "TCG.StatLayers.Verify",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTCG_StatLayersVerifyTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 MinionNum = 8;
+
+	FTCG_ZoneIndex ZoneIndex;
+	ZoneIndex.Init(64);
+	FTCG_StatLayers StatLayers;
+	StatLayers.Init(64, &ZoneIndex);
+
+	// attack 0..7, hitpoint 2, all on player 0's board
+	TArray<FTCG_CardHandle> Minions;
+	for (int32 Index = 0; Index < MinionNum; Index++)
+	{
+		FTCG_CardEntry Entry;
+		Entry.CardId = 100 + Index;
+		Entry.Attack = Index;
+		Entry.HitPoint = 2;
+		const FTCG_CardHandle Handle = ZoneIndex.Register(Entry, 0, ECardZone::Board);
+		StatLayers.SetBaseStats(Handle, Entry.Attack, Entry.HitPoint);
+		Minions.Add(Handle);
+	}
+
+	FTCG_CardQuery StrongQuery;
+	StrongQuery.AttackAtLeast(5);
+	const FTCG_CompiledQuery Strong(StrongQuery, ZoneIndex);
+
+	// changes only mark cards, the stat query is what recomputes them
+	StatLayers.ResetStats();
+	FTCG_StatEffect Buff;
+	Buff.Attack = 2;
+	const int32 BuffId = StatLayers.AddEffect(Buff, { Minions[0], Minions[1], Minions[2], Minions[3] });
+	TestEqual(TEXT("Recomputes before a read"), StatLayers.GetStats().Recomputes, 0);
+	// 2 3 4 5 4 5 6 7
+	TestEqual(TEXT("Attack >= 5 after the buff"), Strong.Count(), 4);
+	TestEqual(TEXT("Recomputes after the query"), StatLayers.GetStats().Recomputes, 8);
+	TestEqual(TEXT("Mismatches after the buff"), StatLayers.VerifyAll(), 0);
+
+	// a card read before the query still reaches the buckets
+	StatLayers.AddEffect(Buff, { Minions[0] });
+	TestEqual(TEXT("Attack >= 5 after a second buff"), Strong.Count(), 4);
+	StatLayers.AddEffect(Buff, { Minions[0] });
+	TestEqual(TEXT("Attack read"), StatLayers.GetAttack(Minions[0]), 6);
+	TestEqual(TEXT("Attack >= 5 after a read"), Strong.Count(), 5);
+
+	FTCG_CardQuery BoardQuery;
+	BoardQuery.InZone(ECardZone::Board).OwnedBy(0).OfType(ECardType::Minion);
+	FTCG_StatEffect Aura;
+	Aura.Layer = ETCG_StatLayer::Aura;
+	Aura.HitPoint = 1;
+	StatLayers.AddAura(Aura, FTCG_CompiledQuery(BoardQuery, ZoneIndex));
+
+	FTCG_StatEffect Silence;
+	Silence.Layer = ETCG_StatLayer::Set;
+	Silence.Attack = 1;
+	Silence.HitPoint = 1;
+	StatLayers.AddEffect(Silence, { Minions[7] });
+	TestEqual(TEXT("Mismatches after aura and set"), StatLayers.VerifyAll(), 0);
+	TestEqual(TEXT("Set then aura"), StatLayers.GetHitPoint(Minions[7]), 2);
+
+	// leaving the board drops the aura, removing the buff drops its attack
+	ZoneIndex.MoveCard(Minions[6], ECardZone::Graveyard);
+	StatLayers.RefreshAuras();
+	StatLayers.RemoveEffect(BuffId);
+	TestEqual(TEXT("Aura left with the card"), StatLayers.GetHitPoint(Minions[6]), 2);
+	// 4 1 2 3 4 5 6 1
+	TestEqual(TEXT("Attack >= 5 at the end"), Strong.Count(), 2);
+	TestEqual(TEXT("Mismatches at the end"), StatLayers.VerifyAll(), 0);
+	TestEqual(TEXT("Verify failures"), StatLayers.GetStats().VerifyFailures, 0);
+	return true;
+}
+
+#endif
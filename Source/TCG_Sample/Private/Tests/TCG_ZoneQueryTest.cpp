@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TCG_CardDatabase.h"
+#include "TCG_ZoneQuery.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTCG_ZoneQueryBoundsTest, "TCG.ZoneQuery.Bounds",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTCG_ZoneQueryBoundsTest::RunTest(const FString& Parameters)
+{
+	FTCG_ZoneIndex ZoneIndex;
+	ZoneIndex.Init(64);
+
+	// attack 14, 15, 20, 30 on player 0's board
+	for (const int32 Attack : { 14, 15, 20, 30 })
+	{
+		FTCG_CardEntry Entry;
+		Entry.CardId = 100 + Attack;
+		Entry.Attack = Attack;
+		Entry.HitPoint = 1;
+		ZoneIndex.Register(Entry, 0, ECardZone::Board);
+	}
+
+	auto CountOf = [&ZoneIndex](const TCHAR* Text)
+		{
+			FTCG_CardQuery Query;
+			FString Error;
+			return FTCG_CardQuery::Parse(Text, Query, Error) ?
+				FTCG_CompiledQuery(Query, ZoneIndex).Count() : INDEX_NONE;
+		};
+	TestEqual(TEXT("attack>=20"), CountOf(TEXT("attack>=20")), 2);
+	TestEqual(TEXT("attack<=15"), CountOf(TEXT("attack<=15")), 2);
+	TestEqual(TEXT("attack>=15 attack<=20"), CountOf(TEXT("attack>=15 attack<=20")), 2);
+	TestEqual(TEXT("attack>=31"), CountOf(TEXT("attack>=31")), 0);
+	TestEqual(TEXT("owner:0"), CountOf(TEXT("owner:0")), 4);
+	TestEqual(TEXT("owner:1"), CountOf(TEXT("owner:1")), 0);
+	TestEqual(TEXT("owner:5 is rejected"), CountOf(TEXT("owner:5")), INDEX_NONE);
+	TestEqual(TEXT("owner:-1 is rejected"), CountOf(TEXT("owner:-1")), INDEX_NONE);
+
+	AddExpectedError(TEXT("Query names owner"), EAutomationExpectedErrorFlags::Contains, 1);
+	FTCG_CardQuery Query;
+	Query.OwnedBy(5);
+	const FTCG_CompiledQuery Compiled(Query, ZoneIndex);
+	TestFalse(TEXT("Out of range owner compiles invalid"), Compiled.IsValid());
+	TestEqual(TEXT("Out of range owner matches nothing"), Compiled.Count(), 0);
+
+	FTCG_CardHandle Strongest;
+	Strongest.Index = 3;
+	FTCG_CardQuery Strong;
+	Strong.AttackAtLeast(20).AttackAtMost(25);
+	TestFalse(TEXT("Attack 30 doesn't match 20..25"),
+		FTCG_CompiledQuery(Strong, ZoneIndex).Matches(Strongest));
+	return true;
+}
+
+#endif
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "TCG_Definitions.h"
+#include "CardAssetStreamer.generated.h"
+
+/**
+ * Streams card art and meshes asynchronously, prioritized by the zone 
+ * the card is in. Loaded assets stay resident within an LRU byte budget.
+ */
+UCLASS()
+class TCG_SAMPLE_API UCardAssetStreamer : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// library and hidden opponent cards are never loaded
+	UFUNCTION(BlueprintCallable, Category = "CardAssets")
+	void RequestCardAssets(const FCardData& InCardData, const ECardZone Zone);
+
+	// background warm up before a match, below any zone request
+	void PrewarmCardAssets(const FCardData& InCardData);
+
+	// assets stay loaded but become the first to be evicted
+	UFUNCTION(BlueprintCallable, Category = "CardAssets")
+	void ReleaseCardAssets(const FCardData& InCardData);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "CardAssets")
+	int64 GetResidentBytes() const { return ResidentBytes; };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "CardAssets")
+	int32 GetPendingLoadNum() const { return PendingLoads; };
+
+	UFUNCTION(BlueprintCallable, Category = "CardAssets")
+	void ReportStats() const;
+
+	static int32 GetZonePriority(const ECardZone Zone);
+
+	// fired whenever the last pending load finishes
+	FSimpleMulticastDelegate OnAllLoadsComplete;
+
+protected:
+	struct FAssetEntry
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		int64 SizeBytes = 0;
+		uint64 LastUse = 0;
+		double RequestTime = 0.0;
+		double LoadSeconds = 0.0;
+		bool bLoaded = false;
+	};
+
+	void RequestCardAssetsWithPriority(const FCardData& InCardData, const int32 Priority);
+	void RequestAsset(const FSoftObjectPath& Path, const int32 Priority);
+	void OnAssetLoaded(FSoftObjectPath Path);
+	void EnforceBudget();
+
+	TMap<FSoftObjectPath, FAssetEntry> Entries;
+
+	uint64 UseCounter = 0;
+	int64 ResidentBytes = 0;
+	int32 PendingLoads = 0;
+
+	// for the report
+	double FirstRequestTime = 0.0;
+	double LastLoadTime = 0.0;
+	double MaxLoadSeconds = 0.0;
+	double TotalLoadSeconds = 0.0;
+	int32 LoadedNum = 0;
+	int32 EvictedNum = 0;
+};
@@ -25,7 +25,37 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	// pool hooks, a pooled card is re-initialized in place
+	// instead of being destroyed and spawned again
+	void InitializeCard(const FCardData& InCardData);
+	void ResetCard();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	const FCardData& GetCardData() const { return CardData; };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool IsPooled() const { return bPooled; };
+
+	// tweens on clients, server builds compiled without cosmetics snap
+	// straight to the end
+	UFUNCTION(BlueprintCallable, Category = "Presentation")
+	void MoveCardTo(const FVector& Location, const FRotator& Rotation, const float Duration);
+
+	// slot in the match zone index
+	UPROPERTY(BlueprintReadOnly, Category = "Data")
+	FTCG_CardHandle CardHandle;
+
 protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Data")
 	FCardData CardData;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Pool")
+	bool bPooled = false;
+
+	// refresh visuals for the new CardData
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pool")
+	void OnCardInitialized();
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pool")
+	void OnCardReset();
 };
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CardInstanceTable.h"
+#include "CardInstanceRenderer.generated.h"
+
+class ACardBase;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Optional presentation mode, placing this in the level draws every
+ * registered card as one instance of a single instanced mesh.
+ * Only the hovered card shows its full actor.
+ */
+UCLASS()
+class TCG_SAMPLE_API ACardInstanceRenderer : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ACardInstanceRenderer();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+public:	
+	// Called every frame, pushes the table changes to the instanced mesh
+	virtual void Tick(float DeltaTime) override;
+
+	UFUNCTION(BlueprintCallable, Category = "Instancing")
+	void RegisterCard(ACardBase* Card, const int32 ArtIndex);
+
+	UFUNCTION(BlueprintCallable, Category = "Instancing")
+	void UnregisterCard(ACardBase* Card);
+
+	UFUNCTION(BlueprintCallable, Category = "Instancing")
+	void SetCardTransform(ACardBase* Card, const FTransform& Transform);
+
+	UFUNCTION(BlueprintCallable, Category = "Instancing")
+	void SetCardHighlighted(ACardBase* Card, const bool bHighlighted);
+
+	// swaps the card under the cursor between its instance and its actor
+	UFUNCTION(BlueprintCallable, Category = "Instancing")
+	void SetHoveredCard(ACardBase* Card);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Instancing")
+	int32 GetInstanceNum() const { return InstanceTable.Num(); };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Instancing")
+	int32 GetUpdatesLastFrame() const { return InstanceTable.GetUpdatesLastFlush(); };
+
+	const FCardInstanceTable& GetInstanceTable() const { return InstanceTable; };
+
+protected:
+	void FlushInstances();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UInstancedStaticMeshComponent* CardInstances;
+
+	UPROPERTY(BlueprintReadOnly)
+	ACardBase* HoveredCard;
+
+	FCardInstanceTable InstanceTable;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ACardBase;
+
+/**
+ * Bookkeeping for cards drawn as instances of one instanced mesh.
+ * Keeps no rendering state so it can be driven and checked without a GPU,
+ * the renderer only applies what changed since the last flush.
+ */
+class TCG_SAMPLE_API FCardInstanceTable
+{
+public:
+	// per instance custom data: art index, highlight
+	static constexpr int32 NumCustomData = 2;
+
+	struct FInstance
+	{
+		const ACardBase* Card = nullptr;
+		FTransform Transform;
+		float CustomData[NumCustomData] = { 0.f, 0.f };
+		bool bHidden = false;
+
+		FTransform GetRenderTransform() const;
+	};
+
+	int32 Add(const ACardBase* Card, const FTransform& Transform, const int32 ArtIndex);
+	// swap removes, the last instance moves into the freed slot
+	bool Remove(const ACardBase* Card);
+	void Empty();
+
+	void SetTransform(const ACardBase* Card, const FTransform& Transform);
+	void SetHighlighted(const ACardBase* Card, const bool bHighlighted);
+	// hidden instances are kept at zero scale so indices stay stable
+	void SetHidden(const ACardBase* Card, const bool bHidden);
+
+	int32 Find(const ACardBase* Card) const;
+	int32 Num() const { return Instances.Num(); };
+	const FInstance& Get(const int32 Index) const { return Instances[Index]; };
+
+	// instances the renderer has to add, update or drop since the last flush
+	int32 GetRenderedNum() const { return RenderedNum; };
+	const TSet<int32>& GetDirtyInstances() const { return DirtyInstances; };
+
+	// called by the renderer after applying the changes
+	void MarkFlushed();
+
+	int32 GetUpdatesLastFlush() const { return UpdatesLastFlush; };
+
+private:
+	void MarkDirty(const int32 Index);
+
+	TArray<FInstance> Instances;
+	TMap<const ACardBase*, int32> CardToInstance;
+	TSet<int32> DirtyInstances;
+
+	int32 RenderedNum = 0;
+	int32 UpdatesLastFlush = 0;
+};
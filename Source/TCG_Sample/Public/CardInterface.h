@@ -29,4 +29,8 @@ public:
 
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
 	void OnDrawVoidCard(const int32& Count);
+
+	// server drew a different card than the one predicted locally
+	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
+	void OnDrawRejected(class ACardBase* PredictedCard, class ACardBase* DrewCard);
 };
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TCG_Definitions.h"
+#include "CardPoolSubsystem.generated.h"
+
+class ACardBase;
+
+USTRUCT(BlueprintType)
+struct FCardPoolStats
+{
+	GENERATED_BODY()
+
+	// acquire served from the pool
+	UPROPERTY(BlueprintReadOnly)
+	int32 Hits = 0;
+	// acquire that had to spawn
+	UPROPERTY(BlueprintReadOnly)
+	int32 Misses = 0;
+	// all spawns including prewarm
+	UPROPERTY(BlueprintReadOnly)
+	int32 Spawns = 0;
+	UPROPERTY(BlueprintReadOnly)
+	int32 Releases = 0;
+};
+
+USTRUCT()
+struct FCardPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ACardBase*> FreeCards;
+};
+
+/**
+ * Per world pool of card actors, cards moving between zones or
+ * matches restarting reuse actors instead of spawning new ones
+ */
+UCLASS()
+class TCG_SAMPLE_API UCardPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// tops the free cards of the class up to Count, callers prewarm right
+	// before acquiring so each one is sized for its own cards
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void Prewarm(TSubclassOf<ACardBase> CardClass, const int32 Count);
+
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	ACardBase* Acquire(TSubclassOf<ACardBase> CardClass, const FCardData& InCardData,
+		const FTransform& SpawnTransform);
+
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void Release(ACardBase* Card);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Pool")
+	int32 GetFreeCardNum(TSubclassOf<ACardBase> CardClass) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Pool")
+	FCardPoolStats GetStats() const { return Stats; };
+
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void ResetStats() { Stats = FCardPoolStats(); };
+
+protected:
+	ACardBase* SpawnPooledCard(TSubclassOf<ACardBase> CardClass, 
+		const FTransform& SpawnTransform);
+
+	UPROPERTY()
+	TMap<UClass*, FCardPoolBucket> Buckets;
+
+	FCardPoolStats Stats;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "TCG_Definitions.h"
 #include "Deck.generated.h"
 
 class ACardBase;
@@ -12,6 +13,7 @@ UCLASS()
 class TCG_SAMPLE_API ADeck : public AActor
 {
 	GENERATED_BODY()
+
 	
 public:	
 	// Sets default values for this actor's properties
@@ -23,6 +25,7 @@ protected:
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
 	virtual void GetLifetimeReplicatedProps(
 		TArray<FLifetimeProperty>& OutLifetimeProps) const;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 public:	
 	// Called every frame
@@ -39,28 +42,127 @@ protected:
 	UPROPERTY(BlueprintReadOnly, EditAnywhere)
 	TArray<ACardBase*> Decklist;
 
+	// cards created from the world's card pool at begin play, on top of
+	// the editor placed Decklist, and released to it at end play
+	UPROPERTY(EditAnywhere, Category = "Pool")
+	TSubclassOf<ACardBase> PooledCardClass;
+
+	UPROPERTY(EditAnywhere, Category = "Pool")
+	TArray<FCardData> PooledCards;
+
+	UPROPERTY()
+	TArray<ACardBase*> AcquiredCards;
+
+	void AcquirePooledCards();
+	void ReleasePooledCards();
+
+	// player slot of this deck's cards in the game state's zone index,
+	// one deck per seat since handles are numbered within the slot
+	UPROPERTY(EditAnywhere, Category = "Zones")
+	int32 OwnerIndex = 0;
+
+	// lockstep, cards drawn by the opponent whose identity isn't public yet
+	UPROPERTY(BlueprintReadOnly, Category = "Lockstep")
+	int32 HiddenDrawCount = 0;
+
+	// waits for the card database when it is still preloading
+	void RegisterCardZones();
+	void MoveCardZone(ACardBase* Card, const ECardZone Zone);
+
+	UFUNCTION()
+	void OnCardDatabaseReady(bool bSuccess);
+
+	bool bCardZonesRegistered = false;
+
+	// every card this deck started with, to find returned cards by handle
+	UPROPERTY()
+	TArray<ACardBase*> OwnedCards;
+
+	// server, repeats a library change on the owning client
+	void MirrorToOwner(const FTCG_DeckMutation& Mutation) const;
+	ACardBase* PopTopCard();
+
 	UPROPERTY(BlueprintReadOnly, ReplicatedUsing = OnVoidDrawCount)
 	int32 VoidDrawCount;
 
 	UFUNCTION()
 	void OnVoidDrawCount();
 
+	// value currently folded into the state hash
+	int32 HashedVoidDrawCount = 0;
+	void HashVoidDrawCount();
+
+	// shuffle and return use this seed so clients keep the server's order
+	UPROPERTY(ReplicatedUsing = OnRep_ShuffleSeed)
+	int32 ShuffleSeed;
+
+	FRandomStream DeckStream;
+
+	UFUNCTION()
+	void OnRep_ShuffleSeed();
+
+	// drawn card at hand priority, next card at top of deck priority
+	void StreamCardAssets(ACardBase* DrewCard);
+
+	// off for decks whose cards never get shown, e.g. benchmark decks
+	bool bStreamCardAssets = true;
+
 	UFUNCTION(BlueprintCallable)
-	void Shuffle();
+	void Redraw_Single(ACardBase* ReturnedCard);
+
+	UFUNCTION(BlueprintCallable)
+	TArray<ACardBase*> Redraw_Multiple(TArray<ACardBase*> ReturnedCards);
 
+public:
 	UFUNCTION(BlueprintCallable)
-	void Draw();
+	void Shuffle();
 
 	UFUNCTION(BlueprintCallable)
 	void ReturnCard(ACardBase* ReturnedCard);
 
 	UFUNCTION(BlueprintCallable)
-	void Redraw_Single(ACardBase* ReturnedCard);
+	ACardBase* Draw();
 
+	// puts a card from the hand back and draws its replacement
 	UFUNCTION(BlueprintCallable)
-	TArray<ACardBase*> Redraw_Multiple(TArray<ACardBase*> ReturnedCards);
+	ACardBase* Mulligan(ACardBase* ReturnedCard);
+
+	// server, draw the owner predicted, answered by its reconcile
+	ACardBase* DrawRequested();
+
+	// owning client, a library change the server made on its own
+	void ApplyMirroredMutation(const FTCG_DeckMutation& Mutation);
+
+	// client side, pops the local top card and starts its animation
+	// without waiting for the server
+	ACardBase* PredictDraw();
+
+	// undo a predicted draw when the server drew something else. draws
+	// predicted after it, oldest first, are predicted again on the corrected
+	// library and LaterPredictedCards is updated with their new cards
+	void ReconcileDraw(ACardBase* PredictedCard, ACardBase* DrewCard,
+		TArray<ACardBase*>& LaterPredictedCards);
+
+	// lockstep, the opponent drew a card this peer doesn't know
+	void DrawHidden();
+	// lockstep, a hidden card became public in that zone
+	void RevealHiddenCard(const int32 CardId, const ECardZone Zone = ECardZone::OpponentRevealed);
+
+	// lockstep, the seed comes from the server by RPC, only to the owner
+	void SetShuffleSeed(const int32 Seed);
+	int32 GetShuffleSeed() const { return ShuffleSeed; };
+
+	int32 GetOwnerIndex() const { return OwnerIndex; };
+
+	// replaces the library without moving zones, for decks outside a match
+	void SetDecklist(const TArray<ACardBase*>& Cards) { Decklist = Cards; };
+	void SetStreamCardAssets(const bool bInStreamCardAssets) { bStreamCardAssets = bInStreamCardAssets; };
+
+	// card still in this deck with that handle
+	ACardBase* FindCard(const FTCG_CardHandle Handle) const;
+	// card this deck started with, wherever it is now
+	ACardBase* FindOwnedCard(const FTCG_CardHandle Handle) const;
 
-public:
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	int32 GetRemainingCardNum();
 };
@@ -4,9 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "TCG_Definitions.h"
+#include "TCG_MoveGenerator.h"
 #include "Hand.generated.h"
 
 class ACardBase;
+class ATCG_GameState;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnTurnStart);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnTurnEnd);
@@ -38,4 +41,58 @@ protected:
 
 	UPROPERTY(BlueprintAssignable)
 	FOnTurnEnd OnTurnEnd;
+
+	FTCG_MoveGenerator MoveGenerator;
+
+	// seat whose drawn cards land in this hand
+	UPROPERTY(EditAnywhere, Category = "Zones")
+	int32 OwnerIndex = 0;
+
+	UFUNCTION()
+	void OnGamePhaseChanged(EGamePhase ChangedPhase);
+
+	// clients may begin play before the game state arrives
+	void BindGameState(AGameStateBase* GameState);
+	FDelegateHandle GameStateSetHandle;
+
+	// cards entering or leaving the hand and board feed the generator
+	void OnCardZoneChanged(const FTCG_CardHandle Handle, const ECardZone PreviousZone, 
+		const ECardZone Zone);
+	void RefreshBoardTargets(const ATCG_GameState& GameState);
+	FDelegateHandle CardZoneChangedHandle;
+
+	// rebuilt on the first read after the generator changes
+	UPROPERTY(Transient)
+	mutable TArray<ACardBase*> PlayableCards;
+	mutable bool bPlayableCardsDirty = true;
+
+	bool EnsureCardDatabase();
+
+public:
+	UFUNCTION(BlueprintCallable)
+	void AddCard(ACardBase* Card);
+
+	UFUNCTION(BlueprintCallable)
+	void RemoveCard(ACardBase* Card);
+
+	// untapped lands of the owning player
+	UFUNCTION(BlueprintCallable)
+	void SetUntappedLands(const TArray<ACardBase*>& Lands);
+
+	// anything a spell may target, replaced by the board's cards on every board change
+	UFUNCTION(BlueprintCallable)
+	void SetBoardTargets(const TArray<AActor*>& Targets);
+
+	UFUNCTION(BlueprintCallable)
+	void SetLandPlayed(const bool bLandPlayed);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool IsCardPlayable(ACardBase* Card) const;
+
+	// for highlighting, read every frame
+	UFUNCTION(BlueprintCallable)
+	const TArray<ACardBase*>& GetPlayableCards() const;
+
+	// callers changing the generator directly get the cache rebuilt too
+	FTCG_MoveGenerator& GetMoveGenerator() { bPlayableCardsDirty = true; return MoveGenerator; };
 };
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Micro benchmarks of the rules primitives: deck Shuffle, Draw, ReturnCard
+ * and Mulligan from 40 to 10,000 cards, and mana evaluation of whole
+ * hands over several hand sizes and cost shapes. Each case repeats batches
+ * for tcg.Bench.MinTime seconds and reports the fastest and median ns per
+ * op. Tagged memory growth per op is added when running with -llm, it is
+ * the net change of the TCG and TweenMaker tags and stands in for an
+ * allocation count: an op that allocates and frees shows 0. Cache misses
+ * aren't measured, read them with a hardware profiler around the command.
+ * The json carries the same notes in its "schema" object.
+ *
+ * tcg.Bench [case filter] [path.json], e.g. tcg.Bench Draw
+ */
+struct TCG_SAMPLE_API FTCG_Bench
+{
+	struct FResult
+	{
+		FString Name;
+		TArray<TPair<FString, FString>> Params;
+		int64 Ops = 0;
+		double MinNsPerOp = 0.0;
+		double MedianNsPerOp = 0.0;
+		// net tagged growth, not allocations, negative while the memory tracker is off
+		double TaggedBytesPerOp = -1.0;
+	};
+
+	// empty filter runs every case
+	static TArray<FResult> Run(UWorld* World, const FString& Filter = FString());
+
+	// empty path writes to Saved/Profiling, returns the file written
+	static FString ExportJson(const TArray<FResult>& Results, const FString& Path = FString());
+
+private:
+	static void RunDeckCases(UWorld* World, const FString& Filter, TArray<FResult>& OutResults);
+	static void RunManaCases(const FString& Filter, TArray<FResult>& OutResults);
+};
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_CardBitset.h"
+#include "TCG_Definitions.h"
+
+class FTCG_CardDatabase;
+struct FTCG_CardEntry;
+
+/**
+ * One bitset per attribute value over every card in the database, 
+ * so deck builder filters resolve to word operations instead of row scans.
+ * Bit positions are card database indices.
+ */
+class TCG_SAMPLE_API FTCG_CardBitmapIndex
+{
+public:
+	// numeric stats are bucketed, the last bucket holds everything above
+	static constexpr int32 NumStatBuckets = 11;
+
+	void Build(const FTCG_CardDatabase& CardDatabase);
+	// the name order follows the culture's collation, rebuild it when that changes
+	void RebuildNameOrder(const FTCG_CardDatabase& CardDatabase);
+
+	// cards the player owns, for FTCG_CardFilter::bOwnedOnly
+	void SetOwnedCards(const TArray<int32>& OwnedCardIds);
+
+	FTCG_CardBitset Evaluate(const FTCG_CardFilter& Filter) const;
+
+	// one page of matching CardIds in the filter's sort order, returns total matches
+	int32 Query(const FTCG_CardFilter& Filter, TArray<int32>& OutCardIds) const;
+
+	int32 Num() const { return CardIds.Num(); };
+
+	static int32 GetTotalCost(const FTCG_CardEntry& Entry);
+
+private:
+	enum class EStat : uint8
+	{
+		Cost,
+		Attack,
+		HitPoint,
+		Num,
+	};
+
+	static int32 ToBucket(const int32 Value);
+	void BuildSortOrder(const TArray<FTCG_CardEntry>& Entries, const ECardSortKey SortKey);
+	void AndRange(FTCG_CardBitset& Result, const EStat Stat, 
+		const int32 Min, const int32 Max) const;
+
+	TArray<int32> CardIds;
+	TArray<FTCG_CardBitset> ByCardType;
+	TArray<FTCG_CardBitset> ByRarity;
+	TArray<FTCG_CardBitset> ByManaType;
+	// AtLeast[Stat][Bucket] holds cards whose stat bucket is >= Bucket
+	TArray<FTCG_CardBitset> AtLeast[static_cast<int32>(EStat::Num)];
+	FTCG_CardBitset Owned;
+
+	// database indices presorted per ECardSortKey
+	TArray<TArray<int32>> SortOrders;
+};
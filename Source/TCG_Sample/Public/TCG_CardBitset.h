@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_MatchArena.h"
+
+/**
+ * Fixed size bitset over card positions, 64 cards per word.
+ * Filters and queries combine these with plain word operations.
+ * Words come from the match arena when one is in scope.
+ */
+class TCG_SAMPLE_API FTCG_CardBitset
+{
+public:
+	FTCG_CardBitset() = default;
+	explicit FTCG_CardBitset(const int32 InNumBits, const bool bValue = false)
+	{
+		Init(InNumBits, bValue);
+	}
+
+	void Init(const int32 InNumBits, const bool bValue = false)
+	{
+		NumBits = InNumBits;
+		Words.Init(bValue ? ~0ull : 0ull, (InNumBits + 63) / 64);
+		ClearTail();
+	}
+
+	int32 Num() const { return NumBits; };
+	const TArray<uint64, FTCG_ArenaAllocator>& GetWords() const { return Words; };
+	void SetWord(const int32 WordIndex, const uint64 Word) { Words[WordIndex] = Word; };
+
+	void Set(const int32 Index) { Words[Index >> 6] |= 1ull << (Index & 63); };
+	void Clear(const int32 Index) { Words[Index >> 6] &= ~(1ull << (Index & 63)); };
+	bool Contains(const int32 Index) const 
+	{ 
+		return Index >= 0 && Index < NumBits && (Words[Index >> 6] >> (Index & 63)) & 1ull; 
+	};
+
+	void Reset()
+	{
+		FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	}
+
+	FTCG_CardBitset& operator&=(const FTCG_CardBitset& Other)
+	{
+		check(Other.NumBits == NumBits);
+		for (int32 Index = 0; Index < Words.Num(); Index++)
+		{
+			Words[Index] &= Other.Words[Index];
+		}
+		return *this;
+	}
+
+	FTCG_CardBitset& operator|=(const FTCG_CardBitset& Other)
+	{
+		check(Other.NumBits == NumBits);
+		for (int32 Index = 0; Index < Words.Num(); Index++)
+		{
+			Words[Index] |= Other.Words[Index];
+		}
+		return *this;
+	}
+
+	FTCG_CardBitset& AndNot(const FTCG_CardBitset& Other)
+	{
+		check(Other.NumBits == NumBits);
+		for (int32 Index = 0; Index < Words.Num(); Index++)
+		{
+			Words[Index] &= ~Other.Words[Index];
+		}
+		return *this;
+	}
+
+	int32 CountSetBits() const
+	{
+		int32 Count = 0;
+		for (const uint64 Word : Words)
+		{
+			Count += FMath::CountBits(Word);
+		}
+		return Count;
+	}
+
+	bool IsEmpty() const
+	{
+		for (const uint64 Word : Words)
+		{
+			if (Word)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename FunctionType>
+	void ForEachSetBit(FunctionType&& Function) const
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+		{
+			uint64 Word = Words[WordIndex];
+			while (Word)
+			{
+				const int32 Bit = static_cast<int32>(FMath::CountTrailingZeros64(Word));
+				Function((WordIndex << 6) + Bit);
+				Word &= Word - 1;
+			}
+		}
+	}
+
+private:
+	void ClearTail()
+	{
+		const int32 TailBits = NumBits & 63;
+		if (TailBits && Words.Num() > 0)
+		{
+			Words.Last() &= (1ull << TailBits) - 1;
+		}
+	}
+
+	TArray<uint64, FTCG_ArenaAllocator> Words;
+	int32 NumBits = 0;
+};
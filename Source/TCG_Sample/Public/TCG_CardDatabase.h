@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_Definitions.h"
+
+class UDataTable;
+
+// flattened view of one card row, whatever table it came from
+struct FTCG_CardEntry
+{
+	int32 CardId = 0;
+	FName RowName;
+	ECardType CardType = ECardType::Minion;
+	ERarity Rarity = ERarity::Normal;
+	int32 Attack = 0;
+	int32 HitPoint = 0;
+	EManaType ManaType = EManaType::Fire;
+	TArray<FManaCost> Costs;
+
+	// points into the owning data table, valid while the table is loaded
+	const FCardData* Data = nullptr;
+};
+
+/**
+ * Card rows indexed by CardId. Built once from the card data tables,
+ * safe to build off the game thread as long as the tables stay loaded.
+ */
+class TCG_SAMPLE_API FTCG_CardDatabase
+{
+public:
+	static constexpr int32 MinDeckSize = 40;
+	static constexpr int32 MaxDeckSize = 60;
+	static constexpr int32 MaxCopies = 3;
+	static constexpr int32 MaxRareCopies = 1;
+
+	void Build(const TArray<const UDataTable*>& Tables);
+
+	const FTCG_CardEntry* Find(const int32 CardId) const;
+	int32 IndexOf(const int32 CardId) const;
+
+	int32 Num() const { return Entries.Num(); };
+	const TArray<FTCG_CardEntry>& GetEntries() const { return Entries; };
+
+	bool ValidateDecklist(const FTCG_Decklist& Decklist, FString& OutError) const;
+
+private:
+	TArray<FTCG_CardEntry> Entries;
+	TMap<int32, int32> CardIdToIndex;
+};
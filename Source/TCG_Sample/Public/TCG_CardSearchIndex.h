@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FTCG_CardDatabase;
+
+/**
+ * Trigram inverted index over the localized card names and rules text
+ * of one culture. Results are ranked name match first, then description.
+ */
+class TCG_SAMPLE_API FTCG_CardSearchIndex
+{
+public:
+	void Build(const FTCG_CardDatabase& CardDatabase, const FString& InCulture);
+
+	// CardIds best match first, returns the number of matches
+	int32 Search(const FString& Query, const int32 MaxResults, TArray<int32>& OutCardIds);
+
+	const FString& GetCulture() const { return Culture; };
+
+private:
+	enum class EMatchRank : uint8
+	{
+		NameExact,
+		NamePrefix,
+		NameWordStart,
+		NameSubstring,
+		Description,
+		None,
+	};
+
+	static uint64 MakeTrigram(const TCHAR* Chars);
+	void AddTrigrams(const FString& Text, const int32 CardIndex);
+	EMatchRank Rank(const int32 CardIndex, const FString& LowerQuery) const;
+
+	// lower cased, per card database index
+	TArray<FString> Names;
+	TArray<FString> Descriptions;
+	TArray<int32> CardIds;
+
+	// sorted card indices per trigram
+	TMap<uint64, TArray<int32>> Postings;
+
+	FString Culture;
+
+	// the previous query's matches, narrowed down while the user keeps typing
+	FString LastQuery;
+	TArray<int32> LastMatches;
+};
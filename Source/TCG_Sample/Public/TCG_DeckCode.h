@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_Definitions.h"
+
+class FTCG_CardDatabase;
+
+/**
+ * Compact text form of a decklist for sharing, matchmaking and the backend.
+ * Layout: version byte, varint entry count, per entry varint CardId delta
+ * and varint copy count (sorted by CardId), 16 bit checksum, then base64.
+ */
+class TCG_SAMPLE_API FTCG_DeckCode
+{
+public:
+	static constexpr uint8 Version = 1;
+
+	static FString Encode(const FTCG_Decklist& Decklist);
+	static bool Decode(const FString& Code, FTCG_Decklist& OutDecklist, FString& OutError);
+
+	// decode plus legality against the card pool
+	static bool Validate(const FString& Code, const FTCG_CardDatabase& CardDatabase, 
+		FString& OutError);
+
+	static void WriteVarint(TArray<uint8>& Bytes, uint32 Value);
+	static bool ReadVarint(const TArray<uint8>& Bytes, int32& Offset, uint32& OutValue);
+
+private:
+	static uint16 Checksum(const uint8* Data, const int32 Num);
+};
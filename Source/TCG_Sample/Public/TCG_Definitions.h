@@ -5,6 +5,9 @@
 #include "CoreMinimal.h"
 #include "TCG_Definitions.generated.h"
 
+class UTexture2D;
+class UStaticMesh;
+
 // needs more type
 // each type should have own characteristic
 UENUM(BlueprintType)
@@ -36,6 +39,17 @@ struct FManaCost
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	TMap<EManaType, int32> Cost;
+
+	// one flag per mana type, amounts below 15 in 4 bits, others
+	// escaped with 15 and sent packed at full width
+	static constexpr int32 NetAmountEscape = 15;
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FManaCost> : public TStructOpsTypeTraitsBase2<FManaCost>
+{
+	enum { WithNetSerializer = true };
 };
 
 USTRUCT(BlueprintType)
@@ -43,6 +57,9 @@ struct FCardData : public FTableRowBase
 {
 	GENERATED_BODY()
 
+	// stable across content changes, decklists and deck codes refer to this
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Default")
+	int32 CardId = 0;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Default")
 	FText CardName;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Default")
@@ -51,6 +68,12 @@ struct FCardData : public FTableRowBase
 	ECardType CardType;
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Default")
 	ERarity Rarity;
+
+	// soft so only cards the player can actually see get loaded
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Assets")
+	TSoftObjectPtr<UTexture2D> CardArt;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "CardData|Assets")
+	TSoftObjectPtr<UStaticMesh> CardMesh;
 };
 
 USTRUCT(BlueprintType)
@@ -85,6 +108,19 @@ struct FLandData : public FCardData
 	EManaType IncreaseManaType;
 };
 
+// where a card currently is, also decides how urgently its assets load
+UENUM(BlueprintType)
+enum class ECardZone : uint8
+{
+	Library,
+	DeckTop,
+	Hand,
+	Board,
+	Graveyard,
+	OpponentRevealed,
+	OpponentHidden,
+};
+
 UENUM(BlueprintType)
 enum class EGamePhase : uint8
 {
@@ -100,6 +136,204 @@ enum class EGamePhase : uint8
 	GameEnd,
 };
 
+// index of a card inside the current match, stable for the whole match
+USTRUCT(BlueprintType)
+struct FTCG_CardHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Index = INDEX_NONE;
+
+	bool IsValid() const { return Index != INDEX_NONE; };
+	bool operator==(const FTCG_CardHandle& Other) const { return Index == Other.Index; };
+
+	// valid flag and a packed index, 9 bits for a two player match
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FTCG_CardHandle> : public TStructOpsTypeTraitsBase2<FTCG_CardHandle>
+{
+	enum { WithNetSerializer = true };
+};
+
+// replicated hitpoint, zigzag packed since it stays small and may go negative
+USTRUCT(BlueprintType)
+struct FTCG_NetHitpoint
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Value = 0;
+
+	// last damage prediction of the owner already folded into Value
+	UPROPERTY(BlueprintReadOnly)
+	int32 AckedPredictionKey = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FTCG_NetHitpoint> : public TStructOpsTypeTraitsBase2<FTCG_NetHitpoint>
+{
+	enum { WithNetSerializer = true };
+};
+
+// actions the owning client applies locally before the server answers
+UENUM(BlueprintType)
+enum class EPredictedAction : uint8
+{
+	Draw,
+	PhaseChange,
+	Damage,
+};
+
+USTRUCT(BlueprintType)
+struct FPredictedAction
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PredictionKey = 0;
+	UPROPERTY(BlueprintReadOnly)
+	EPredictedAction Action = EPredictedAction::Draw;
+	// remaining deck size, target phase or resulting hitpoint
+	UPROPERTY(BlueprintReadOnly)
+	int32 PredictedValue = 0;
+	// damage applied locally, replayed on top of replicated hitpoint
+	UPROPERTY(BlueprintReadOnly)
+	int32 Delta = 0;
+	UPROPERTY(BlueprintReadOnly)
+	class ACardBase* PredictedCard = nullptr;
+	UPROPERTY(BlueprintReadOnly)
+	class ADeck* Deck = nullptr;
+	// platform seconds when the request was sent, for round-trip timing
+	double RequestTime = 0.0;
+};
+
+// server side library changes the deck owner repeats on its copy
+UENUM(BlueprintType)
+enum class ETCG_DeckMutation : uint8
+{
+	Draw,
+	Return,
+	Shuffle,
+};
+
+USTRUCT(BlueprintType)
+struct FTCG_DeckMutation
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	ETCG_DeckMutation Type = ETCG_DeckMutation::Draw;
+	// drawn or returned card
+	UPROPERTY(BlueprintReadOnly)
+	FTCG_CardHandle Card;
+	// insert position of a returned card
+	UPROPERTY(BlueprintReadOnly)
+	int32 Index = 0;
+	// library after a shuffle, bottom to top
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FTCG_CardHandle> Order;
+};
+
+// player input in lockstep matches, the only gameplay traffic besides reveals
+UENUM(BlueprintType)
+enum class ETCG_CommandType : uint8
+{
+	Draw,
+	PhaseChange,
+	Damage,
+};
+
+USTRUCT(BlueprintType)
+struct FTCG_Command
+{
+	GENERATED_BODY()
+
+	// assigned by the server, peers apply commands in this order
+	UPROPERTY(BlueprintReadOnly)
+	int32 Serial = 0;
+	UPROPERTY(BlueprintReadOnly)
+	int32 PlayerIndex = 0;
+	UPROPERTY(BlueprintReadOnly)
+	ETCG_CommandType Type = ETCG_CommandType::Draw;
+	// deck owner, target phase or damage
+	UPROPERTY(BlueprintReadOnly)
+	int32 Value = 0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FTCG_Command> : public TStructOpsTypeTraitsBase2<FTCG_Command>
+{
+	enum { WithNetSerializer = true };
+};
+
+USTRUCT(BlueprintType)
+struct FTCG_Decklist
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString DeckName;
+
+	// one entry per copy
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<int32> CardIds;
+};
+
+UENUM(BlueprintType)
+enum class ECardSortKey : uint8
+{
+	CardId,
+	Name,
+	Cost,
+	Attack,
+	HitPoint,
+};
+
+// deck builder facets, values inside a facet are OR-ed, facets are AND-ed,
+// an empty facet matches everything
+USTRUCT(BlueprintType)
+struct FTCG_CardFilter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<ECardType> CardTypes;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<ERarity> Rarities;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<EManaType> ManaTypes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinCost = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxCost = MAX_int32;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinAttack = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxAttack = MAX_int32;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MinHitPoint = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxHitPoint = MAX_int32;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bOwnedOnly = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	ECardSortKey SortBy = ECardSortKey::CardId;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PageIndex = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PageSize = 20;
+};
+
 USTRUCT(BlueprintType)
 struct FTCG_Session
 {
@@ -6,8 +6,27 @@
 #include "Engine/GameInstance.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "OnlineSessionSettings.h"
+#include "TCG_Definitions.h"
 #include "TCG_GameInstance.generated.h"
 
+class FTCG_CardDatabase;
+class FTCG_CardBitmapIndex;
+class FTCG_CardSearchIndex;
+class UDataTable;
+
+UENUM(BlueprintType)
+enum class ETCG_PreloadPhase : uint8
+{
+	Idle,
+	LoadingTables,
+	Indexing,
+	WarmingAssets,
+	Complete,
+	Failed,
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPreloadComplete, bool, bSuccess);
+
 /**
  * 
  */
@@ -25,6 +44,7 @@ private:
 
 protected:
 	virtual void Init() override;
+	virtual void Shutdown() override;
 
 	IOnlineSessionPtr SessionInterface;
 
@@ -53,4 +73,81 @@ protected:
 
 	UFUNCTION(BlueprintCallable)
 	bool FindLocalUserSteamID();
+
+protected:
+	// background preload started from Init: card tables are loaded and
+	// indexed off the game thread, decks validated, first match assets warmed
+	UPROPERTY(EditDefaultsOnly, Category = "Cards")
+	TArray<TSoftObjectPtr<UDataTable>> CardTables;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Cards")
+	TArray<FTCG_Decklist> Decklists;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cards")
+	int32 ActiveDeckIndex = 0;
+
+	UPROPERTY()
+	TArray<UDataTable*> LoadedCardTables;
+
+	TSharedPtr<FTCG_CardDatabase, ESPMode::ThreadSafe> CardDatabase;
+	TSharedPtr<FTCG_CardBitmapIndex, ESPMode::ThreadSafe> CardIndex;
+	TSharedPtr<FTCG_CardSearchIndex, ESPMode::ThreadSafe> CardSearch;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Cards")
+	TArray<FString> DeckErrors;
+
+	ETCG_PreloadPhase PreloadPhase = ETCG_PreloadPhase::Idle;
+	double PreloadStartTime = 0.0;
+	int32 WarmRequestNum = 0;
+	bool bFirstMatchStarted = false;
+	FDelegateHandle WarmCompleteHandle;
+
+	void StartPreload();
+	void OnCardTablesLoaded();
+	void OnCardDatabaseBuilt(TSharedPtr<FTCG_CardDatabase, ESPMode::ThreadSafe> Database,
+		TSharedPtr<FTCG_CardBitmapIndex, ESPMode::ThreadSafe> Index, 
+		TSharedPtr<FTCG_CardSearchIndex, ESPMode::ThreadSafe> Search, TArray<FString> Errors);
+	void OnCardAssetsWarmed();
+	void SetPreloadPhase(const ETCG_PreloadPhase NewPhase);
+
+	// card names and text are searched in the current language
+	void OnCultureChanged();
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FOnPreloadComplete OnPreloadComplete;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	ETCG_PreloadPhase GetPreloadPhase() const { return PreloadPhase; };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	float GetPreloadProgress() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool IsCardDatabaseReady() const { return CardDatabase.IsValid(); };
+
+	// null until indexing finished
+	const FTCG_CardDatabase* GetCardDatabase() const { return CardDatabase.Get(); };
+
+	// logs time to first match, once
+	void MarkMatchStarted();
+
+	// deck builder collection view, returns the number of matches
+	UFUNCTION(BlueprintCallable, Category = "Cards")
+	int32 FilterCollection(const FTCG_CardFilter& Filter, TArray<int32>& OutCardIds) const;
+
+	// collection search box, call again on every keystroke
+	UFUNCTION(BlueprintCallable, Category = "Cards")
+	int32 SearchCards(const FString& Query, const int32 MaxResults, TArray<int32>& OutCardIds);
+
+	UFUNCTION(BlueprintCallable, Category = "Cards")
+	void SetOwnedCards(const TArray<int32>& OwnedCardIds);
+
+	UFUNCTION(BlueprintCallable, Category = "Cards")
+	FString ExportDeckCode(const int32 DeckIndex) const;
+
+	// adds the decoded deck to Decklists, rejects illegal decks once
+	// the card database is ready
+	UFUNCTION(BlueprintCallable, Category = "Cards")
+	bool ImportDeckCode(const FString& Code, const FString& DeckName, FString& OutError);
 };
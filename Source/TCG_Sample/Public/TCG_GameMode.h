@@ -20,6 +20,10 @@ class TCG_SAMPLE_API ATCG_GameMode : public AGameModeBase
 	
 	virtual void BeginPlay() override;
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+	virtual void PreLogin(const FString& Options, const FString& Address, 
+		const FUniqueNetIdRepl& UniqueId, FString& ErrorMessage) override;
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+	virtual void InitGameState() override;
 
 protected:
 	UPROPERTY(BlueprintReadOnly)
@@ -28,6 +32,16 @@ protected:
 	UPROPERTY(BlueprintAssignable)
 	FOnGamePhaseChanged OnGamePhaseChanged;
 
+	// peers run the rules from player commands, state isn't replicated
+	UPROPERTY(EditDefaultsOnly, Category = "Lockstep")
+	bool bLockstep = false;
+
+	// started with -TCGLoadTest, bots past the deck seats still get a seat
+	bool bLoadTestSession = false;
+
+	// lowest seat no player holds, INDEX_NONE when the match is full
+	int32 FindFreeSeat() const;
+
 public:
 	UFUNCTION(Server, Reliable)
 	void RequestPhaseChange(const EGamePhase TargetPhase);
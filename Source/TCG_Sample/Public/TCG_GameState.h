@@ -4,8 +4,21 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameStateBase.h"
+#include "TCG_Definitions.h"
+#include "TCG_GameMode.h"
+#include "TCG_MatchArena.h"
+#include "TCG_StateHash.h"
+#include "TCG_StatLayers.h"
+#include "TCG_ZoneQuery.h"
 #include "TCG_GameState.generated.h"
 
+class ACardBase;
+class ADeck;
+
+// handle, previous zone, new zone
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FOnCardZoneChanged, const FTCG_CardHandle, 
+	const ECardZone, const ECardZone);
+
 /**
  * 
  */
@@ -14,6 +27,162 @@ class TCG_SAMPLE_API ATCG_GameState : public AGameStateBase
 {
 	GENERATED_BODY()
 
+	virtual void PostInitializeComponents() override;
 	virtual void BeginPlay() override;
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+	virtual void GetLifetimeReplicatedProps(
+		TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+protected:
+	// game mode only exists on the server, clients read the phase from here
+	UPROPERTY(BlueprintReadOnly, ReplicatedUsing = OnRep_GamePhase)
+	EGamePhase GamePhase;
+
+	UFUNCTION()
+	void OnRep_GamePhase();
+
+	EGamePhase PredictedGamePhase;
+	bool bHasPredictedPhase = false;
+
+	// bumped on every server phase change, clients report their hash for it
+	UPROPERTY(ReplicatedUsing = OnRep_PhaseSerial)
+	int32 PhaseSerial = 0;
+
+	UFUNCTION()
+	void OnRep_PhaseSerial();
+
+	FTCG_StateHash StateHash;
+	EGamePhase HashedGamePhase = EGamePhase::Start;
+	void HashGamePhase();
+
+	// server side hashes at the last few phase changes
+	struct FStateHashSnapshot
+	{
+		int32 Serial = 0;
+		uint64 Partitions[FTCG_StateHash::PartitionNum][FTCG_StateHash::KeyNum] = {};
+	};
+	static constexpr int32 MaxStateHashSnapshots = 8;
+	TArray<FStateHashSnapshot> StateHashSnapshots;
+
+	// peers simulate the match from commands instead of replicated state.
+	// every peer still loads both decklists, so lockstep hides the order and
+	// the drawn cards but not which cards the opponent's deck contains
+	UPROPERTY(Replicated)
+	bool bLockstep = false;
+
+	// seat whose turn it is, INDEX_NONE before the first turn.
+	// advanced by SetGamePhase, so lockstep peers keep it themselves
+	UPROPERTY(BlueprintReadOnly, Replicated)
+	int32 ActivePlayerIndex = INDEX_NONE;
+
+	int32 NextCommandSerial = 0;
+	int32 AppliedCommandNum = 0;
+
+	UFUNCTION(NetMulticast, Reliable)
+	void Multicast_ApplyCommand(const FTCG_Command& Command);
+	void Multicast_ApplyCommand_Implementation(const FTCG_Command& Command);
+
+	UFUNCTION(NetMulticast, Reliable)
+	void Multicast_RevealCard(const int32 OwnerIndex, const int32 CardId, const ECardZone Zone);
+	void Multicast_RevealCard_Implementation(const int32 OwnerIndex, const int32 CardId, 
+		const ECardZone Zone);
+
+	void ApplyCommand(const FTCG_Command& Command);
+	int32 GetLocalPlayerIndex() const;
+
+	// transient match data, declared before its users so it outlives them
+	FTCG_MatchArena MatchArena;
+
+	// sized once so compiled queries can keep pointing into it
+	UPROPERTY(EditDefaultsOnly, Category = "Zones")
+	int32 MaxMatchCards = 128;
+
+	FTCG_ZoneIndex ZoneIndex;
+	FTCG_StatLayers StatLayers;
+
+	// server frame work in milliseconds, for load test clients.
+	// only measured and replicated in a load test session
+	UPROPERTY(Replicated)
+	float ServerTickTime = 0.0f;
+
+	bool bLoadTestSession = false;
+
+	FTimerHandle ServerTickTimeTimer;
+	void UpdateServerTickTime();
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FOnGamePhaseChanged OnGamePhaseChanged;
+
+	// after the zone index moved the card, hands follow their cards with it
+	FOnCardZoneChanged OnCardZoneChanged;
+
+	// server only, or every peer in lockstep
+	void SetGamePhase(const EGamePhase NewPhase);
+
+	// client only, shows the requested phase until the server answers
+	void PredictGamePhase(const EGamePhase TargetPhase);
+	void ClearPredictedGamePhase();
+
+	FTCG_ZoneIndex& GetZoneIndex() { return ZoneIndex; };
+	const FTCG_ZoneIndex& GetZoneIndex() const { return ZoneIndex; };
+	FTCG_StatLayers& GetStatLayers() { return StatLayers; };
+	FTCG_MatchArena& GetMatchArena() { return MatchArena; };
+
+	FTCG_CardHandle RegisterCard(const FTCG_CardEntry& Entry, const int32 OwnerIndex,
+		const ECardZone Zone);
+
+	// keeps aura targets and the state hash in sync with the zone index
+	void MoveCardZone(const FTCG_CardHandle Handle, const ECardZone Zone);
+
+	FTCG_StateHash& GetStateHash() { return StateHash; };
+
+	// server only, the player's view of the hash at that phase change
+	bool FindStateHashSnapshot(const int32 Serial, const int32 PlayerIndex, 
+		uint64& OutHash) const;
+
+	// lockstep peers apply everything in command order, otherwise only the
+	// card moves reach the owner in order with the hash request
+	uint32 GetCheckedHashKeys() const 
+	{ 
+		return bLockstep ? FTCG_StateHash::AllKeys : FTCG_StateHash::MirroredKeys; 
+	};
+
+	void DumpStateDiagnostics(const FString& Context) const;
+
+	// whether the sender's seat may issue the command right now, for
+	// lockstep commands and the predicted requests of remote players
+	bool IsCommandAllowed(const FTCG_Command& Command) const;
+
+	// server only, set by the game mode before any player joins
+	void SetLockstep(const bool bInLockstep);
+	bool IsLockstep() const { return bLockstep; };
+
+	// server only, set by the game mode before begin play
+	void SetLoadTestSession(const bool bInLoadTestSession);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	int32 GetActivePlayerIndex() const { return ActivePlayerIndex; };
+
+	// server only, validates and orders a player's command for every peer
+	void SubmitCommand(FTCG_Command Command);
+
+	// server only, shows a card to every peer without moving it. cards
+	// moving from a hidden zone to a public one are revealed by MoveCardZone
+	UFUNCTION(BlueprintCallable, Category = "Lockstep")
+	void RevealCard(ACardBase* Card);
+
+	float GetServerTickTime() const { return ServerTickTime; };
+
+	ADeck* FindDeck(const int32 OwnerIndex) const;
+	// card of any zone, looked up in its owner's deck
+	ACardBase* FindCard(const FTCG_CardHandle Handle) const;
+	class ATCG_PlayerState* FindPlayerState(const int32 PlayerIndex) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	EGamePhase GetGamePhase() const 
+	{ 
+		return bHasPredictedPhase ? PredictedGamePhase : GamePhase; 
+	};
 };
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/TimerHandle.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TCG_IdleTickSubsystem.generated.h"
+
+/**
+ * Drops a dedicated server's tick rate while the match has nothing to do.
+ * Server RPCs wake it back to the configured rate, deadlines and watched
+ * timers wake it when they come due, and it lingers awake a little so
+ * replies get flushed. An RPC arriving mid sleep waits at most one idle
+ * frame, so does a timer nobody watches.
+ */
+UCLASS()
+class TCG_SAMPLE_API UTCG_IdleTickSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// call from server RPCs and anything else that creates work
+	static void Wake(const UObject* WorldContextObject);
+
+	// wakes the world at the given world time
+	void ScheduleWake(const double Time);
+
+	// keeps the world awake ahead of each firing of the timer, looping ones included
+	void WatchTimer(const FTimerHandle& Handle);
+
+	bool IsIdle() const { return bIdle; };
+	void Report() const;
+
+	// smoothed seconds of work per frame, sleep excluded
+	double GetTickWorkTime() const { return TickWorkTime; };
+
+private:
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaTime);
+	void Resume();
+	void SetIdle(const bool bNewIdle);
+
+	bool bIdle = false;
+	double AwakeUntil = 0.0;
+	// min heap of world times
+	TArray<double> Deadlines;
+	TArray<FTimerHandle> WatchedTimers;
+
+	// net driver rate to return to, 0 until the driver is seen
+	int32 ActiveTickRate = 0;
+
+	int64 IdleFrames = 0;
+	int64 ActiveFrames = 0;
+	int32 WakeNum = 0;
+	double IdleSeconds = 0.0;
+
+	double TickStartTime = 0.0;
+	double TickWorkTime = 0.0;
+	FDelegateHandle TickStartHandle;
+};
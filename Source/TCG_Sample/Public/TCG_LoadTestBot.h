@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "TCG_Definitions.h"
+#include "TCG_LoadTestBot.generated.h"
+
+class ATCG_PlayerState;
+
+/**
+ * Plays a local player controller without input. Every interval it sends
+ * the next scripted action, or a random one, through the same player state
+ * requests the UI uses, and times each request until the server answers.
+ */
+UCLASS(ClassGroup = (TCG), meta = (BlueprintSpawnableComponent))
+class TCG_SAMPLE_API UTCG_LoadTestBot : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTCG_LoadTestBot();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// seconds between actions
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LoadTest")
+	float ActionInterval = 0.5f;
+
+	// comma separated draw, damage and phase, looped. empty picks at random
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LoadTest")
+	FString Script;
+
+	int32 GetActionNum() const { return ActionNum; };
+
+	// round trips since the last call, in milliseconds
+	void TakeLatencySamples(TArray<double>& OutSamples);
+
+private:
+	void PerformAction();
+	void OnActionReconciled(const FPredictedAction& Action);
+
+	ATCG_PlayerState* BindPlayerState();
+
+	TArray<FString> ScriptSteps;
+	int32 ScriptIndex = 0;
+
+	TWeakObjectPtr<ATCG_PlayerState> BoundPlayerState;
+	FDelegateHandle ReconciledHandle;
+	FTimerHandle ActionTimer;
+
+	TArray<double> LatencySamples;
+	int32 ActionNum = 0;
+};
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "TCG_LoadTestSubsystem.generated.h"
+
+/**
+ * Headless load test client. Started with -TCGBots=N it ramps up to N bot
+ * players, one extra split screen guest every -TCGBotRamp seconds. Each bot
+ * is its own player in the server's game code, but all of them share this
+ * process' one connection, so the server sees one connection per process.
+ * Every report interval it logs this process' concurrency, request round
+ * trip percentiles, the server's frame work time and the bandwidth of its
+ * connection. Connection load scales with processes, reports are merged
+ * by process id afterwards.
+ *
+ * Client:  TCG_Sample 127.0.0.1 -nullrhi -nosound -unattended -TCGBots=64
+ * Server:  TCG_SampleServer L_Testmap -TCGLoadTest -ini:Game:[/Script/Engine.GameSession]:MaxPlayers=1024,
+ *          [/Script/Engine.GameSession]:MaxSplitscreensPerConnection=64
+ * -TCGLoadTest seats every bot, those past the two decks draw nothing,
+ * and sends the server frame work time to the clients.
+ */
+UCLASS()
+class TCG_SAMPLE_API UTCG_LoadTestSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// raises the bot target, the ramp adds them over time
+	void AddBots(const int32 Num);
+	void Report();
+
+private:
+	bool Tick(float DeltaTime);
+	void AttachBots();
+	void SpawnGuest();
+
+	int32 TargetBotNum = 0;
+	float RampInterval = 1.0f;
+	float ActionInterval = 0.5f;
+	FString Script;
+
+	double LastSpawnTime = 0.0;
+	double LastReportTime = 0.0;
+	int32 ActionNumAtReport = 0;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_Definitions.h"
+
+// one untapped mana producer, lands produce a single color
+// but the mask leaves room for dual lands
+struct FTCG_ManaSource
+{
+	int32 SourceId = INDEX_NONE;
+	uint8 ColorMask = 0;
+
+	static uint8 ToMask(const EManaType ManaType) 
+	{ 
+		return static_cast<uint8>(1u << static_cast<uint8>(ManaType)); 
+	};
+};
+
+struct FTCG_ManaPayment
+{
+	bool bPayable = false;
+	// which of the alternative costs to pay
+	int32 OptionIndex = INDEX_NONE;
+	TArray<int32> TappedSources;
+	// future costs still payable with what is left untapped
+	int32 FuturePlays = 0;
+};
+
+/**
+ * Decides whether a cost can be paid from the untapped sources and which
+ * sources to tap so the most other plays stay available. Identical sources
+ * are grouped and assignments are found by memoized search over the
+ * remaining requirement, so the work depends on distinct source kinds 
+ * rather than on the number of lands.
+ */
+class TCG_SAMPLE_API FTCG_ManaSolver
+{
+public:
+	static constexpr int32 MaxManaTypes = 8;
+	static constexpr int32 MaxSourceGroups = 8;
+
+	void SetSources(const TArray<FTCG_ManaSource>& Sources);
+
+	bool CanPay(const FManaCost& Cost);
+	bool CanPayAny(const TArray<FManaCost>& Options);
+
+	// picks the option and sources that keep the most of FutureCosts payable
+	FTCG_ManaPayment Solve(const TArray<FManaCost>& Options, 
+		const TArray<const TArray<FManaCost>*>& FutureCosts);
+
+private:
+	struct FSourceGroup
+	{
+		uint8 ColorMask = 0;
+		TArray<int32> SourceIds;
+	};
+
+	// 8 bits per color / per group
+	using FPackedCounts = uint64;
+
+	static FPackedCounts PackCost(const FManaCost& Cost, bool& bOutOverflow);
+	static int32 GetCount(const FPackedCounts Packed, const int32 Slot);
+	static FPackedCounts SetCount(const FPackedCounts Packed, const int32 Slot, 
+		const int32 Count);
+
+	// every untapped count of groups from GroupIndex on that can remain 
+	// after paying Requirement
+	TArray<FPackedCounts> GetLeftovers(const int32 GroupIndex, 
+		const FPackedCounts Requirement);
+	void DistributeGroup(const int32 GroupIndex, const int32 ColorSlot, const int32 Left,
+		const FPackedCounts Requirement, TArray<FPackedCounts>& OutLeftovers);
+
+	bool CanPayFrom(const FPackedCounts Counts, const FPackedCounts Requirement) const;
+	bool PayRecursive(const FPackedCounts Counts, const int32 GroupIndex, 
+		const int32 ColorSlot, const int32 Left, const FPackedCounts Requirement) const;
+
+	TArray<FSourceGroup> Groups;
+	FPackedCounts GroupCounts = 0;
+
+	TMap<TPair<int32, FPackedCounts>, TArray<FPackedCounts>> LeftoverMemo;
+	TMap<FPackedCounts, bool> PayableCache;
+};
@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// canaries, fill patterns and generation checks
+#define TCG_ARENA_DEBUG (!UE_BUILD_SHIPPING && !UE_BUILD_TEST)
+
+struct FTCG_MatchArenaStats
+{
+	int64 UsedBytes = 0;
+	int64 PeakUsedBytes = 0;
+	int64 ReservedBytes = 0;
+	int32 Allocations = 0;
+	int32 InPlaceGrows = 0;
+	int32 BlockNum = 0;
+};
+
+/**
+ * Linear allocator for transient match data, released in one shot when
+ * the match ends. Blocks go back to a process wide cache instead of the
+ * heap, so matches reuse the same fixed size blocks and don't fragment.
+ * Nothing is freed individually, only the latest allocation can grow in place.
+ */
+class TCG_SAMPLE_API FTCG_MatchArena
+{
+public:
+	static constexpr int32 BlockSize = 64 * 1024;
+	static constexpr int32 MaxCachedBlocks = 256;
+
+	FTCG_MatchArena() = default;
+	~FTCG_MatchArena();
+
+	FTCG_MatchArena(const FTCG_MatchArena&) = delete;
+	FTCG_MatchArena& operator=(const FTCG_MatchArena&) = delete;
+
+	void* Allocate(const SIZE_T Size, const uint32 Alignment);
+	// grows in place when Ptr is the latest allocation, copies otherwise
+	void* Reallocate(void* Ptr, const SIZE_T OldSize, const SIZE_T NewSize, 
+		const uint32 Alignment);
+
+	template <typename T, typename... ArgsType>
+	T* New(ArgsType&&... Args)
+	{
+		static_assert(TIsTriviallyDestructible<T>::Value, 
+			"Arena objects are never destructed");
+		return new (Allocate(sizeof(T), alignof(T))) T(Forward<ArgsType>(Args)...);
+	}
+
+	// releases every allocation, anything still pointing into the arena is stale
+	void Reset();
+
+	// checks every canary, returns false on an overflow
+	bool Validate() const;
+
+	uint32 GetGeneration() const { return Generation; };
+	const FTCG_MatchArenaStats& GetStats() const { return Stats; };
+
+	// arena picked up by FTCG_ArenaAllocator containers on this thread
+	static FTCG_MatchArena* GetCurrent();
+
+	class FScope
+	{
+	public:
+		explicit FScope(FTCG_MatchArena& Arena);
+		~FScope();
+
+	private:
+		FTCG_MatchArena* Previous;
+	};
+
+private:
+	struct FBlock
+	{
+		uint8* Data = nullptr;
+		int32 Size = 0;
+	};
+
+	uint8* AllocateFromBlocks(const SIZE_T Size, const uint32 Alignment);
+	void AddBlock(const SIZE_T MinSize);
+
+	static uint8* AcquireBlock();
+	static void ReleaseBlock(uint8* Data);
+
+	TArray<FBlock> Blocks;
+	uint8* Cursor = nullptr;
+	uint8* End = nullptr;
+	uint8* LastAllocation = nullptr;
+	uint32 Generation = 1;
+	FTCG_MatchArenaStats Stats;
+
+#if TCG_ARENA_DEBUG
+	void WriteCanary(uint8* At);
+	TArray<uint8*> Canaries;
+#endif
+};
+
+/**
+ * TArray allocator backed by the current match arena. Containers first
+ * allocated outside an FTCG_MatchArena::FScope use the heap, so types
+ * holding them also work away from a match.
+ */
+class TCG_SAMPLE_API FTCG_ArenaAllocator
+{
+public:
+	using SizeType = int32;
+
+	enum { NeedsElementType = true };
+	enum { RequireRangeCheck = true };
+
+	template <typename ElementType>
+	class ForElementType
+	{
+	public:
+		ForElementType() = default;
+
+		~ForElementType()
+		{
+			CheckGeneration();
+			if (!Arena && Data)
+			{
+				FMemory::Free(Data);
+			}
+		}
+
+		void MoveToEmpty(ForElementType& Other)
+		{
+			checkSlow(this != &Other);
+			if (!Arena && Data)
+			{
+				FMemory::Free(Data);
+			}
+
+			Data = Other.Data;
+			Arena = Other.Arena;
+			AllocatedBytes = Other.AllocatedBytes;
+#if TCG_ARENA_DEBUG
+			Generation = Other.Generation;
+#endif
+			Other.Data = nullptr;
+			Other.Arena = nullptr;
+			Other.AllocatedBytes = 0;
+		}
+
+		ElementType* GetAllocation() const { return Data; }
+
+		void ResizeAllocation(SizeType PreviousNumElements, SizeType NumElements, 
+			SIZE_T NumBytesPerElement)
+		{
+			CheckGeneration();
+			const SIZE_T NewBytes = static_cast<SIZE_T>(NumElements) * NumBytesPerElement;
+
+			if (!Data)
+			{
+				Arena = FTCG_MatchArena::GetCurrent();
+#if TCG_ARENA_DEBUG
+				Generation = Arena ? Arena->GetGeneration() : 0;
+#endif
+			}
+
+			if (Arena)
+			{
+				// shrinking keeps the memory, the arena never frees single blocks
+				if (NewBytes > AllocatedBytes)
+				{
+					Data = static_cast<ElementType*>(
+						Arena->Reallocate(Data, AllocatedBytes, NewBytes, GetAlignment()));
+					AllocatedBytes = NewBytes;
+				}
+			}
+			else if (NewBytes > 0)
+			{
+				Data = static_cast<ElementType*>(FMemory::Realloc(Data, NewBytes, GetAlignment()));
+				AllocatedBytes = NewBytes;
+			}
+			else if (Data)
+			{
+				FMemory::Free(Data);
+				Data = nullptr;
+				AllocatedBytes = 0;
+			}
+		}
+
+		SizeType CalculateSlackReserve(SizeType NumElements, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackReserve(NumElements, NumBytesPerElement, false, GetAlignment());
+		}
+
+		SizeType CalculateSlackShrink(SizeType NumElements, SizeType NumAllocatedElements, 
+			SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackShrink(NumElements, NumAllocatedElements, 
+				NumBytesPerElement, false, GetAlignment());
+		}
+
+		SizeType CalculateSlackGrow(SizeType NumElements, SizeType NumAllocatedElements, 
+			SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackGrow(NumElements, NumAllocatedElements, 
+				NumBytesPerElement, false, GetAlignment());
+		}
+
+		SIZE_T GetAllocatedSize(SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const
+		{
+			return NumAllocatedElements * NumBytesPerElement;
+		}
+
+		bool HasAllocation() const { return Data != nullptr; }
+		SizeType GetInitialCapacity() const { return 0; }
+
+	private:
+		ForElementType(const ForElementType&) = delete;
+		ForElementType& operator=(const ForElementType&) = delete;
+
+		static constexpr uint32 GetAlignment()
+		{
+			return FMath::Max<uint32>(alignof(ElementType), 8);
+		}
+
+		void CheckGeneration() const
+		{
+#if TCG_ARENA_DEBUG
+			checkf(!Arena || Arena->GetGeneration() == Generation,
+				TEXT("Container used after its match arena was reset"));
+#endif
+		}
+
+		ElementType* Data = nullptr;
+		FTCG_MatchArena* Arena = nullptr;
+		SIZE_T AllocatedBytes = 0;
+#if TCG_ARENA_DEBUG
+		uint32 Generation = 0;
+#endif
+	};
+
+	typedef ForElementType<FScriptContainerElement> ForAnyElementType;
+};
+
+template <>
+struct TAllocatorTraits<FTCG_ArenaAllocator> : TAllocatorTraitsBase<FTCG_ArenaAllocator>
+{
+	enum { SupportsMove = true };
+	enum { IsZeroConstruct = false };
+};
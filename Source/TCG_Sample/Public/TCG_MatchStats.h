@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+#include "TCG_Definitions.h"
+
+DECLARE_STATS_GROUP(TEXT("TCG"), STATGROUP_TCG, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RequestPhaseChange"), STAT_TCG_RequestPhaseChange, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Draw"), STAT_TCG_Draw, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shuffle"), STAT_TCG_Shuffle, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ReturnCard"), STAT_TCG_ReturnCard, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Req_Damage"), STAT_TCG_Req_Damage, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_Hitpoint"), STAT_TCG_OnRep_Hitpoint, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_PlayerIndex"), STAT_TCG_OnRep_PlayerIndex, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_GamePhase"), STAT_TCG_OnRep_GamePhase, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_PhaseSerial"), STAT_TCG_OnRep_PhaseSerial, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnVoidDrawCount"), STAT_TCG_OnVoidDrawCount, STATGROUP_TCG, TCG_SAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_ShuffleSeed"), STAT_TCG_OnRep_ShuffleSeed, STATGROUP_TCG, TCG_SAMPLE_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(TCG_SAMPLE_API, TCG);
+
+// stat group, csv profiler and per match timing in one scope, game thread only
+#define TCG_SCOPE_HOTSPOT(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_TCG_##Name); \
+	CSV_SCOPED_TIMING_STAT(TCG, Name); \
+	static const FName TCG_HotspotName_##Name(TEXT(#Name)); \
+	FTCG_MatchStats::FHotspotScope TCG_HotspotScope_##Name(TCG_HotspotName_##Name)
+
+// received RPCs, placed at the top of the implementation
+#define TCG_COUNT_RPC(Name) \
+	static const FName TCG_RpcName(TEXT(#Name)); \
+	FTCG_MatchStats::CountRpc(TCG_RpcName)
+
+/**
+ * Counters of the running match, reset when a game state begins play.
+ * Hot spot timings, RPCs received by name, time spent in each phase and
+ * net bytes since the match started. The packed serializers add their
+ * per struct bits. Replicated bytes by class and property aren't counted,
+ * the engine has no hook for them outside its net trace: run the server
+ * with -NetTrace=1 -trace=net and read them in Networking Insights.
+ *
+ * One world owns the match, the server's when several run in this
+ * process (PIE), so client worlds neither reset it nor count phases twice.
+ * Hot spots and RPCs are counted for every world of the process.
+ */
+struct TCG_SAMPLE_API FTCG_MatchStats
+{
+	struct FHotspotScope
+	{
+		explicit FHotspotScope(const FName InName);
+		~FHotspotScope();
+
+		FName Name;
+		uint64 StartCycles;
+	};
+
+	// ignored while another world with authority owns the match
+	static void BeginMatch(const UWorld* World);
+	// writes the csv when tcg.Stats.ExportOnMatchEnd is set
+	static void EndMatch(const UWorld* World);
+	static void CountRpc(const FName Name);
+	// only counted for the world that owns the match
+	static void EnterPhase(const UWorld* World, const EGamePhase Phase);
+
+	// top offenders of each kind to the log
+	static void Dump(const UWorld* World, const int32 TopNum = 10);
+	// empty path writes to Saved/Profiling, returns the file written
+	static FString ExportCsv(const UWorld* World, const FString& Path = FString());
+};
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// low level memory tracker tags, shown under TCG/ in memreport, stat LLM
+// and Insights. run with -llm to track them
+LLM_DECLARE_TAG_API(TCG, TCG_SAMPLE_API);
+LLM_DECLARE_TAG_API(TCG_Cards, TCG_SAMPLE_API);
+LLM_DECLARE_TAG_API(TCG_Decks, TCG_SAMPLE_API);
+LLM_DECLARE_TAG_API(TCG_Hands, TCG_SAMPLE_API);
+LLM_DECLARE_TAG_API(TCG_Sessions, TCG_SAMPLE_API);
+LLM_DECLARE_TAG_API(TCG_Match, TCG_SAMPLE_API);
+
+/**
+ * Reads the TCG and TweenMaker tags back, so soak runs can assert a
+ * budget per tag and see which one grows since a baseline.
+ */
+struct TCG_SAMPLE_API FTCG_MemoryTags
+{
+	// bytes currently tracked, -1 while the tracker is off
+	static int64 GetTagBytes(const FName TagName);
+	// every TCG and TweenMaker tag together
+	static int64 GetTotalBytes();
+
+	static void SetBaseline();
+	static void Report();
+
+	// budgets in MB by tag name, false if any tag is over
+	static bool CheckBudgets(const TMap<FName, double>& BudgetOverrides);
+};
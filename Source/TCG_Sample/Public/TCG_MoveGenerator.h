@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_Definitions.h"
+#include "TCG_ManaSolver.h"
+
+class ACardBase;
+class FTCG_CardDatabase;
+
+struct FTCG_LegalMove
+{
+	const ACardBase* Card = nullptr;
+	// null for plays without a target
+	AActor* Target = nullptr;
+	FTCG_ManaPayment Payment;
+};
+
+/**
+ * Answers "what can be played right now" from cached per card results.
+ * Each setter only invalidates what depends on it: a hand change evaluates
+ * the new card, a mana change re-checks costs, a board change only swaps
+ * the target list. Payments are picked lazily when moves are listed.
+ */
+class TCG_SAMPLE_API FTCG_MoveGenerator
+{
+public:
+	// true when the database changed and the hand was evaluated again
+	bool SetCardDatabase(const FTCG_CardDatabase* InCardDatabase);
+
+	void SetPhase(const EGamePhase InPhase);
+	void AddHandCard(const ACardBase* Card);
+	void RemoveHandCard(const ACardBase* Card);
+	void SetManaSources(const TArray<FTCG_ManaSource>& Sources);
+	void SetTargets(const TArray<AActor*>& InTargets);
+	void SetLandPlayed(const bool bInLandPlayed);
+
+	bool IsPlayable(const ACardBase* Card) const;
+	// cheap enough for every frame
+	void GetPlayableCards(TArray<const ACardBase*>& OutCards) const;
+	// full (card, target, payment) list for bots
+	void GetLegalMoves(TArray<FTCG_LegalMove>& OutMoves);
+
+	// how many card evaluations the cache saved, for profiling
+	int32 GetEvaluations() const { return Evaluations; };
+	int32 GetCacheHits() const { return CacheHits; };
+
+private:
+	// weak, the generator lives outside UObject and cards may be destroyed
+	struct FCardMoves
+	{
+		TWeakObjectPtr<const ACardBase> Card;
+		ECardType CardType = ECardType::Minion;
+		TArray<FManaCost> Costs;
+		bool bKnown = false;
+		bool bPayable = false;
+		bool bPaymentValid = false;
+		FTCG_ManaPayment Payment;
+	};
+
+	bool IsMainPhase() const { return Phase == EGamePhase::TurnOngoing; };
+	void Evaluate(FCardMoves& Moves);
+	void UpdatePayment(FCardMoves& Moves);
+	bool IsCardPlayable(const FCardMoves& Moves) const;
+
+	const FTCG_CardDatabase* CardDatabase = nullptr;
+	FTCG_ManaSolver ManaSolver;
+
+	EGamePhase Phase = EGamePhase::Start;
+	bool bLandPlayed = false;
+	TArray<FCardMoves> Hand;
+	TArray<TWeakObjectPtr<AActor>> Targets;
+
+	int32 Evaluations = 0;
+	int32 CacheHits = 0;
+};
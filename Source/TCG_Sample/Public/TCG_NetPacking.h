@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// the saving side counters run on every NetSerialize, kept out of shipping
+#define TCG_NET_PACKING_STATS (!UE_BUILD_SHIPPING)
+
+// serializers reporting to the packing stats
+enum class ETCG_PackedStruct : uint8
+{
+	ManaCost,
+	CardHandle,
+	Hitpoint,
+	Command,
+	SpectatorEvent,
+	Num
+};
+
+/**
+ * Bit packing helpers shared by the custom NetSerialize functions.
+ * Each helper returns the bits it wrote so serializers can report
+ * what they saved against the default property encoding.
+ */
+struct TCG_SAMPLE_API FTCG_NetPacking
+{
+	// one bit
+	static bool SerializeFlag(FArchive& Ar, const bool bFlag);
+
+	// 7 bit groups, small values take 8 bits
+	static int32 SerializeUnsigned(FArchive& Ar, int32& Value);
+	// zigzag first, so small negative deltas stay small
+	static int32 SerializeSigned(FArchive& Ar, int32& Value);
+	// fixed width for [0, MaxValue], out of range values are clamped
+	static int32 SerializeQuantized(FArchive& Ar, int32& Value, const int32 MaxValue);
+
+	// saving side only, tcg.Net.Report prints the totals. lock free, no-op in shipping
+	static void Record(const ETCG_PackedStruct Struct, const int32 PackedBits, 
+		const int32 DefaultBits)
+	{
+#if TCG_NET_PACKING_STATS
+		RecordStats(Struct, PackedBits, DefaultBits);
+#endif
+	}
+	static void Report();
+	static void ResetStats();
+	static void ForEachStat(TFunctionRef<void(const FString& Category, const int64 Count, 
+		const int64 PackedBits, const int64 DefaultBits)> Visitor);
+
+private:
+	static void RecordStats(const ETCG_PackedStruct Struct, const int32 PackedBits, 
+		const int32 DefaultBits);
+};
@@ -4,13 +4,20 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerState.h"
+#include "TCG_Definitions.h"
 #include "TCG_PlayerState.generated.h"
 
+class ADeck;
+class ACardBase;
+
 /**
  * 
  */
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHitpointChanged, int32, ChangedHitpoint);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPredictionRejected, 
+	const FPredictedAction&, RejectedAction);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnActionReconciled, const FPredictedAction&);
 
 UCLASS()
 class TCG_SAMPLE_API ATCG_PlayerState : public APlayerState
@@ -21,17 +28,76 @@ class TCG_SAMPLE_API ATCG_PlayerState : public APlayerState
 	virtual void EndPlay(EEndPlayReason::Type EndPlayReason);
 	virtual void GetLifetimeReplicatedProps(
 		TArray<FLifetimeProperty>& OutLifetimeProps) const;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 protected:
-	UPROPERTY(BlueprintReadOnly, EditAnywhere, ReplicatedUsing = OnRep_Hitpoint)
+	// local value, includes predicted damage on the owning client
+	UPROPERTY(BlueprintReadOnly, EditAnywhere)
 	int32 Hitpoint;
 
+	// server value, packed on the wire
+	UPROPERTY(ReplicatedUsing = OnRep_Hitpoint)
+	FTCG_NetHitpoint ReplicatedHitpoint;
+
 	UFUNCTION()
 	void OnRep_Hitpoint();
 
+	// seat in the match, decks with the same OwnerIndex belong to this player.
+	// INDEX_NONE for spectators and until the game mode seats the player
+	UPROPERTY(BlueprintReadOnly, ReplicatedUsing = OnRep_PlayerIndex)
+	int32 PlayerIndex = INDEX_NONE;
+
+	UFUNCTION()
+	void OnRep_PlayerIndex(const int32 OldPlayerIndex);
+
+	// value currently folded into the state hash
+	int32 HashedHitpoint = 0;
+	void HashHitpoint();
+
+	// actions applied locally and still waiting for the server
+	UPROPERTY(BlueprintReadOnly, Category = "Prediction")
+	TArray<FPredictedAction> PendingPredictions;
+
+	int32 NextPredictionKey = 0;
+
+	// newest server hitpoint the owner knows of, from replication or a
+	// reconcile, whichever carries the later prediction key
+	int32 AckedPredictionKey = 0;
+	int32 AckedHitpoint = 0;
+	void AcknowledgeHitpoint(const int32 PredictionKey, const int32 AuthoritativeHitpoint);
+
+	int32 AddPrediction(const EPredictedAction Action, const int32 PredictedValue,
+		const int32 Delta = 0, ACardBase* PredictedCard = nullptr, ADeck* Deck = nullptr);
+
+	// acknowledged hitpoint with damage predicted after it on top
+	int32 GetPredictedHitpoint() const;
+
+	// lockstep matches send this instead of predicting
+	void SubmitCommand(const ETCG_CommandType Type, const int32 Value);
+
+	// server, same seat, turn and phase rules as lockstep commands.
+	// the listen host's and standalone player's own requests are trusted
+	bool IsRequestAllowed(const ETCG_CommandType Type, const int32 Value) const;
+
 public:
+	void ApplyDamage(const int32 Damage);
+
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	const int32 GetHitpoint() { return Hitpoint; };
+	const int32 GetHitpoint() const { return Hitpoint; };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	int32 GetPlayerIndex() const { return PlayerIndex; };
+
+	// server only
+	void SetPlayerIndex(const int32 NewPlayerIndex);
+
+	// owning client, sends its view of the state hash for a phase change
+	void ReportStateHash(const int32 PhaseSerial);
+
+	// server asks after a phase change outside lockstep
+	UFUNCTION(Client, Reliable)
+	void Client_ReportStateHash(const int32 PhaseSerial);
+	void Client_ReportStateHash_Implementation(const int32 PhaseSerial);
 
 	UFUNCTION(Server, Reliable, BlueprintCallable)
 	void Req_Damage(const int32& Damage);
@@ -39,4 +105,69 @@ public:
 
 	UPROPERTY(BlueprintAssignable)
 	FOnHitpointChanged OnHitpointChanged;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnPredictionRejected OnPredictionRejected;
+
+	// every answered prediction, matching or not
+	FOnActionReconciled OnActionReconciled;
+
+	// predicted versions of the requests above, they take effect on 
+	// the owning client right away and get corrected if the server disagrees
+	UFUNCTION(BlueprintCallable, Category = "Prediction")
+	void RequestDraw(ADeck* Deck);
+
+	UFUNCTION(BlueprintCallable, Category = "Prediction")
+	void RequestPhaseChange(const EGamePhase TargetPhase);
+
+	UFUNCTION(BlueprintCallable, Category = "Prediction")
+	void RequestDamage(const int32 Damage);
+
+protected:
+	UFUNCTION(Server, Reliable)
+	void Server_RequestDraw(const int32 PredictionKey, ADeck* Deck);
+	void Server_RequestDraw_Implementation(const int32 PredictionKey, ADeck* Deck);
+
+	UFUNCTION(Server, Reliable)
+	void Server_RequestPhaseChange(const int32 PredictionKey, const EGamePhase TargetPhase);
+	void Server_RequestPhaseChange_Implementation(const int32 PredictionKey, 
+		const EGamePhase TargetPhase);
+
+	UFUNCTION(Server, Reliable)
+	void Server_RequestDamage(const int32 PredictionKey, const int32 Damage);
+	void Server_RequestDamage_Implementation(const int32 PredictionKey, const int32 Damage);
+
+	// cards travel as packed handles instead of object references
+	UFUNCTION(Client, Reliable)
+	void Client_ReconcileAction(const int32 PredictionKey, const int32 AuthoritativeValue,
+		const FTCG_CardHandle AuthoritativeCard);
+	void Client_ReconcileAction_Implementation(const int32 PredictionKey, 
+		const int32 AuthoritativeValue, const FTCG_CardHandle AuthoritativeCard);
+
+	UFUNCTION(Server, Reliable)
+	void Server_SubmitCommand(const FTCG_Command& Command);
+	void Server_SubmitCommand_Implementation(const FTCG_Command& Command);
+
+public:
+	// lockstep, the deck order is only shared with its owner
+	UFUNCTION(Client, Reliable)
+	void Client_SetDeckSeed(ADeck* Deck, const int32 Seed);
+	void Client_SetDeckSeed_Implementation(ADeck* Deck, const int32 Seed);
+
+	// server side library changes, ordered with the reconciles
+	UFUNCTION(Client, Reliable)
+	void Client_MirrorDeck(ADeck* Deck, const FTCG_DeckMutation& Mutation);
+	void Client_MirrorDeck_Implementation(ADeck* Deck, const FTCG_DeckMutation& Mutation);
+
+protected:
+	UFUNCTION(Server, Reliable)
+	void Server_ReportStateHash(const int32 PhaseSerial, const uint64 ClientHash);
+	void Server_ReportStateHash_Implementation(const int32 PhaseSerial, 
+		const uint64 ClientHash);
+
+	// desync found, the client logs its side for comparison
+	UFUNCTION(Client, Reliable)
+	void Client_DumpStateDiagnostics(const int32 PhaseSerial, const uint64 ServerHash);
+	void Client_DumpStateDiagnostics_Implementation(const int32 PhaseSerial, 
+		const uint64 ServerHash);
 };
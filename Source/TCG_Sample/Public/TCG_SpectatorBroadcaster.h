@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TCG_Definitions.h"
+#include "TCG_ZoneQuery.h"
+#include "TCG_SpectatorBroadcaster.generated.h"
+
+class UTCG_SpectatorComponent;
+
+UENUM(BlueprintType)
+enum class ETCG_SpectatorEventType : uint8
+{
+	PhaseChanged,
+	HitpointChanged,
+	// CardId is 0 while the card is in a hidden zone
+	CardMoved,
+};
+
+USTRUCT(BlueprintType)
+struct FTCG_SpectatorEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Sequence = 0;
+	UPROPERTY(BlueprintReadOnly)
+	ETCG_SpectatorEventType Type = ETCG_SpectatorEventType::PhaseChanged;
+	UPROPERTY(BlueprintReadOnly)
+	int32 PlayerIndex = 0;
+	// phase, hitpoint or card handle
+	UPROPERTY(BlueprintReadOnly)
+	int32 Value = 0;
+	UPROPERTY(BlueprintReadOnly)
+	ECardZone Zone = ECardZone::Library;
+	UPROPERTY(BlueprintReadOnly)
+	int32 CardId = 0;
+
+	// server time the event happened, the broadcast delay counts from here
+	double Time = 0.0;
+
+	// bit packed, the sequence is implied by the packet. hitpoints go as
+	// deltas from the baseline the receiver already holds, returns the bits
+	int32 NetSerialize(FArchive& Ar, const struct FTCG_SpectatorState& Baseline);
+};
+
+// public match state as spectators see it, rebuilt from events
+struct TCG_SAMPLE_API FTCG_SpectatorState
+{
+	struct FPublicCard
+	{
+		int32 PlayerIndex = 0;
+		ECardZone Zone = ECardZone::Library;
+		int32 CardId = 0;
+	};
+
+	int32 LastSequence = 0;
+	EGamePhase Phase = EGamePhase::Start;
+	int32 Hitpoints[FTCG_ZoneIndex::MaxPlayers] = {};
+	TMap<int32, FPublicCard> Cards;
+
+	void Apply(const FTCG_SpectatorEvent& Event);
+	void Serialize(FArchive& Ar);
+};
+
+using FTCG_SharedPacket = TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>;
+
+/**
+ * Server side spectator channel. Public game events are queued, held back
+ * by the broadcast delay, then serialized once per flush into a shared
+ * buffer every spectator gets a reference to. Late joiners get a snapshot
+ * of the delayed state, also built once and shared until the next flush.
+ */
+UCLASS()
+class TCG_SAMPLE_API UTCG_SpectatorBroadcaster : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void QueuePhaseChanged(const EGamePhase Phase);
+	void QueueHitpointChanged(const int32 PlayerIndex, const int32 Hitpoint);
+	void QueueCardMoved(const int32 PlayerIndex, const FTCG_CardHandle Handle, 
+		const ECardZone Zone, const int32 CardId);
+
+	void AddSpectator(UTCG_SpectatorComponent* Spectator);
+	void RemoveSpectator(UTCG_SpectatorComponent* Spectator);
+
+	int32 GetSpectatorNum() const { return Spectators.Num(); };
+	// serializations saved by sharing, for profiling
+	int32 GetSharedSends() const { return SharedSends; };
+
+	static bool IsPublicZone(const ECardZone Zone);
+
+private:
+	void QueueEvent(FTCG_SpectatorEvent& Event);
+	void Flush(const double Now);
+	FTCG_SharedPacket GetSnapshot();
+
+	TArray<FTCG_SpectatorEvent> PendingEvents;
+	int32 NextSequence = 1;
+
+	// delayed state, what a joining spectator starts from
+	FTCG_SpectatorState DelayedState;
+	TOptional<FTCG_SharedPacket> CachedSnapshot;
+
+	TArray<TWeakObjectPtr<UTCG_SpectatorComponent>> Spectators;
+	int32 SharedSends = 0;
+};
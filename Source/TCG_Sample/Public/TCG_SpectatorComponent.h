@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "TCG_SpectatorBroadcaster.h"
+#include "TCG_SpectatorComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSpectatorEvent, 
+	const FTCG_SpectatorEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSpectatorSnapshot);
+
+/**
+ * Lives on a spectator's player controller. The server side pushes shared
+ * packets from the broadcaster, queued while the connection is saturated.
+ * The client side decodes them into a mirror of the public state.
+ */
+UCLASS(ClassGroup = (TCG), meta = (BlueprintSpawnableComponent))
+class TCG_SAMPLE_API UTCG_SpectatorComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UTCG_SpectatorComponent();
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// server side
+	void SendPacket(const FTCG_SharedPacket& Packet);
+	void SendSnapshot(const FTCG_SharedPacket& Snapshot);
+	void FlushPending();
+	bool HasSnapshot() const { return bSnapshotSent; };
+
+	UPROPERTY(BlueprintAssignable)
+	FOnSpectatorEvent OnSpectatorEvent;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnSpectatorSnapshot OnSpectatorSnapshot;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	EGamePhase GetPhase() const { return State.Phase; };
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	int32 GetHitpoint(const int32 PlayerIndex) const;
+
+	const FTCG_SpectatorState& GetState() const { return State; };
+
+protected:
+	UFUNCTION(Server, Reliable)
+	void Server_RequestSnapshot();
+	void Server_RequestSnapshot_Implementation();
+
+	UFUNCTION(Client, Reliable)
+	void Client_ReceiveSnapshot(const TArray<uint8>& Snapshot);
+	void Client_ReceiveSnapshot_Implementation(const TArray<uint8>& Snapshot);
+
+	UFUNCTION(Client, Reliable)
+	void Client_ReceivePacket(const TArray<uint8>& Packet);
+	void Client_ReceivePacket_Implementation(const TArray<uint8>& Packet);
+
+	bool IsConnectionReady() const;
+
+	// server side
+	TArray<FTCG_SharedPacket> PendingPackets;
+	bool bSnapshotSent = false;
+
+	// client side
+	FTCG_SpectatorState State;
+};
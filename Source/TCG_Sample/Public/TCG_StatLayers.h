@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_CardBitset.h"
+#include "TCG_Definitions.h"
+#include "TCG_ZoneQuery.h"
+
+// applied in this order, set effects overwrite, the others add up
+enum class ETCG_StatLayer : uint8
+{
+	Set,
+	Modify,
+	Aura,
+};
+
+struct FTCG_StatEffect
+{
+	ETCG_StatLayer Layer = ETCG_StatLayer::Modify;
+	int32 Attack = 0;
+	int32 HitPoint = 0;
+};
+
+struct FTCG_StatLayerStats
+{
+	int32 Reads = 0;
+	int32 CacheHits = 0;
+	int32 Recomputes = 0;
+	// what recomputing every card on every change would have cost
+	int32 NaiveRecomputes = 0;
+	int32 VerifyFailures = 0;
+};
+
+/**
+ * Current attack/hitpoint of minions from base stats plus continuous effects.
+ * Each card keeps the list of effects contributing to it, a change only
+ * marks those cards dirty and the value is recomputed on the next read.
+ * With a zone index attached, the next query on attack or hitpoint pushes
+ * the cards changed since into its stat buckets first.
+ * tcg.StatLayers.Verify checks every read against a full recompute,
+ * tcg.StatLayers.VerifyAll checks every card of the running match once.
+ */
+class TCG_SAMPLE_API FTCG_StatLayers
+{
+public:
+	void Init(const int32 InMaxCards, FTCG_ZoneIndex* InZoneIndex = nullptr);
+	void Reset();
+
+	void SetBaseStats(const FTCG_CardHandle Handle, const int32 Attack, const int32 HitPoint);
+
+	// returns an id for RemoveEffect
+	int32 AddEffect(const FTCG_StatEffect& Effect, const TArray<FTCG_CardHandle>& Targets);
+	// targets follow the query, call RefreshAuras after zone moves
+	int32 AddAura(const FTCG_StatEffect& Effect, const FTCG_CompiledQuery& Query);
+	void RemoveEffect(const int32 EffectId);
+
+	// only cards entering or leaving an aura get dirty
+	void RefreshAuras();
+
+	int32 GetAttack(const FTCG_CardHandle Handle);
+	int32 GetHitPoint(const FTCG_CardHandle Handle);
+
+	// full recompute of every card, returns the number of mismatches
+	int32 VerifyAll();
+
+	// recomputes the cards changed since the last flush into the zone index's stat buckets
+	void FlushToZoneIndex();
+
+	const FTCG_StatLayerStats& GetStats() const { return Stats; };
+	void ResetStats() { Stats = FTCG_StatLayerStats(); };
+
+private:
+	struct FCardStats
+	{
+		bool bRegistered = false;
+		bool bDirty = false;
+		// changed since the zone index last got its stats
+		bool bPendingZoneIndex = false;
+		int32 BaseAttack = 0;
+		int32 BaseHitPoint = 0;
+		int32 Attack = 0;
+		int32 HitPoint = 0;
+		// contributing effects, kept sorted so layers apply in a fixed order
+		TArray<int32, TInlineAllocator<4, FTCG_ArenaAllocator>> EffectIds;
+	};
+
+	struct FEffect
+	{
+		FTCG_StatEffect Stat;
+		bool bAura = false;
+		FTCG_CompiledQuery Query;
+		FTCG_CardBitset Targets;
+	};
+
+	FCardStats* FindCard(const FTCG_CardHandle Handle);
+	const FCardStats* ReadCard(const FTCG_CardHandle Handle);
+	void MarkDirty(const int32 Index);
+	void AddContribution(const int32 Index, const int32 EffectId);
+	void RemoveContribution(const int32 Index, const int32 EffectId);
+	void CountChange();
+
+	void Recompute(FCardStats& Card);
+	// ignores the contribution lists and scans every effect
+	void ComputeFull(const int32 Index, int32& OutAttack, int32& OutHitPoint) const;
+	// EffectIds sorted ascending, within a layer older effects apply first
+	void ApplyLayers(TArrayView<const int32> EffectIds, 
+		int32& InOutAttack, int32& InOutHitPoint) const;
+
+	TArray<FCardStats, FTCG_ArenaAllocator> Cards;
+	int32 RegisteredNum = 0;
+	FTCG_ZoneIndex* ZoneIndex = nullptr;
+	TArray<int32> DirtyIndices;
+
+	// RefreshAuras scratch, kept so zone moves don't allocate
+	FTCG_CardBitset AuraMatches;
+	FTCG_CardBitset AuraChanged;
+	FTCG_CardBitset AuraLeft;
+	TMap<int32, FEffect> Effects;
+	int32 NextEffectId = 1;
+
+	FTCG_StatLayerStats Stats;
+};
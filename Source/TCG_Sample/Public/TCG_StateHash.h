@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_ZoneQuery.h"
+
+enum class ETCG_HashKey : uint8
+{
+	CardIdentity,
+	CardZone,
+	Hitpoint,
+	VoidDrawCount,
+	GamePhase,
+	Num,
+};
+
+/**
+ * Zobrist style hash of the match state, each (key, slot, value) maps to
+ * a pseudo random 64 bit word and a mutation XORs the old word out and the
+ * new one in, so updates are O(1) and the result doesn't depend on order.
+ * Split in one partition per player plus a shared one, since a client
+ * can only vouch for its own cards and the public state. Each partition
+ * keeps one word per key, so a check can leave out state the client only
+ * gets through unordered replication.
+ */
+class TCG_SAMPLE_API FTCG_StateHash
+{
+public:
+	static constexpr int32 SharedPartition = FTCG_ZoneIndex::MaxPlayers;
+	static constexpr int32 PartitionNum = FTCG_ZoneIndex::MaxPlayers + 1;
+	static constexpr int32 KeyNum = static_cast<int32>(ETCG_HashKey::Num);
+	static constexpr uint32 AllKeys = (1u << KeyNum) - 1;
+	// what the owner receives in order with the phase change outside lockstep,
+	// card moves come by reliable RPC, hitpoints and void draws don't
+	static constexpr uint32 MirroredKeys = 
+		(1u << static_cast<int32>(ETCG_HashKey::CardIdentity)) |
+		(1u << static_cast<int32>(ETCG_HashKey::CardZone));
+
+	void Reset();
+
+	void Toggle(const int32 Partition, const ETCG_HashKey Key, const int32 Slot, 
+		const int32 Value);
+	void Update(const int32 Partition, const ETCG_HashKey Key, const int32 Slot,
+		const int32 OldValue, const int32 NewValue);
+
+	uint64 Get(const int32 Partition, const uint32 KeyMask = AllKeys) const;
+	// shared state plus everything the player owns
+	uint64 GetPlayerView(const int32 PlayerIndex, const uint32 KeyMask = AllKeys) const;
+
+	// recent mutations, to find where two peers started to disagree
+	void Dump(const FString& Context) const;
+
+	static uint64 MakeKey(const ETCG_HashKey Key, const int32 Slot, const int32 Value);
+
+private:
+	struct FMutation
+	{
+		ETCG_HashKey Key = ETCG_HashKey::CardZone;
+		int32 Partition = 0;
+		int32 Slot = 0;
+		int32 Value = 0;
+		uint64 Result = 0;
+	};
+
+	static constexpr int32 RecentNum = 64;
+
+	uint64 Partitions[PartitionNum][KeyNum] = {};
+	TArray<FMutation> Recent;
+	int32 RecentHead = 0;
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include <type_traits>
+
+// records a typed event in this thread's ring buffer while a trace runs,
+// {0}, {1}.. in the format pick the fields when the trace is decoded
+#define TCG_TRACE(EventName, Format, ...) \
+	do \
+	{ \
+		if (FTCG_TraceLog::IsRunning()) \
+		{ \
+			static const uint16 TCG_TraceEventId = \
+				FTCG_TraceLog::RegisterEvent(TEXT(#EventName), TEXT(Format)); \
+			FTCG_TraceLog::Write(TCG_TraceEventId, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+enum class ETCG_TraceField : uint8
+{
+	None,
+	Int,
+	Float,
+	Name
+};
+
+// fixed size so the ring buffer never allocates, names are resolved when flushed
+struct FTCG_TraceRecord
+{
+	static constexpr int32 MaxFields = 4;
+
+	union FField
+	{
+		int64 Int;
+		double Float;
+	};
+
+	uint64 Cycles = 0;
+	uint16 EventId = 0;
+	ETCG_TraceField FieldTypes[MaxFields] = {};
+	FField Fields[MaxFields] = {};
+
+	template <typename T>
+	void SetField(const int32 Index, const T& Value)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			FieldTypes[Index] = ETCG_TraceField::Float;
+			Fields[Index].Float = Value;
+		}
+		else if constexpr (std::is_same_v<T, FName>)
+		{
+			FieldTypes[Index] = ETCG_TraceField::Name;
+			Fields[Index].Int = PackName(Value);
+		}
+		else
+		{
+			static_assert(std::is_integral_v<T> || std::is_enum_v<T>,
+				"Trace fields are integers, enums, floats or names");
+			FieldTypes[Index] = ETCG_TraceField::Int;
+			Fields[Index].Int = static_cast<int64>(Value);
+		}
+	}
+
+	static int64 PackName(const FName Name)
+	{
+		return (static_cast<int64>(Name.GetDisplayIndex().ToUnstableInt()) << 32) |
+			static_cast<uint32>(Name.GetNumber());
+	}
+
+	static FName UnpackName(const int64 Packed)
+	{
+		return FName::CreateFromDisplayId(
+			FNameEntryId::FromUnstableInt(static_cast<uint32>(Packed >> 32)),
+			static_cast<int32>(static_cast<uint32>(Packed)));
+	}
+};
+
+/**
+ * Binary event log for hot paths. A write copies the raw fields into a
+ * lock free ring buffer owned by the calling thread, a background thread
+ * drains the buffers into a .tcgtrace file and formatting only happens
+ * when the file is decoded. Records are dropped, and counted, when a
+ * buffer is full rather than blocking the game thread.
+ *
+ * tcg.Trace.Start [path], tcg.Trace.Stop, tcg.Trace.Decode <path> [out],
+ * or -TCGTrace on the command line to trace the whole run.
+ */
+struct TCG_SAMPLE_API FTCG_TraceLog
+{
+	// empty path writes to Saved/Logs
+	static bool Start(const FString& Path = FString());
+	static void Stop();
+
+	static bool IsRunning() { return bRunning.load(std::memory_order_relaxed); }
+
+	// same name returns the same id, called once per call site
+	static uint16 RegisterEvent(const TCHAR* Name, const TCHAR* Format);
+
+	template <typename... ArgTypes>
+	static void Write(const uint16 EventId, const ArgTypes&... Args)
+	{
+		static_assert(sizeof...(Args) <= FTCG_TraceRecord::MaxFields, "Too many trace fields");
+
+		FTCG_TraceRecord Record;
+		Record.EventId = EventId;
+		int32 Index = 0;
+		(Record.SetField(Index++, Args), ...);
+		Push(Record);
+	}
+
+	// writes the text log next to the trace when no output path is given
+	static bool Decode(const FString& Path, const FString& OutPath = FString());
+
+private:
+	static void Push(FTCG_TraceRecord& Record);
+
+	static std::atomic<bool> bRunning;
+};
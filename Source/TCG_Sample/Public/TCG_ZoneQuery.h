@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TCG_CardBitset.h"
+#include "TCG_Definitions.h"
+
+struct FTCG_CardEntry;
+class FTCG_StatLayers;
+
+/**
+ * Membership bitsets for every card of a match, one per zone and owner
+ * plus one per attribute value. Bit positions are FTCG_CardHandle indices.
+ * Capacity is fixed at Init so compiled queries can point into the bitsets.
+ * Each owner gets its own handle range, so peers registering the decks in
+ * a different order still agree on every handle.
+ */
+class TCG_SAMPLE_API FTCG_ZoneIndex
+{
+public:
+	static constexpr int32 MaxPlayers = 2;
+	// stats at or above the last bucket share it, queries re-check those exactly
+	static constexpr int32 NumStatBuckets = 16;
+
+	void Init(const int32 InMaxCards);
+
+	FTCG_CardHandle Register(const FTCG_CardEntry& Entry, const int32 OwnerIndex, 
+		const ECardZone Zone);
+	void MoveCard(const FTCG_CardHandle Handle, const ECardZone Zone);
+	void SetStats(const FTCG_CardHandle Handle, const int32 Attack, const int32 HitPoint);
+	void Reset();
+
+	// layered stats are pushed into the buckets when a query reads them
+	void SetStatLayers(FTCG_StatLayers* InStatLayers) { StatLayers = InStatLayers; };
+	void FlushPendingStats() const;
+
+	int32 Num() const { return CardNum; };
+	bool IsRegistered(const FTCG_CardHandle Handle) const { return All.Contains(Handle.Index); };
+	int32 GetCapacity() const { return All.Num(); };
+	ECardZone GetZone(const FTCG_CardHandle Handle) const { return Zones[Handle.Index]; };
+	int32 GetOwner(const FTCG_CardHandle Handle) const { return Owners[Handle.Index]; };
+	int32 GetCardId(const FTCG_CardHandle Handle) const { return CardIds[Handle.Index]; };
+	int32 GetAttack(const FTCG_CardHandle Handle) const { return Attacks[Handle.Index]; };
+	int32 GetHitPoint(const FTCG_CardHandle Handle) const { return HitPoints[Handle.Index]; };
+
+	const FTCG_CardBitset& GetAll() const { return All; };
+	const FTCG_CardBitset& GetZoneBits(const ECardZone Zone) const;
+	// OwnerIndex must be within [0, MaxPlayers)
+	const FTCG_CardBitset& GetOwnerBits(const int32 OwnerIndex) const;
+	const FTCG_CardBitset& GetCardTypeBits(const ECardType CardType) const;
+	const FTCG_CardBitset& GetRarityBits(const ERarity Rarity) const;
+	const FTCG_CardBitset& GetManaTypeBits(const EManaType ManaType) const;
+	// cards with attack/hitpoint >= the bucket's value
+	const FTCG_CardBitset& GetAttackAtLeast(const int32 Value) const;
+	const FTCG_CardBitset& GetHitPointAtLeast(const int32 Value) const;
+
+	static int32 ToBucket(const int32 Value);
+
+private:
+	void SetStatBits(TArray<FTCG_CardBitset, FTCG_ArenaAllocator>& Buckets, const int32 Index, const int32 Value);
+
+	int32 CardNum = 0;
+	int32 OwnerCardNums[MaxPlayers] = {};
+	FTCG_CardBitset All;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> ByZone;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> ByOwner;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> ByCardType;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> ByRarity;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> ByManaType;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> AttackAtLeast;
+	TArray<FTCG_CardBitset, FTCG_ArenaAllocator> HitPointAtLeast;
+
+	TArray<ECardZone, FTCG_ArenaAllocator> Zones;
+	TArray<int32, FTCG_ArenaAllocator> Owners;
+	TArray<int32, FTCG_ArenaAllocator> CardIds;
+	TArray<int32, FTCG_ArenaAllocator> Attacks;
+	TArray<int32, FTCG_ArenaAllocator> HitPoints;
+
+	FTCG_StatLayers* StatLayers = nullptr;
+};
+
+/**
+ * Card filter for targeting and effects, built fluently or parsed from
+ * text such as "zone:board owner:1 type:minion mana:fire attack>=3".
+ * Terms are AND-ed, repeating a key within one facet ORs the values.
+ */
+class TCG_SAMPLE_API FTCG_CardQuery
+{
+public:
+	FTCG_CardQuery& InZone(const ECardZone Zone);
+	FTCG_CardQuery& OwnedBy(const int32 OwnerIndex);
+	FTCG_CardQuery& OfType(const ECardType CardType);
+	FTCG_CardQuery& OfRarity(const ERarity Rarity);
+	FTCG_CardQuery& WithManaType(const EManaType ManaType);
+	FTCG_CardQuery& AttackAtLeast(const int32 Value);
+	FTCG_CardQuery& AttackAtMost(const int32 Value);
+	FTCG_CardQuery& HitPointAtLeast(const int32 Value);
+	FTCG_CardQuery& HitPointAtMost(const int32 Value);
+
+	static bool Parse(const FString& Text, FTCG_CardQuery& OutQuery, FString& OutError);
+
+private:
+	friend class FTCG_CompiledQuery;
+
+	TArray<ECardZone> Zones;
+	TArray<int32> OwnerIndices;
+	TArray<ECardType> CardTypes;
+	TArray<ERarity> Rarities;
+	TArray<EManaType> ManaTypes;
+	int32 MinAttack = 0;
+	int32 MaxAttack = MAX_int32;
+	int32 MinHitPoint = 0;
+	int32 MaxHitPoint = MAX_int32;
+};
+
+/**
+ * A query lowered to terms over one zone index, each term an OR of live 
+ * bitsets, optionally negated. Evaluation ANDs the terms word by word,
+ * 64 cards at a time, so results follow zone moves without recompiling.
+ * Recompile after the index is re-initialized.
+ */
+class TCG_SAMPLE_API FTCG_CompiledQuery
+{
+public:
+	FTCG_CompiledQuery() = default;
+	FTCG_CompiledQuery(const FTCG_CardQuery& Query, const FTCG_ZoneIndex& Index);
+
+	// false when the query names an owner outside the index, it matches nothing
+	bool IsValid() const { return Index && !bInvalid; };
+	bool Matches(const FTCG_CardHandle Handle) const;
+	void Evaluate(FTCG_CardBitset& OutResult) const;
+	int32 Count() const;
+
+	template <typename FunctionType>
+	void ForEachMatch(FunctionType&& Function) const
+	{
+		FTCG_CardBitset Result;
+		Evaluate(Result);
+		Result.ForEachSetBit([&Function](const int32 Index)
+			{
+				FTCG_CardHandle Handle;
+				Handle.Index = Index;
+				Function(Handle);
+			});
+	}
+
+private:
+	struct FTerm
+	{
+		TArray<const FTCG_CardBitset*, TInlineAllocator<4>> AnyOf;
+		bool bNegate = false;
+
+		uint64 GetWord(const int32 WordIndex) const
+		{
+			uint64 Word = 0;
+			for (const FTCG_CardBitset* Bits : AnyOf)
+			{
+				Word |= Bits->GetWords()[WordIndex];
+			}
+			return bNegate ? ~Word : Word;
+		}
+	};
+
+	void AddTerm(const FTCG_CardBitset& Bits, const bool bNegate = false);
+	uint64 FilterTopBucket(const int32 WordIndex, uint64 Word) const;
+	bool PassesExactStats(const int32 CardIndex) const;
+	template <typename ValueType, typename GetterType>
+	void AddFacet(const TArray<ValueType>& Values, GetterType&& Getter);
+
+	const FTCG_ZoneIndex* Index = nullptr;
+	TArray<FTerm> Terms;
+	bool bEmpty = false;
+	bool bInvalid = false;
+	// reads attack/hitpoint buckets, pending stat changes get flushed first
+	bool bReadsStats = false;
+	// bounds past the last bucket, cards in it are checked against exact stats
+	bool bRecheckAttack = false;
+	bool bRecheckHitPoint = false;
+	int32 MinAttack = 0;
+	int32 MaxAttack = MAX_int32;
+	int32 MinHitPoint = 0;
+	int32 MaxHitPoint = MAX_int32;
+};
@@ -7,22 +7,35 @@ public class TCG_Sample : ModuleRules
 	public TCG_Sample(ReadOnlyTargetRules Target) : base(Target)
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// dedicated servers don't present anything, tweens snap to their end
+		bool bWithCosmetics = Target.Type != TargetType.Server;
+		PublicDefinitions.Add("TCG_WITH_COSMETICS=" + (bWithCosmetics ? "1" : "0"));
 	
 		PublicDependencyModuleNames.AddRange(new string[] { 
 			"Core", "CoreUObject", 
 			"Engine", "InputCore", 
-			"EnhancedInput", "TweenMaker"
+			"EnhancedInput"
 		});
 
 		PrivateDependencyModuleNames.AddRange(new string[] {  });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { 
-			"Slate", "SlateCore"
-		});
+		if (bWithCosmetics)
+		{
+			PublicDependencyModuleNames.Add("TweenMaker");
+
+			PrivateDependencyModuleNames.AddRange(new string[] { 
+				"Slate", "SlateCore"
+			});
+		}
 		
 		// Uncomment if you are using online features
-		PrivateDependencyModuleNames.AddRange(new string[] { 
-			"OnlineSubsystem", "OnlineSubsystemSteam"
-		});
+		PrivateDependencyModuleNames.Add("OnlineSubsystem");
+
+		// steam is the players' platform, servers fall back to the ip net driver
+		if (Target.Type != TargetType.Server)
+		{
+			PrivateDependencyModuleNames.Add("OnlineSubsystemSteam");
+		}
 	}
 }